@@ -37,6 +37,9 @@ let host = "";
 })();
 
 var response = null;
+// the status merged from SSE status events, and the version of the last one
+var apiStatus = null;
+var statusVersion = 0;
 var x = null;
 
 /****
@@ -193,7 +196,20 @@ function requestServerSentEvents() {
 
     evtSource.onmessage = (event) => {
         const data = JSON.parse(event.data);
-        response = data.apiStatus;
+
+        if (data.apiStatus) {
+            apiStatus = data.apiStatus;
+        } else if (apiStatus && data.version === statusVersion + 1) {
+            Object.assign(apiStatus, data.apiDelta);
+        } else {
+            // an event was missed, so the delta can't be applied -- ask for
+            // the full status, which will come as the next event
+            getUrl("/sse/full", () => {});
+            return;
+        }
+
+        statusVersion = data.version;
+        response = apiStatus;
         updateStatusToUI();
     };
 
@@ -212,6 +228,40 @@ function requestServerSentEvents() {
     }
 }
 
+/**
+ * addZoneButtons()
+ * 
+ * index.html has buttons for zones 1 - 7.  A controller built with chained
+ * shift registers can have more zones than that, so the missing buttons are
+ * added to the zones and schedule views, copied from the zone 1 buttons.
+ */
+function addZoneButtons(numZones) {
+    const offCol = dqs("#zones_view button[data-value='off']").parentElement;
+    const clearBtn = dqs("#schedule_view .clr_btn");
+    // the next zone needing a button: there is one per zone plus "off"
+    let zone = dqsa("#zones_view button[data-value]").length;
+
+    for (; zone <= numZones; zone++) {
+        let col = dqs("#zones_view button[data-value='1']").parentElement.cloneNode(true);
+        let btn = col.querySelector("button");
+
+        btn.dataset.value = zone;
+        btn.innerText = zone;
+        btn.classList.replace("btn-success", "btn-primary");
+        btn.addEventListener('click', zoneButtonClick);
+        offCol.before(col);
+
+        btn = dqs("#schedule_view .zn_btn").cloneNode(true);
+        btn.innerText = zone;
+        btn.classList.remove("btn-info");
+        btn.addEventListener('click', function (event) {
+            event.preventDefault();
+            this.classList.add("btn-info");
+        });
+        clearBtn.before(btn);
+    }
+}
+
 /**
  * updateStatusToUI()
  * 
@@ -221,7 +271,8 @@ function requestServerSentEvents() {
  * the /status API in order to get fresh data.
  * 
  * This function is invoked when a Server Sent Event is received, as configured in
- * requestServerSentEvents().
+ * requestServerSentEvents().  Status events after the first only carry the
+ * members that changed, which are merged into apiStatus before this is invoked.
  */
 function updateStatusToUI() {
     if (!response) {
@@ -241,6 +292,7 @@ function updateStatusToUI() {
         system_title.innerText = `${response.hostname} Controls`;
     }
     head_title.innerText = response.hostname;
+    addZoneButtons(response.numZones);
 
     if (response.currCycle) {
         div_display_panel_1.innerText = "Current cycle: " + response.currCycle;
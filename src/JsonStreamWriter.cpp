@@ -0,0 +1,179 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <JsonStreamWriter.hpp>
+
+JsonStreamWriter& JsonStreamWriter::beginObject() {
+    separate();
+    put('{');
+    depth++;
+    hasItems &= ~(1UL << depth);
+    objects |= (1UL << depth);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::beginArray() {
+    separate();
+    put('[');
+    depth++;
+    hasItems &= ~(1UL << depth);
+    objects &= ~(1UL << depth);
+    return *this;
+}
+
+// closes the innermost object or array
+JsonStreamWriter& JsonStreamWriter::end() {
+    if (depth > 0) {
+        put((objects & (1UL << depth)) ? '}' : ']');
+        depth--;
+    }
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::key(const char* name) {
+    separate();
+    putString(name);
+    write(": ", 2);
+    afterKey = true;
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::value(const char* s) {
+    separate();
+    putString(s);
+    return *this;
+}
+
+void JsonStreamWriter::putString(const char* s) {
+    put('"');
+
+    for (; *s; s++) {
+        char c = *s;
+
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put(c);
+        } else if ((uint8_t)c < 0x20) {
+            char esc[7];
+
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)c);
+            write(esc, 6);
+        } else {
+            put(c);
+        }
+    }
+
+    put('"');
+}
+
+JsonStreamWriter& JsonStreamWriter::value(bool b) {
+    separate();
+    return (b) ? write("true", 4) : write("false", 5);
+}
+
+JsonStreamWriter& JsonStreamWriter::value(long n) {
+    char s[24];
+
+    separate();
+    return write(s, snprintf(s, sizeof(s), "%ld", n));
+}
+
+JsonStreamWriter& JsonStreamWriter::value(unsigned long n) {
+    char s[24];
+
+    separate();
+    return write(s, snprintf(s, sizeof(s), "%lu", n));
+}
+
+JsonStreamWriter& JsonStreamWriter::value(unsigned long long n) {
+    char s[24];
+
+    separate();
+    return write(s, snprintf(s, sizeof(s), "%llu", n));
+}
+
+JsonStreamWriter& JsonStreamWriter::nullValue() {
+    separate();
+    return write("null", 4);
+}
+
+/**
+ * JsonStreamWriter::members()
+ *
+ * Adds one or more members that are already rendered as JSON (without the
+ * braces) to the current object, e.g. "\"a\": 1, \"b\": 2".
+ */
+JsonStreamWriter& JsonStreamWriter::members(const char* json) {
+    if (*json) {
+        separate();
+        write(json);
+    }
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::write(const char* s) {
+    return write(s, strlen(s));
+}
+
+JsonStreamWriter& JsonStreamWriter::write(const char* s, size_t n) {
+    while (n > 0) {
+        size_t room = sizeof(buff) - len;
+        size_t chunk = (n < room) ? n : room;
+
+        memcpy(buff + len, s, chunk);
+        len += chunk;
+        s += chunk;
+        n -= chunk;
+
+        if (len == sizeof(buff)) {
+            flush();
+        }
+    }
+    return *this;
+}
+
+void JsonStreamWriter::flush() {
+    if (len > 0) {
+        sink(buff, len);
+        len = 0;
+    }
+}
+
+/**
+ * JsonStreamWriter::separate()
+ *
+ * Writes the comma that goes ahead of every item of an object or array but
+ * the first.  The value that follows a key is part of the key's item.
+ */
+void JsonStreamWriter::separate() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+
+    if (hasItems & (1UL << depth)) {
+        write(", ", 2);
+    }
+    hasItems |= (1UL << depth);
+}
+
+void JsonStreamWriter::put(char c) {
+    buff[len++] = c;
+
+    if (len == sizeof(buff)) {
+        flush();
+    }
+}
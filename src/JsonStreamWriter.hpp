@@ -0,0 +1,87 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+/**
+ * JsonStreamWriter
+ *
+ * Writes JSON a piece at a time into a small fixed buffer that is handed to
+ * a sink whenever it fills up (and by flush()), so a response of any size
+ * takes the same JSON_STREAM_BUFFER bytes of RAM.  The sink is typically
+ * SprinklerWebServer::sendContent() of a chunked response, or the SSE client.
+ *
+ * The writer keeps track of the commas, so a document is written as a
+ * sequence of calls:
+ *
+ *      json.beginObject();
+ *      json.key("status").value("ok");
+ *      json.key("on").beginArray().value(1).value(3).end();
+ *      json.end();
+ *
+ * which writes {"status": "ok", "on": [1, 3]}.  Members that were already
+ * rendered elsewhere (e.g. a cached "a": 1, "b": 2) can be added with
+ * members().  Nothing is validated; nesting deeper than 32 levels is not
+ * supported.
+ */
+
+#ifndef JSON_STREAM_BUFFER
+#define JSON_STREAM_BUFFER 256
+#endif
+
+class JsonStreamWriter {
+    public:
+        typedef std::function<void(const char* data, size_t len)> Sink_t;
+
+        JsonStreamWriter(Sink_t sink): sink(sink) {}
+        ~JsonStreamWriter() { flush(); }
+
+        JsonStreamWriter& beginObject();
+        JsonStreamWriter& beginArray();
+        JsonStreamWriter& end();
+        JsonStreamWriter& key(const char* name);
+        JsonStreamWriter& value(const char* s);
+        JsonStreamWriter& value(const String& s) { return value(s.c_str()); }
+        JsonStreamWriter& value(bool b);
+        JsonStreamWriter& value(int n) { return value((long)n); }
+        JsonStreamWriter& value(unsigned int n) { return value((unsigned long)n); }
+        JsonStreamWriter& value(long n);
+        JsonStreamWriter& value(unsigned long n);
+        JsonStreamWriter& value(unsigned long long n);
+        JsonStreamWriter& nullValue();
+        JsonStreamWriter& members(const char* json);
+        // writes s exactly as it is (for responses that aren't JSON)
+        JsonStreamWriter& write(const char* s);
+        JsonStreamWriter& write(const char* s, size_t len);
+        void flush();
+
+    private:
+        Sink_t sink;
+        char buff[JSON_STREAM_BUFFER];
+        size_t len = 0;
+        uint8_t depth = 0;
+        // one bit per nesting level
+        uint32_t hasItems = 0;
+        uint32_t objects = 0;
+        bool afterKey = false;
+
+        void separate();
+        void put(char c);
+        void putString(const char* s);
+};
@@ -8,8 +8,11 @@
 #pragma once
 
 #include <Arduino.h>
+#include "ShiftRegisterTransport.h"
 
-template<uint8_t Size>
+// Transport is the policy that gets the values out to the chips (see
+// ShiftRegisterTransport.h); it defaults to bit-banging with shiftOut()
+template<uint8_t Size, typename Transport = ShiftRegisterBitBang>
 class ShiftRegister74HC595 
 {
 public:
@@ -26,11 +29,10 @@ public:
     void setAllLow();
     void setAllHigh(); 
     uint8_t get(const uint8_t pin);
+    Transport& transport() { return _transport; }
 
 private:
-    uint8_t _clockPin;
-    uint8_t _serialDataPin;
-    uint8_t _latchPin;
+    Transport _transport;
 
     uint8_t  _digitalValues[Size];
 };
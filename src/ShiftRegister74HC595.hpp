@@ -7,24 +7,11 @@
 
 // ShiftRegister74HC595 constructor
 // Size is the number of shiftregisters stacked in serial
-template<uint8_t Size>
-ShiftRegister74HC595<Size>::ShiftRegister74HC595(const uint8_t serialDataPin, const uint8_t clockPin, const uint8_t latchPin)
+// The transport sets up the pins
+template<uint8_t Size, typename Transport>
+ShiftRegister74HC595<Size, Transport>::ShiftRegister74HC595(const uint8_t serialDataPin, const uint8_t clockPin, const uint8_t latchPin) :
+    _transport(serialDataPin, clockPin, latchPin)
 {
-    // set attributes
-    _clockPin = clockPin;
-    _serialDataPin = serialDataPin;
-    _latchPin = latchPin;
-
-    // define pins as outputs
-    pinMode(clockPin, OUTPUT);
-    pinMode(serialDataPin, OUTPUT);
-    pinMode(latchPin, OUTPUT);
-
-    // set pins low
-    digitalWrite(clockPin, LOW);
-    digitalWrite(serialDataPin, LOW);
-    digitalWrite(latchPin, LOW);
-
     // allocates the specified number of bytes and initializes them to zero
     memset(_digitalValues, 0, Size * sizeof(uint8_t));
 
@@ -33,8 +20,8 @@ ShiftRegister74HC595<Size>::ShiftRegister74HC595(const uint8_t serialDataPin, co
 
 // Set all pins of the shift registers at once.
 // digitalVAlues is a uint8_t array where the length is equal to the number of shift registers.
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::setAll(const uint8_t * digitalValues)
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::setAll(const uint8_t * digitalValues)
 {
     memcpy( _digitalValues, digitalValues, Size);   // dest, src, size
     updateRegisters();
@@ -45,8 +32,8 @@ void ShiftRegister74HC595<Size>::setAll(const uint8_t * digitalValues)
 // For example with:
 //     const uint8_t myFlashData[] PROGMEM = { 0x0F, 0x81 };
 #ifdef __AVR__
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::setAll_P(const uint8_t * digitalValuesProgmem)
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::setAll_P(const uint8_t * digitalValuesProgmem)
 {
     PGM_VOID_P p = reinterpret_cast<PGM_VOID_P>(digitalValuesProgmem);
     memcpy_P( _digitalValues, p, Size);
@@ -56,16 +43,16 @@ void ShiftRegister74HC595<Size>::setAll_P(const uint8_t * digitalValuesProgmem)
 
 // Retrieve all states of the shift registers' output pins.
 // The returned array's length is equal to the number of shift registers.
-template<uint8_t Size>
-uint8_t * ShiftRegister74HC595<Size>::getAll()
+template<uint8_t Size, typename Transport>
+uint8_t * ShiftRegister74HC595<Size, Transport>::getAll()
 {
     return _digitalValues; 
 }
 
 // Set a specific pin to either HIGH (1) or LOW (0).
 // The pin parameter is a positive, zero-based integer, indicating which pin to set.
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::set(const uint8_t pin, const uint8_t value)
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::set(const uint8_t pin, const uint8_t value)
 {
     setNoUpdate(pin, value);
     updateRegisters();
@@ -73,36 +60,31 @@ void ShiftRegister74HC595<Size>::set(const uint8_t pin, const uint8_t value)
 
 // Updates the shift register pins to the stored output values.
 // This is the function that actually writes data into the shift registers of the 74HC595.
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::updateRegisters()
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::updateRegisters()
 {
-    for (int i = Size - 1; i >= 0; i--) {
-        shiftOut(_serialDataPin, _clockPin, MSBFIRST, _digitalValues[i]);
-    }
-    
-    digitalWrite(_latchPin, HIGH); 
-    digitalWrite(_latchPin, LOW); 
+    _transport.write(_digitalValues, Size);
 }
 
 // Equivalent to set(int pin, uint8_t value), except the physical shift register is not updated.
 // Should be used in combination with updateRegisters().
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::setNoUpdate(const uint8_t pin, const uint8_t value)
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::setNoUpdate(const uint8_t pin, const uint8_t value)
 {
     (value) ? bitSet(_digitalValues[pin / 8], pin % 8) : bitClear(_digitalValues[pin / 8], pin % 8);
 }
 
 // Returns the state of the given pin.
 // Either HIGH (1) or LOW (0)
-template<uint8_t Size>
-uint8_t ShiftRegister74HC595<Size>::get(const uint8_t pin)
+template<uint8_t Size, typename Transport>
+uint8_t ShiftRegister74HC595<Size, Transport>::get(const uint8_t pin)
 {
     return (_digitalValues[pin / 8] >> (pin % 8)) & 1;
 }
 
 // Sets all pins of all shift registers to HIGH (1).
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::setAllHigh()
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::setAllHigh()
 {
     for (int i = 0; i < Size; i++) {
         _digitalValues[i] = 255;
@@ -111,8 +93,8 @@ void ShiftRegister74HC595<Size>::setAllHigh()
 }
 
 // Sets all pins of all shift registers to LOW (0).
-template<uint8_t Size>
-void ShiftRegister74HC595<Size>::setAllLow()
+template<uint8_t Size, typename Transport>
+void ShiftRegister74HC595<Size, Transport>::setAllLow()
 {
     for (int i = 0; i < Size; i++) {
         _digitalValues[i] = 0;
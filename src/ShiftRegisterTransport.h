@@ -0,0 +1,154 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Shift register transports
+ *
+ * A transport is the policy ShiftRegister74HC595 uses to get its register
+ * values out to the chips.  Every transport is constructed from the same
+ * three pins (so the sketch doesn't change when the transport does) and
+ * provides write(), which is handed the register values (first register in
+ * the chain first) and must shift them all out and then latch them.
+ *
+ *  - ShiftRegisterBitBang: shiftOut() on any three GPIO pins (the original
+ *    behavior of the library)
+ *  - ShiftRegisterSPI: the ESP8266 hardware SPI (HSPI) peripheral, which
+ *    clocks the bytes out far faster than shiftOut().  The data and clock
+ *    pins are fixed by the hardware: SER must be wired to MOSI (D7) and
+ *    SRCLK to SCLK (D5).  Only the latch pin is used from the constructor
+ *    (main.cpp puts it on D8 for this transport).
+ *  - ShiftRegisterRecorder: drives no pins at all but records every latched
+ *    value along with the micros() it was latched at, so that host-side
+ *    tests can verify exactly how zones were switched
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <deque>
+
+class ShiftRegisterBitBang {
+    public:
+        ShiftRegisterBitBang(uint8_t serialDataPin, uint8_t clockPin, uint8_t latchPin):
+            serialDataPin(serialDataPin), clockPin(clockPin), latchPin(latchPin)
+        {
+            pinMode(clockPin, OUTPUT);
+            pinMode(serialDataPin, OUTPUT);
+            pinMode(latchPin, OUTPUT);
+
+            digitalWrite(clockPin, LOW);
+            digitalWrite(serialDataPin, LOW);
+            digitalWrite(latchPin, LOW);
+        }
+
+        void write(const uint8_t* values, uint8_t size) {
+            // the last register in the chain has to be shifted out first
+            for (int i = size - 1; i >= 0; i--) {
+                shiftOut(serialDataPin, clockPin, MSBFIRST, values[i]);
+            }
+
+            digitalWrite(latchPin, HIGH);
+            digitalWrite(latchPin, LOW);
+        }
+
+    private:
+        uint8_t serialDataPin;
+        uint8_t clockPin;
+        uint8_t latchPin;
+};
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <SPI.h>
+
+// 74HC595s are good for well over this at 3.3V, but long runs of wire to a
+// relay board are not
+#ifndef SHIFT_REGISTER_SPI_FREQUENCY
+#define SHIFT_REGISTER_SPI_FREQUENCY 4000000
+#endif
+
+class ShiftRegisterSPI {
+    public:
+        ShiftRegisterSPI(uint8_t serialDataPin, uint8_t clockPin, uint8_t latchPin):
+            latchPin(latchPin)
+        {
+            (void)serialDataPin;
+            (void)clockPin;
+
+            pinMode(latchPin, OUTPUT);
+            digitalWrite(latchPin, LOW);
+        }
+
+        void write(const uint8_t* values, uint8_t size) {
+            // SPI.begin() is deferred to the first write because this is
+            // constructed as a global, before the core is fully set up
+            if (!begun) {
+                SPI.begin();
+                begun = true;
+            }
+
+            SPI.beginTransaction(SPISettings(SHIFT_REGISTER_SPI_FREQUENCY, MSBFIRST, SPI_MODE0));
+
+            for (int i = size - 1; i >= 0; i--) {
+                SPI.transfer(values[i]);
+            }
+
+            SPI.endTransaction();
+
+            digitalWrite(latchPin, HIGH);
+            digitalWrite(latchPin, LOW);
+        }
+
+    private:
+        uint8_t latchPin;
+        bool begun = false;
+};
+#endif
+
+class ShiftRegisterRecorder {
+    public:
+        typedef struct Latch {
+            unsigned long micros;
+            uint32_t value;     // register values, first register in low byte
+        } Latch_t;
+
+        // the oldest latches are dropped beyond this many
+        static const size_t maxLatches = 256;
+
+        ShiftRegisterRecorder(uint8_t serialDataPin, uint8_t clockPin, uint8_t latchPin) {
+            (void)serialDataPin;
+            (void)clockPin;
+            (void)latchPin;
+        }
+
+        void write(const uint8_t* values, uint8_t size) {
+            uint32_t value = 0;
+
+            for (uint8_t i = 0; i < size && i < 4; i++) {
+                value |= (uint32_t)values[i] << (8 * i);
+            }
+
+            if (latches.size() == maxLatches) {
+                latches.pop_front();
+            }
+            latches.push_back({micros(), value});
+        }
+
+        const std::deque<Latch_t>& getLatches() const { return latches; }
+        void clear() { latches.clear(); }
+
+    private:
+        std::deque<Latch_t> latches;
+};
@@ -16,8 +16,11 @@
 
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
-#include <uri/UriBraces.h>
 #include <SprinklerAPI.hpp>
+// the UI built into the firmware, if the build made one
+#if __has_include(<UiBundle.h>)
+#include <UiBundle.h>
+#endif
 #include <stdio.h>
 #include <ctime>
 
@@ -68,12 +71,12 @@ const char* cycleTypeNames[] = {
  * Utility implementations
  ****************************************************************************/
 
-const String bitFieldtoString(uint8_t bitField) {
+const String bitFieldtoString(uint32_t bitField) {
     String s;
     bool multiple = false;
 
-    for (uint8_t i = 0; i < 8; i++) {
-        if (bitField & (1 << i)) {
+    for (uint8_t i = 0; i < 32; i++) {
+        if (bitField & (1UL << i)) {
             s += ((multiple) ? "," : "") + String(i + 1);
             multiple = true;
         }
@@ -82,14 +85,26 @@ const String bitFieldtoString(uint8_t bitField) {
     return s;
 }
 
-void loadBitFieldToJsonArray(uint8_t bitField, JsonArray& a) {
-    for (uint8_t i=0; i < 8; i++) {
-        if (bitField & (1 << i)) {
+void loadBitFieldToJsonArray(uint32_t bitField, JsonArray& a) {
+    for (uint8_t i=0; i < 32; i++) {
+        if (bitField & (1UL << i)) {
             a.add(i + 1);
         }
     }
 }
 
+void writeBitFieldAsJsonArray(JsonStreamWriter& json, uint32_t bitField) {
+    json.beginArray();
+
+    for (uint8_t i=0; i < 32; i++) {
+        if (bitField & (1UL << i)) {
+            json.value(i + 1);
+        }
+    }
+
+    json.end();
+}
+
 unsigned long getMidnightEpoch(NTPClient timeClient) {
     // now in seconds since 1/01/1970
     unsigned long nowEpoch = timeClient.getEpochTime();
@@ -135,15 +150,20 @@ BitMaskItem_t::BitMaskItem(JsonArray zones) {
     status = ok;
 
     for (uint8_t z : zones) {
-        bitMask |= 1 << (z - 1);
+        if (z < 1 || z > MAX_ZONES) {
+            bitMask = 0;
+            status = error;
+            return;
+        }
+        bitMask |= (ZoneMask_t)1 << (z - 1);
     }
 }
 
 BitMaskItem_t BitMaskItem_t::allZonesOn(uint8_t zoneCount) {
-    uint8_t bitMask = 0;
+    ZoneMask_t bitMask = 0;
 
     for (uint8_t z = 0; z < zoneCount; z++) {
-        bitMask |= 1 << z;
+        bitMask |= (ZoneMask_t)1 << z;
     }
     return BitMaskItem_t(bitMask);
 }
@@ -178,8 +198,8 @@ const String ScheduleItem::asString(float adj) const {
     // convert bitMask into a string like "2:6" where a colon delimits
     // multiple zones to turn on simultaneously
 
-    for (uint8_t z = 1; z <= 8; z++) {
-        if (bitMask & (1 << (z - 1))) {
+    for (uint8_t z = 1; z <= MAX_ZONES; z++) {
+        if (bitMask & ((ZoneMask_t)1 << (z - 1))) {
             if (++items > 1) {
                 s += ',';
             }
@@ -201,16 +221,21 @@ const String ScheduleItem::asString(float adj) const {
  * jsonArrayToBitField()
  * 
  * Utility function to convert a JSON array of integers into a a single
- * 8-bit bit field value.  For example, [1,2,3] = 7 where bits 1, 2 and 3
+ * bit field value.  For example, [1,2,3] = 7 where bits 1, 2 and 3
  * are flipped on — 0b00000111.  It is intended for use by the
  * fromJsonObject() method below for converting days of the week and
- * zone numbers into single 8-bit field values.
+ * zone numbers into single bit field values (uint8_t for days, ZoneMask_t
+ * for zones).  Values outside of 1 - 32 are ignored.
  */
-uint8_t jsonArrayToBitField(const JsonArray& ja) {
-    uint8_t bitField = 0;
+uint32_t jsonArrayToBitField(const JsonArray& ja) {
+    uint32_t bitField = 0;
 
     for (JsonVariant v : ja) {
-        bitField |= 1 << (v.as<uint8_t>() - 1);
+        uint8_t n = v.as<uint8_t>();
+
+        if (n >= 1 && n <= 32) {
+            bitField |= 1UL << (n - 1);
+        }
     }
 
     return bitField;
@@ -264,8 +289,8 @@ CycleItem CycleItem_t::fromJsonObject(JsonObject& jo) {
         // Serial.printf("jsi=%s\n", tmp);
 
         ci.scheduleItems.emplace_back(
-            jsonArrayToBitField(jsi[0].as<JsonArray>()), 
-            jsi[1]
+            (ZoneMask_t)jsonArrayToBitField(jsi[0].as<JsonArray>()), 
+            jsi[1].as<uint8_t>()
         );
     }
 
@@ -317,7 +342,7 @@ CycleItem CycleItem_t::fromJsonString(String& s) {
  * I don't know if reserving on an 8-byte boundary is useful, but that is the
  * value I chose for reserve() below.
  */
-String CycleItem_t::asString() {
+String CycleItem_t::asString() const {
     String s((char *)0);
     
         if (!s.reserve(144)) {
@@ -349,7 +374,7 @@ String CycleItem_t::asString() {
     if (!scheduleItems.empty()) {
         bool first = true;
 
-        for (ScheduleItem_t& si : scheduleItems) {
+        for (const ScheduleItem_t& si : scheduleItems) {
             if (!first) s += ",";
             s += si.asString();
             first = false;
@@ -374,47 +399,193 @@ String CycleItem_t::asString() {
     }, ...
  */
 
-String CycleItem_t::asJsonString() {
-    DynamicJsonDocument doc(1024);
+void CycleItem_t::writeJson(JsonStreamWriter& json) const {
+    json.beginObject();
+    json.key("name").value(cycleName);
+    json.key("type").value(cycleTypeNames[cycleType]);
+    json.key("days");
+    writeBitFieldAsJsonArray(json, daysBitField);
+    json.key("first").value(firstTimeDelay);
+    json.key("hour").value(startHour);
+    json.key("min").value(startMin);
+    json.key("count").value(cycleCount);
+    json.key("schedule").beginArray();
+
+    for (const ScheduleItem_t& si : scheduleItems) {
+        json.beginArray();
+        writeBitFieldAsJsonArray(json, si.bitMask);
+        json.value(si.runTime);
+        json.end();
+    }
+
+    json.end();
+    json.end();
+}
 
-    doc["name"] = cycleName;
-    doc["type"] = cycleTypeNames[cycleType];
+/**
+ * CycleItem_t::toJournal()
+ * 
+ * Writes the cycle into a journalCycle record:  the name, then type, days,
+ * first, hour, min and count as one byte each, then the number of schedule
+ * items and the zones (varint) and run time of each.
+ */
+void CycleItem_t::toJournal(JournalRecord_t& rec) const {
+    rec.putString(cycleName)
+        .putByte(cycleType)
+        .putByte(daysBitField)
+        .putByte(firstTimeDelay)
+        .putByte(startHour)
+        .putByte(startMin)
+        .putByte(cycleCount)
+        .putByte((uint8_t)scheduleItems.size());
+
+    for (const ScheduleItem_t& si : scheduleItems) {
+        rec.putVarint(si.bitMask).putByte(si.runTime);
+    }
+}
 
-    JsonArray days = doc.createNestedArray("days");
-    loadBitFieldToJsonArray(daysBitField, days);
+/**
+ * CycleItem_t::fromJournal()
+ * 
+ * Reads a cycle written by toJournal().  Returns false if the record is
+ * short.
+ */
+bool CycleItem_t::fromJournal(JournalRecord_t& rec, CycleItem& ci) {
+    uint8_t type;
+    uint8_t count;
+
+    if (!rec.getString(ci.cycleName, sizeof(ci.cycleName)) ||
+        !rec.getByte(type) ||
+        !rec.getByte(ci.daysBitField) ||
+        !rec.getByte(ci.firstTimeDelay) ||
+        !rec.getByte(ci.startHour) ||
+        !rec.getByte(ci.startMin) ||
+        !rec.getByte(ci.cycleCount) ||
+        !rec.getByte(count)) {
+        return false;
+    }
 
-    doc["first"] = firstTimeDelay;
-    doc["hour"] = startHour;
-    doc["min"] = startMin;
-    doc["count"] = cycleCount;
+    ci.cycleType = (type < invalidCycleType) ? (CycleType_t)type : invalidCycleType;
 
-    JsonArray schedule = doc.createNestedArray("schedule");
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t zones;
+        uint8_t runTime;
 
-    for (ScheduleItem_t si : scheduleItems) {
-        JsonArray item = schedule.createNestedArray();
-        JsonArray zones = item.createNestedArray();
-        loadBitFieldToJsonArray(si.bitMask, zones);
-        item.add(si.runTime);
+        if (!rec.getVarint(zones) || !rec.getByte(runTime)) {
+            return false;
+        }
+        ci.scheduleItems.emplace_back((ZoneMask_t)zones, runTime);
     }
 
-    String s((char *)0);
-    
-    if (!s.reserve(doc.size())) {
-        return String("\"error\"");
+    return true;
+}
+
+/*****************************************************************************
+ * SseSubscriber implementations
+ ****************************************************************************/
+
+// marks where an event starts, so that it can be dropped as a whole
+void SseSubscriber_t::beginEvent() {
+    eventStart = buffLen;
+    eventDropped = false;
+    eventSpills = queued() == 0;
+}
+
+// queues data for the client; the event is dropped if it doesn't fit,
+// unless it may spill (and the heap has room for it)
+void SseSubscriber_t::write(const char* data, size_t len) {
+    if (!active || eventDropped) {
+        return;
     }
 
-    serializeJson(doc, s);
+    if (spill.length() == 0 && len <= sizeof(buff) - buffLen) {
+        memcpy(buff + buffLen, data, len);
+        buffLen += len;
+        return;
+    }
 
-    if (doc.overflowed()) {
-        Serial.printf(
-            "\n***** Error: DynamicJsonDocument overflowed "
-            "in CycleItem_t::asJsonString()\n"
-            "doc.capacity()=%zu\n\n",
-            doc.capacity()
-        );
+    if (eventSpills && spill.concat(data, len)) {
+        return;
     }
 
-    return s;
+    // a spill that is there already belongs to an event before this one
+
+    if (eventSpills) {
+        spill = String();
+    }
+    buffLen = eventStart;
+    eventDropped = true;
+}
+
+// true if the whole event was queued
+bool SseSubscriber_t::endEvent() {
+    eventStart = buffLen;
+
+    if (eventDropped) {
+        eventDropped = false;
+        drops++;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * SseSubscriber_t::drain()
+ * 
+ * Sends as much of the buffer as the connection takes without blocking.
+ * Returns false if the connection is gone or has stalled.
+ */
+bool SseSubscriber_t::drain() {
+    if (!client.connected()) {
+        return false;
+    }
+
+    if (spill.length() > 0 && buffLen < sizeof(buff)) {
+        size_t n = std::min(sizeof(buff) - buffLen, (size_t)spill.length());
+
+        memcpy(buff + buffLen, spill.c_str(), n);
+        buffLen += n;
+        eventStart = buffLen;
+
+        if (n == spill.length()) {
+            spill = String();
+        } else {
+            spill.remove(0, n);
+        }
+    }
+
+    if (buffLen == 0) {
+        lastProgress = millis();
+        return true;
+    }
+
+    size_t n = std::min((size_t)std::max(client.availableForWrite(), 0), buffLen);
+
+    if (n > 0) {
+        n = client.write((const uint8_t*)buff, n);
+    }
+
+    if (n > 0) {
+        memmove(buff, buff + n, buffLen - n);
+        buffLen -= n;
+        eventStart = buffLen;
+        lastProgress = millis();
+    }
+
+    return millis() - lastProgress < SSE_STALL_TIMEOUT;
+}
+
+void SseSubscriber_t::stop() {
+    client.stop();
+    client = WiFiClient();
+    active = false;
+    log = false;
+    behind = false;
+    logFrom = noLogFrom;
+    buffLen = 0;
+    spill = String();
+    eventStart = 0;
+    eventDropped = false;
 }
 
 /*****************************************************************************
@@ -430,9 +601,15 @@ String CycleItem_t::asJsonString() {
 void SprinklerAPI::setup() {
     LOG_DEBUG("ESP resetReason: %s\n", ESP.getResetReason().c_str());
 
+    bootTag = ESP.random();
+
     pinMode(outputEnablePin, OUTPUT);
     checkOutputEnable();
 
+    logger.setListener([this](const LogRecord_t& rec) {
+        sendLogEvent(rec);
+    });
+    logger.begin();
     logMsgf("restarted|%s", ESP.getResetReason().c_str());
 
     if (ESP.getResetInfoPtr()->reason == REASON_EXCEPTION_RST) {
@@ -445,7 +622,7 @@ void SprinklerAPI::setup() {
 
     server.begin();
 
-    deserializeCycleItems();
+    restoreState();
     calcNextCycleStart();
 
     currDay = timeClient.getDay();
@@ -480,17 +657,22 @@ void SprinklerAPI::loop() {
     if (shouldSendStatusEvent) {
         sendStatusEvent();
     }
+
+    sseDrain();
+
+    logger.loop(now);
+    flushJournal();
 }
 
 /**
  * SprinklerAPI::initializeUrls()
  * 
- * Declares all the URLs to which this server will respond.  So many URLs are
- * now being declared (albeit many of them are for testing purposes) that the
- * overall initialization phase of this class takes upwards of 5,000 ms.  This
- * seems scary, that maybe there need to be yields so that the watchdog does
- * not get upset.  Therefore after every 5 declarations, there is a manual
- * yield() inserted to give time back to the hardware.
+ * Declares all the URLs to which this server will respond.  Each one used to
+ * be registered with its own handler object (which, with so many URLs, took
+ * upwards of 5,000 ms and needed yield()s to keep the watchdog happy).  Now
+ * they are one constant table of handler methods that the server indexes
+ * once, which takes next to no time, and a request is matched in the same
+ * time however many URLs there are.
  */
 void SprinklerAPI::initializeUrls() {
     // this is vital to permit web pages loaded from other servers to access
@@ -498,1485 +680,2629 @@ void SprinklerAPI::initializeUrls() {
 
     server.enableCORS(true);
 
-    if (fsAvailable) {
-        server.serveStatic("/", LittleFS, "/index.html");
-        server.serveStatic("/index.html", LittleFS, "/index.html");
-        server.serveStatic("/sprinklers.js", LittleFS, "/sprinklers.js");
-    } else {
-        server.on(F("/index.html"), HTTP_GET, [this]() {
-            sendMessage(
-                "{\"status\": \"error\", "
-                "\"msg\": \"LittleFS failed to begin()\"}"
-            );
-        });
+    // request headers are only kept if they are asked for up front
+    static const char* headerKeys[] = {
+        "Last-Event-ID", "Accept-Encoding", "If-None-Match"
+    };
+    server.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
+
+    // Every URL the API answers, and the method that answers it.  A "{}" in
+    // a pattern is a path argument (as with the core's UriBraces).  The
+    // table is constant, so nothing is allocated for it; the server only
+    // indexes the patterns (see SprinklerWebServer::setRoutes()).
+
+    static constexpr WebRoute<SprinklerAPI> routes[] = {
+        {HTTP_GET, "/", &SprinklerAPI::handleUiFile},
+        {HTTP_GET, "/index.html", &SprinklerAPI::handleUiFile},
+        {HTTP_GET, "/sprinklers.js", &SprinklerAPI::handleUiFile},
+        {HTTP_GET, "/status", &SprinklerAPI::handleStatus},
+        {HTTP_GET, "/status/wait", &SprinklerAPI::handleStatusWait},
+        {HTTP_GET, "/zone/{}/{}", &SprinklerAPI::handleZone},
+        {HTTP_GET, "/toggle/{}", &SprinklerAPI::handleToggle},
+        {HTTP_GET, "/blink", &SprinklerAPI::handleBlink},
+        {HTTP_GET, "/restart", &SprinklerAPI::handleRestart},
+        {HTTP_GET, "/schd/{}", &SprinklerAPI::handleScheduler},
+        {HTTP_GET, "/schd/{}/{}", &SprinklerAPI::handleScheduleItem},
+        {HTTP_POST, "/schd/{}", &SprinklerAPI::handleSchedulePost},
+        {HTTP_POST, "/batch", &SprinklerAPI::handleBatch},
+        {HTTP_GET, "/cycles{}", &SprinklerAPI::handleCycles},
+        {HTTP_POST, "/cycle", &SprinklerAPI::handleCyclePost},
+        {HTTP_DELETE, "/cycle", &SprinklerAPI::handleCycleDelete},
+        {HTTP_GET, "/cycle/{}", &SprinklerAPI::handleCycle},
+        {HTTP_GET, "/cycle/{}/run", &SprinklerAPI::handleCycleRun},
+        {HTTP_GET, "/next-cycle", &SprinklerAPI::handleNextCycle},
+        {HTTP_GET, "/log/{}", &SprinklerAPI::handleLog},
+        {HTTP_GET, "/log/mark/{}", &SprinklerAPI::handleLogMark},
+        {HTTP_GET, "/ls", &SprinklerAPI::handleLs},
+        {HTTP_GET, "/download/{}", &SprinklerAPI::handleDownload},
+        {HTTP_POST, "/upload", &SprinklerAPI::handleUpload, &SprinklerAPI::receiveUpload},
+        {HTTP_GET, "/rm/{}", &SprinklerAPI::handleRm},
+        {HTTP_GET, "/shouldRun", &SprinklerAPI::handleShouldRun},
+        {HTTP_GET, "/calc", &SprinklerAPI::handleCalc},
+        {HTTP_GET, "/ser", &SprinklerAPI::handleSer},
+        {HTTP_GET, "/deser", &SprinklerAPI::handleDeser},
+        {HTTP_GET, "/del/{}", &SprinklerAPI::handleDel},
+        {HTTP_GET, "/clear", &SprinklerAPI::handleClear},
+        {HTTP_GET, "/oe/{}", &SprinklerAPI::handleSetOe},
+        {HTTP_GET, "/oe", &SprinklerAPI::handleOe},
+        {HTTP_GET, "/reg/{}", &SprinklerAPI::handleSetReg},
+        {HTTP_GET, "/reg", &SprinklerAPI::handleReg},
+        {HTTP_GET, "/logic/{}", &SprinklerAPI::handleSetLogic},
+        {HTTP_GET, "/logic", &SprinklerAPI::handleLogic},
+#ifdef SHIFT_REGISTER_RECORDING
+        {HTTP_GET, "/latches", &SprinklerAPI::handleLatches},
+#endif
+        {HTTP_GET, "/adj", &SprinklerAPI::handleAdj},
+        {HTTP_GET, "/adj/{}", &SprinklerAPI::handleSetAdj},
+        {HTTP_GET, "/check", &SprinklerAPI::handleCheck},
+        {HTTP_GET, "/sse", &SprinklerAPI::handleSse},
+        {HTTP_GET, "/sse/{}", &SprinklerAPI::handleSseCommand},
+        {HTTP_GET, "/hold", &SprinklerAPI::handleHold},
+        {HTTP_GET, "/hold/{}", &SprinklerAPI::handleSetHold},
+        {HTTP_GET, "/debug/{}", &SprinklerAPI::handleDebug},
+        {HTTP_GET, "/test/{}/{}/{}", &SprinklerAPI::handleTest},
+        {HTTP_GET, "/seek/{}", &SprinklerAPI::handleSeek},
+        {HTTP_GET, "/seektest/{}", &SprinklerAPI::handleSeekTest},
+        {HTTP_GET, "/now", &SprinklerAPI::handleNow},
+        {HTTP_GET, "/tz/{}", &SprinklerAPI::handleSetTz},
+    };
+
+    server.setRoutes(*this, routes);
+
+    server.onNotFound([this]() {
+        sendServerUriNotFound();
+    });
+
+    LOG_DEBUG("%u routes\n", (unsigned)(sizeof(routes) / sizeof(routes[0])));
+}
+
+/**
+ * SprinklerAPI::handleUiFile()
+ * 
+ * Serves the files of the UI ("/" is index.html).  They come from the
+ * bundle built into the firmware, which takes no filesystem I/O, unless
+ * newer ones have been uploaded to LittleFS (see "make upload-ui"), which
+ * is decided file by file.  Either way they are gzipped.
+ * 
+ * The index.html that build_ui.py makes asks for sprinklers.js by a URL
+ * that changes with its contents (/sprinklers.js?v=<ETag>), so what that
+ * URL returns can be cached for good, as long as it is the file the URL
+ * names.  Anything else is checked with the board on every load (which only
+ * costs a 304 if it hasn't changed).
+ */
+void SprinklerAPI::handleUiFile() {
+    String path = server.uri();
+    const char* version = (server.hasArg("v")) ? server.arg("v").c_str() : nullptr;
+
+    if (path == "/") {
+        path = "/index.html";
     }
 
-    // Each definition of a URL is augmented with a debugging statement to
-    // confirm that it was defined correctly to debug a sitaution where the
-    // server appeared not to recognize the URLs.  Now that they are here, I
-    // decided to leave them in case they are useful in the future.  If any-
-    // thing, they show progress through the initialization phase.
+#ifdef UI_BUNDLE_VERSION
+    // a file missing from LittleFS (say, an upload that was cut short) still
+    // comes from the bundle
+    bool uploaded =
+        fsAvailable &&
+        getUiFilesVersion() > UI_BUNDLE_VERSION &&
+        (LittleFS.exists(path) || LittleFS.exists(path + ".gz"));
+
+    if (!uploaded) {
+        for (const UiBundleFile_t& f : uiBundleFiles) {
+            if (path == f.path) {
+                server.sendProgmem(
+                    uiBundle + f.offset,
+                    f.length,
+                    f.contentType,
+                    f.etag,
+                    "no-cache",
+                    version
+                );
+                return;
+            }
+        }
+    }
+#endif
 
-    LOG_DEBUG("/, /index.html\n");
+    if (!fsAvailable) {
+        sendMessage(
+            "{\"status\": \"error\", "
+            "\"msg\": \"LittleFS failed to begin()\"}"
+        );
+        return;
+    }
 
-    // the ESP8266WebServer's "on()" function requires pointers to what I
-    // would describe as regular functions -- that is, not a function defined 
-    // as a method on a class.  So in order to have a method in this class 
-    // respond to a request, you have to wrap it in a lambda and capture
-    // "this", which is a pointer to the current instance (allowing access to 
-    // the references to the server and shift register objects).
+    server.sendFile(LittleFS, path, "no-cache", version);
+}
 
-    server.on(F("/status"), HTTP_GET, [this]() {
-        sendApiStatus();
-    });
+/**
+ * SprinklerAPI::getUiFilesVersion()
+ * 
+ * Returns the version of the UI files that were uploaded to LittleFS, from
+ * the /ui.ver that "make upload-ui" uploads with them (0 if there isn't
+ * one).  It is only read again after a file is uploaded or removed.
+ */
+unsigned long SprinklerAPI::getUiFilesVersion() {
+    if (uiFilesVersion == ULONG_MAX) {
+        File f = LittleFS.open("/ui.ver", "r");
+        char buff[16] = "";
 
-    LOG_DEBUG("/status\n");
+        if (f) {
+            buff[f.readBytes(buff, sizeof(buff) - 1)] = '\0';
+            f.close();
+        }
 
-    server.on(UriBraces("/zone/{}/{}"), HTTP_GET, [this]() {
-        events.push([this]() { controlZone(); });
-        sendOkStatusMessage();
-    });
+        uiFilesVersion = strtoul(buff, NULL, 10);
+    }
 
-    LOG_DEBUG("/zone/{}/{}\n");
+    return uiFilesVersion;
+}
 
-    server.on(UriBraces("/toggle/{}"), HTTP_GET, [this]() {
-        setToggleDelay();
-        sendFormatted(
-            "{\"status\": \"ok\", \"toggleDelay\": %lu}",
-            toggleDelay
-        );
-    });
+void SprinklerAPI::handleStatus() {
+    if (stateNotModified()) {
+        return;
+    }
+
+    sendApiStatus();
+}
 
-    LOG_DEBUG("/toggle/{}\n");
+/**
+ * SprinklerAPI::handleStatusWait()
+ * 
+ * See STATUS_WAIT_TIMEOUT.  This is run again whenever the state changes
+ * while the request is parked (markStatusDirty() wakes it), so it answers
+ * as soon as the version differs from since -- which it also does right
+ * away after a restart, or if there is no since.  Writes to the filesystem
+ * (the log's and the journal's) don't change the version, so they neither
+ * wake it nor make the version just given out stale.  The answer is:
+ * 
+ *      {"status": "ok", "version": "<version>", "state": <the /status>}
+ */
+void SprinklerAPI::handleStatusWait() {
+    char version[24];
 
-    server.on(F("/blink"), HTTP_GET, [this]() {
-        blinkLed(3, 100, 200);
-        sendOkStatusMessage();
-    });
+    getStateVersion(version, sizeof(version));
 
-    LOG_DEBUG("/blink\n");
+    if (server.arg("since") == version) {
+        if (server.parkExpired()) {
+            server.send(304);
+            return;
+        }
 
-    yield();
+        unsigned long timeout = STATUS_WAIT_TIMEOUT;
 
-    server.on(F("/restart"), HTTP_GET, [this]() {
-        sendMessage("{\"status\": \"restarting\"}");
-        delay(10);
-        ESP.reset();
-    });
+        if (server.hasArg("timeout")) {
+            timeout = std::min(
+                strtoul(server.arg("timeout").c_str(), NULL, 10),
+                (unsigned long)STATUS_WAIT_MAX_TIMEOUT
+            );
+        }
 
-    LOG_DEBUG("/restart\n");
+        if (server.park(timeout * 1000)) {
+            return;
+        }
+        // with no room to park it, it is answered now (with the same version)
+    }
 
-    /*
-     * Schedule API Paths
-     *      /schd/1/20 = schedule zone 1 to run for 20 minutes 
-     *                   (if this is the first scheduled item, it starts immediately)
-     *                      • continue to invoke API for successive zone requests
-     *                      • subsequent invocations add to vector this.schedule and increment this.scheduleCount
-     *      /schd/pause = pause running the current schedule and temporarily turn off the scheduled zone
-     *                      • also capture millis() into this.pausedScheduleItemMillis
-     *      /schd/resume = turn on the scheduled zone again and resume the schedule
-     *                      • scheduleItemEnd += (millis() - this.pausedScheduleItemMillis)
-     *      /schd/cancel = turn off scheduled zone, flush schedule array, set currentScheduleItem = -1
-     *      /schd/skip = go on to the next scheduled item immediately
-     *      /schd/set = this is a POST request with a JSON payload that specifies the entire schedule
-     *                      • this would cause a full cancel if a schedule is already runnin
-     *                      • this fully resets the schedule
-     * 
-     * • use "toggle" to go from one zone to the next
-     *   (this will ensure that if a zone is on when the schedule API is first invoked that it takes effect immediately)
-     * • the contents of this.schedule should be included in the results returned by /status
-     * • right now given the lack of EPROM persistence, it is understood that the contents of this.schedule will 
-     *   be lost when a power cycle occurs (including invoking /restart)
-     */
+    String v(version);
 
-    server.on(UriBraces("/schd/{}"), HTTP_GET, [this]() {
-        String action = server.pathArg(0);
-        controlScheduler(action);
-        sendOkStatusMessage();
+    sendChunked([this, v](JsonStreamWriter& json) {
+        json.beginObject();
+        json.key("status").value("ok");
+        json.key("version").value(v);
+        json.key("state");
+        writeAPIStatus(json);
+        json.end();
     });
+}
 
-    LOG_DEBUG("/schd/{} (get)\n");
+// the request is over by the time an event runs, so what the event
+// needs from it is captured here
+void SprinklerAPI::handleZone() {
+    const String zones = server.pathArg(0);
+    const String command = server.pathArg(1);
+    events.push([this, zones, command]() { controlZone(zones, command); });
+    sendOkStatusMessage();
+}
 
-    server.on(UriBraces("/schd/{}/{}"), HTTP_GET, [this]() {
-        const String zones = server.pathArg(0);
-        const String runTime = server.pathArg(1);
-        events.push([this, zones, runTime]() { scheduleItem(zones, runTime); });
-        sendOkStatusMessage();
-    });
+void SprinklerAPI::handleToggle() {
+    setToggleDelay();
+    sendFormatted(
+        "{\"status\": \"ok\", \"toggleDelay\": %lu}",
+        toggleDelay
+    );
+}
 
-    LOG_DEBUG("/schd/{}/{}\n");
+void SprinklerAPI::handleBlink() {
+    blinkLed(3, 100, 200);
+    sendOkStatusMessage();
+}
 
-    server.on(UriBraces("/schd/{}"), HTTP_POST, [this]() {
-        // supports "set" and "append"
-        events.push([this]() { schedulePost(); });
-        sendOkStatusMessage();
-    });
+void SprinklerAPI::handleRestart() {
+    sendMessage("{\"status\": \"restarting\"}");
+    flushLog();
+    delay(10);
+    ESP.reset();
+}
+
+/*
+ * Schedule API Paths
+ *      /schd/1/20 = schedule zone 1 to run for 20 minutes 
+ *                   (if this is the first scheduled item, it starts immediately)
+ *                      • continue to invoke API for successive zone requests
+ *                      • subsequent invocations add to vector this.schedule and increment this.scheduleCount
+ *      /schd/pause = pause running the current schedule and temporarily turn off the scheduled zone
+ *                      • also capture millis() into this.pausedScheduleItemMillis
+ *      /schd/resume = turn on the scheduled zone again and resume the schedule
+ *                      • scheduleItemEnd += (millis() - this.pausedScheduleItemMillis)
+ *      /schd/cancel = turn off scheduled zone, flush schedule array, set currentScheduleItem = -1
+ *      /schd/skip = go on to the next scheduled item immediately
+ *      /schd/set = this is a POST request with a JSON payload that specifies the entire schedule
+ *                      • this would cause a full cancel if a schedule is already runnin
+ *                      • this fully resets the schedule
+ * 
+ * • use "toggle" to go from one zone to the next
+ *   (this will ensure that if a zone is on when the schedule API is first invoked that it takes effect immediately)
+ * • the contents of this.schedule should be included in the results returned by /status
+ * • right now given the lack of EPROM persistence, it is understood that the contents of this.schedule will 
+ *   be lost when a power cycle occurs (including invoking /restart)
+ */
+void SprinklerAPI::handleScheduler() {
+    String action = server.pathArg(0);
+    controlScheduler(action);
+    sendOkStatusMessage();
+}
 
-    LOG_DEBUG("/schd/{}/{} (post)\n");
+void SprinklerAPI::handleScheduleItem() {
+    const String zones = server.pathArg(0);
+    const String runTime = server.pathArg(1);
+    events.push([this, zones, runTime]() { scheduleItem(zones, runTime); });
+    sendOkStatusMessage();
+}
 
-    /*
-     * Cycle API Paths
-     *
-     * /cycles{.json|.text}
-     *      List all cycles
-     * 
-     * /cycle
-     *      HTTP_POST = add or replace the cycle defined in the JSON body
-     *      HTTP_DELETE = delete the cycle with the defined name
-     * 
-     * /cycle/{}
-     *      Retrieve the cycle as a single JSON item
-     * 
-     * /cycle/{}/run
-     *      Run the indicated cycle
-     * 
-     * /next-cycle
-     *      Retrieve information about the next cycle to run
-     */
+void SprinklerAPI::handleSchedulePost() {
+    // supports "set" and "append"
+    const String cmd = server.pathArg(0);
+    const String body = server.arg("plain");
+    events.push([this, cmd, body]() { schedulePost(cmd, body); });
+    sendOkStatusMessage();
+}
 
-    server.on(UriBraces("/cycles{}"), HTTP_GET, [this]() {
-        String pa0 = server.pathArg(0);
-        String content = getCyclesStatus(pa0);
-        sendMessage(content.c_str());
-    });
+/**
+ * SprinklerAPI::handleBatch()
+ * 
+ * POST /batch with a JSON array of operations, each the path of one of the
+ * GET requests that change the state (see BatchOp_t), for example:
+ * 
+ *      ["/schd/cancel", "/schd/1,2/10", "/schd/5/15", "/adj/80"]
+ * 
+ * Every operation is checked before any is applied, and if one is invalid
+ * none is and the error names it.  Otherwise they are applied in order,
+ * right here rather than one a second through the events queue, so the
+ * whole batch lands within the same pass of loop():  it raises a single
+ * status event, and its changes are journaled with a single write.
+ */
+void SprinklerAPI::handleBatch() {
+    DynamicJsonDocument doc(2048);
+    DeserializationError err = deserializeJson(doc, server.arg("plain"));
+
+    if (err || !doc.is<JsonArray>()) {
+        sendMessage(
+            "{\"status\": \"error\", "
+            "\"msg\": \"the body must be a JSON array of operations\"}"
+        );
+        return;
+    }
 
-    LOG_DEBUG("/cycles{}\n");
+    JsonArray ops = doc.as<JsonArray>();
 
-    yield();
+    if (ops.size() > BATCH_MAX_OPS) {
+        sendFormatted(
+            "{\"status\": \"error\", \"msg\": \"more than %u operations\"}",
+            BATCH_MAX_OPS
+        );
+        return;
+    }
 
-    /**
-     * Handle adds and updates -- if an existing cycle is found with the same
-     * name as the cycle sent in the body of the POST, then it will fully 
-     * replace the previous one.
-     */
+    std::vector<BatchOp_t> batch(ops.size());
+    size_t i = 0;
 
-    server.on(F("/cycle"), HTTP_POST, [this]() {
-        String body = server.arg("plain");
-        CycleItem_t ci = CycleItem_t::fromJsonString(body);
-        String cycleName(ci.cycleName);
-        String error = validateCycle(ci);
+    for (JsonVariant v : ops) {
+        const char* path = v.as<const char*>();
+        String error = (path) ? parseBatchOp(path, batch[i]) : String("not a path");
 
         if (error.length() > 0) {
             sendFormatted(
-                "{\"status\": \"error\", \"msg\": \"invalid %s\"}",
+                "{\"status\": \"error\", \"msg\": \"operation %u: %s\"}",
+                (unsigned int)i + 1,
                 error.c_str()
             );
             return;
         }
+        i++;
+    }
 
-        if (findCycle(cycleName)) {
-            LOG_DEBUG(
-                "replacing existing cycle found: %s\n",
-                cycleName.c_str()
-            );
+    bool hold = false;
 
-            // don't recalc the next cycle because that wil be done by
-            // addCycle() below
+    for (const BatchOp_t& op : batch) {
+        applyBatchOp(op);
+        hold |= (op.type == batchHold);
+    }
 
-            deleteCycle(cycleName, false);
-        }
+    if (hold) {
+        calcNextCycleStart();
+    }
 
-        addCycle(std::move(ci));
+    LOG_DEBUG("batch of %u operations applied\n", (unsigned int)batch.size());
 
-        // this ends the request/response cycle initiated by the client
-        sendMessage(getCyclesStatus().c_str());
+    sendFormatted(
+        "{\"status\": \"ok\", \"ops\": %u}",
+        (unsigned int)batch.size()
+    );
+}
 
-        // this will be sent shortly later to update the UI
-        triggerSendStatusEvent();
-    });
+/**
+ * SprinklerAPI::parseBatchOp()
+ * 
+ * Parses and checks one operation of a batch (see handleBatch()) into op.
+ * Returns what is wrong with it, or an empty String if it can be applied.
+ */
+String SprinklerAPI::parseBatchOp(const char* path, BatchOp_t& op) {
+    String remaining((*path == '/') ? path + 1 : path);
+    String parts[3];
+    uint8_t count = 0;
 
-    LOG_DEBUG("/cycle (post)\n");
+    // count is 4 if there are more than 3 parts
+    while (remaining.length() > 0 && count < 4) {
+        int slash = remaining.indexOf('/');
 
-    /**
-     * The body of the delete should look like this:
-     * 
-     *      {"name": "Some Cycle"}
-     */
+        if (count < 3) {
+            parts[count] = (slash < 0) ? remaining : remaining.substring(0, slash);
+        }
+        count++;
+        remaining = (slash < 0) ? String() : remaining.substring(slash + 1);
+    }
 
-    server.on(F("/cycle"), HTTP_DELETE, [this]() {
-        String body = server.arg("plain");
-        DynamicJsonDocument doc(64);
+    String invalid = String("invalid: ") + path;
 
-        deserializeJson(doc, body);
+    if (parts[0] == "zone" && count == 3) {
+        op.type = batchZone;
+        op.arg0 = parts[1];
+        op.arg1 = parts[2];
 
-        LOG_DEBUG(
-            "/cycle delete: %s\n",
-            body.c_str()
-        );
+        if (zonesToBitMask(op.arg0).status == error ||
+            (op.arg1 != "on" && op.arg1 != "off" && op.arg1 != "toggle")) {
+            return invalid;
+        }
+    } else if (parts[0] == "schd" && count == 2) {
+        op.type = batchScheduler;
+        op.arg0 = parts[1];
 
-        if (doc.overflowed()) {
-            Serial.printf(
-                "\n***** Error: DynamicJsonDocument overflowed "
-                "in on /cycle HTTP_DELETE\n"
-                "doc.capacity()=%zu\n\n",
-                doc.capacity()
-            );
+        if (op.arg0 != "cancel" && op.arg0 != "pause" &&
+            op.arg0 != "resume" && op.arg0 != "skip") {
+            return invalid;
+        }
+    } else if (parts[0] == "schd" && count == 3) {
+        op.type = batchScheduleItem;
+        op.arg0 = parts[1];
+        op.arg1 = parts[2];
+        op.value = op.arg1.toInt();
+
+        if (zonesToBitMask(op.arg0).status == error || op.value < 1 || op.value > 255) {
+            return invalid;
         }
+    } else if (parts[0] == "adj" && count == 2) {
+        op.type = batchAdj;
+        op.value = parts[1].toInt();
 
-        if (doc.containsKey("name")) {
-            String cycleName = doc["name"].as<String>();
+        if (op.value < 1 || op.value > 255) {
+            return invalid;
+        }
+    } else if (parts[0] == "hold" && count == 2) {
+        op.type = batchHold;
+        op.value = parts[1].toInt();
 
-            if (findCycle(cycleName)) {
-                deleteCycle(cycleName);
+        if (parts[1].isEmpty() || op.value < -1 || op.value > 127) {
+            return invalid;
+        }
+    } else if (parts[0] == "cycle" && count == 3 && parts[2] == "run") {
+        String cycleName = server.urlDecode(parts[1]);
 
-                // this ends the request/response cycle initiated by the client
-                sendMessage(getCyclesStatus().c_str());
+        op.type = batchCycleRun;
+        op.cycleItem = findCycle(cycleName);
 
-                // this will be sent shortly later to update the UI
-                triggerSendStatusEvent();
-            } else {
-                sendFormatted(
-                    "{\"status\": \"error\", "
-                    "\"msg\": \"cycle '%s' not found\"}",
-                    cycleName.c_str()
-                );
-            }
-            return;
-        } 
+        if (!op.cycleItem) {
+            return String("cycle not found: ") + cycleName;
+        }
+    } else {
+        return invalid;
+    }
 
-        sendMessage(
-            "{\"status\": \"error\", "
-            "\"msg\": \"JSON did not contain 'name' key\"}"
-        );
-    });
+    return String();
+}
 
-    LOG_DEBUG("/cycle (delete)\n");
+// applies an operation that parseBatchOp() has checked
+void SprinklerAPI::applyBatchOp(const BatchOp_t& op) {
+    switch (op.type) {
+        case batchZone:
+            controlZone(op.arg0, op.arg1);
+            break;
+        case batchScheduler:
+            controlScheduler(op.arg0);
+            break;
+        case batchScheduleItem:
+            scheduleItem(op.arg0, op.arg1);
+            break;
+        case batchAdj:
+            setSeasonalAdjustment((uint8_t)op.value);
+            break;
+        case batchHold:
+            setHoldDays((int8_t)op.value);
+            break;
+        case batchCycleRun:
+            initiateCycle(op.cycleItem);
+            break;
+    }
+}
 
-    /**
-     * Retrieve a cycle.  The name should be in the URL and it should be
-     * URL encoded so that an exact match is possible (with spaces, etc)
-     */
+/*
+ * Cycle API Paths
+ *
+ * /cycles{.json|.text}
+ *      List all cycles
+ * 
+ * /cycle
+ *      HTTP_POST = add or replace the cycle defined in the JSON body
+ *      HTTP_DELETE = delete the cycle with the defined name
+ * 
+ * /cycle/{}
+ *      Retrieve the cycle as a single JSON item
+ * 
+ * /cycle/{}/run
+ *      Run the indicated cycle
+ * 
+ * /next-cycle
+ *      Retrieve information about the next cycle to run
+ */
+void SprinklerAPI::handleCycles() {
+    if (stateNotModified()) {
+        return;
+    }
 
-    server.on(UriBraces(F("/cycle/{}")), HTTP_GET, [this]() {
-        String cycleName = server.urlDecode(server.pathArg(0));
-                
-        LOG_DEBUG("finding cycle: %s\n", cycleName.c_str());
+    sendCyclesStatus(server.pathArg(0));
+}
 
-        CycleItem_t* ci = findCycle(cycleName);
+/**
+ * Handle adds and updates -- if an existing cycle is found with the same
+ * name as the cycle sent in the body of the POST, then it will fully 
+ * replace the previous one.
+ */
+void SprinklerAPI::handleCyclePost() {
+    String body = server.arg("plain");
+    CycleItem_t ci = CycleItem_t::fromJsonString(body);
+    String cycleName(ci.cycleName);
+    String error = validateCycle(ci);
 
-        if (ci) {
-            LOG_DEBUG("cycle found: %s\n", ci->cycleName);
-            server.send(200, "application/json", ci->asJsonString().c_str());
-        } else {
-            LOG_DEBUG("cycle not found\n");
-            sendMessage("{\"status\": \"error\", \"msg\": \"cycle not found\"}");
-        }
-    });
+    if (error.length() > 0) {
+        sendFormatted(
+            "{\"status\": \"error\", \"msg\": \"invalid %s\"}",
+            error.c_str()
+        );
+        return;
+    }
 
-    LOG_DEBUG("/cycle/{}\n");
+    if (findCycle(cycleName)) {
+        LOG_DEBUG(
+            "replacing existing cycle found: %s\n",
+            cycleName.c_str()
+        );
 
-    /**
-     * Run a cycle on demand
-     */
+        // don't recalc the next cycle because that wil be done by
+        // addCycle() below
 
-    server.on(UriBraces(F("/cycle/{}/run")), HTTP_GET, [this]() {
-        String cycleName = server.urlDecode(server.pathArg(0));
+        deleteCycle(cycleName, false);
+    }
 
-        LOG_DEBUG("finding cycle to run: %s\n", cycleName.c_str());
+    addCycle(std::move(ci));
 
-        CycleItem_t* ci = findCycle(cycleName);
+    // this ends the request/response cycle initiated by the client
+    sendCyclesStatus();
 
-        if (ci) {
-            LOG_DEBUG("cycle found\n");
+    // this will be sent shortly later to update the UI
+    triggerSendStatusEvent();
+}
 
-            initiateCycle(ci);
+/**
+ * The body of the delete should look like this:
+ * 
+ *      {"name": "Some Cycle"}
+ */
+void SprinklerAPI::handleCycleDelete() {
+    String body = server.arg("plain");
+    DynamicJsonDocument doc(64);
 
-            sendFormatted(
-                "{\"status\": \"ok\", "
-                "\"msg\": \"cycle started: %s\"}",
-                ci->cycleName
-            );
-            return;
+    deserializeJson(doc, body);
+
+    LOG_DEBUG(
+        "/cycle delete: %s\n",
+        body.c_str()
+    );
+
+    if (doc.overflowed()) {
+        Serial.printf(
+            "\n***** Error: DynamicJsonDocument overflowed "
+            "in on /cycle HTTP_DELETE\n"
+            "doc.capacity()=%zu\n\n",
+            doc.capacity()
+        );
+    }
+
+    if (doc.containsKey("name")) {
+        String cycleName = doc["name"].as<String>();
+
+        if (findCycle(cycleName)) {
+            deleteCycle(cycleName);
+
+            // this ends the request/response cycle initiated by the client
+            sendCyclesStatus();
+
+            // this will be sent shortly later to update the UI
+            triggerSendStatusEvent();
+        } else {
+            sendFormatted(
+                "{\"status\": \"error\", "
+                "\"msg\": \"cycle '%s' not found\"}",
+                cycleName.c_str()
+            );
+        }
+        return;
+    } 
+
+    sendMessage(
+        "{\"status\": \"error\", "
+        "\"msg\": \"JSON did not contain 'name' key\"}"
+    );
+}
+
+/**
+ * Retrieve a cycle.  The name should be in the URL and it should be
+ * URL encoded so that an exact match is possible (with spaces, etc)
+ */
+void SprinklerAPI::handleCycle() {
+    if (stateNotModified()) {
+        return;
+    }
+
+    String cycleName = server.urlDecode(server.pathArg(0));
+            
+    LOG_DEBUG("finding cycle: %s\n", cycleName.c_str());
+
+    CycleItem_t* ci = findCycle(cycleName);
+
+    if (ci) {
+        LOG_DEBUG("cycle found: %s\n", ci->cycleName);
+        sendChunked([ci](JsonStreamWriter& json) {
+            ci->writeJson(json);
+        }, "application/json");
+    } else {
+        LOG_DEBUG("cycle not found\n");
+        sendMessage("{\"status\": \"error\", \"msg\": \"cycle not found\"}");
+    }
+}
+
+/**
+ * Run a cycle on demand
+ */
+void SprinklerAPI::handleCycleRun() {
+    String cycleName = server.urlDecode(server.pathArg(0));
+
+    LOG_DEBUG("finding cycle to run: %s\n", cycleName.c_str());
+
+    CycleItem_t* ci = findCycle(cycleName);
+
+    if (ci) {
+        LOG_DEBUG("cycle found\n");
+
+        initiateCycle(ci);
+
+        sendFormatted(
+            "{\"status\": \"ok\", "
+            "\"msg\": \"cycle started: %s\"}",
+            ci->cycleName
+        );
+        return;
+    }
+
+    sendFormatted(
+        "{\"status\": \"error\", "
+        "\"msg\": \"cycle '%s' not found\"}",
+        cycleName.c_str()
+    );
+}
+
+/**
+ * to-do - eliminate this API, it is not needed nor used
+ * 
+ * Return a message containing the next cycle to run.  While I am not
+ * entirely certain I will need this in the UI, it is useful to be able to
+ * see the results of a recalculation or the impact of a cycle 
+ * modification.
+ */
+void SprinklerAPI::handleNextCycle() {
+    if (nextCycleItem) {
+        sendFormatted(
+            "{\"status\": \"ok\", "
+            "\"nextCycle\": \"%s\", \"startEpoch\": %lu, "
+            "\"startDateTime\": \"%s\"}",
+            nextCycleItem->cycleName,
+            nextCycleStartEpoch,
+            getNextCycleStartAsString().c_str()
+        );
+    } else {
+        sendMessage(
+            "{\"status\": \"ok\", "
+            "\"msg\": \"no cycle scheduled\"}"
+        );
+    }
+}
+
+/**
+ * Log API Paths
+ * 
+ * /log/show
+ *      Returns the entire log, rendered as text
+ * 
+ * /log/reset
+ *      Deletes every segment of the log
+ * 
+ * /log/size
+ *      Returns the size of the (binary) log, the number of segment files
+ *      it is stored in and the budget it is kept within (LOG_BUDGET)
+ * 
+ * /log/query?since=&until=&op=&zone=&limit=&from=
+ *      Returns only the log records that match, as JSON, a page at a
+ *      time (see sendLogQuery())
+ * 
+ * /log/mark/{}
+ *      Enables the placement of a "mark" which is any arbitrary text
+ *      obtained from the braces in the path.  Useful for putting some
+ *      text in the log to signal that the lines following the mark are
+ *      the result of some change or event.  Admittedly, not a feature
+ *      that will see wide use, but it was useful at one time for 
+ *      debugging purposes.
+ */
+void SprinklerAPI::handleLog() {
+    String pa0 = server.pathArg(0);
+
+    if (pa0 == "show") {
+        sendLog();
+        return;
+    } else 
+    if (pa0 == "query") {
+        sendLogQuery();
+        return;
+    } else 
+    if (pa0 == "reset") {
+        logger.reset();
+        // the text log from before the log was stored in binary
+        LittleFS.remove("/log.dat");
+        LOG_DEBUG("removed log segments");
+        sendMessage("{\"status\": \"ok\"}");
+        return;
+    } else
+    if (pa0 == "size") {
+        // the index, as [seq, epoch] of the start of each segment from
+        // firstSegment on (see SprinklerLog::findSegment())
+        String starts((char *)0);
+
+        starts.reserve(SprinklerLog::maxSegments * 24);
+
+        for (const LogSegmentStart_t& start : logger.getSegmentStarts()) {
+            char item[32];
+
+            snprintf(
+                item,
+                sizeof(item),
+                "%s[%lu, %lu]",
+                (starts.length() > 0) ? ", " : "",
+                (unsigned long)start.seq,
+                start.epoch
+            );
+            starts += item;
         }
 
-        sendFormatted(
-            "{\"status\": \"error\", "
-            "\"msg\": \"cycle '%s' not found\"}",
-            cycleName.c_str()
+        sendFormatted(
+            "{\"status\": \"ok\", \"logSize\": %zu, "
+            "\"logSegments\": %lu, \"logBudget\": %lu, "
+            "\"firstSegment\": %lu, \"segmentStarts\": [%s]}",
+            logger.size(),
+            (unsigned long)logger.segmentCount(),
+            (unsigned long)LOG_BUDGET,
+            (unsigned long)logger.getFirstSegment(),
+            starts.c_str()
+        );
+    }
+    else {
+        sendServerUriNotFound();
+    }
+}
+
+void SprinklerAPI::handleLogMark() {
+    String label = server.urlDecode(server.pathArg(0));
+    logMsgf("mark|%s", label.c_str());
+    sendLog();
+}
+
+/**
+ * API: /ls
+ * 
+ * Returns a listing of the root directory.  At this time there is no
+ * provision to list subdirectories since SprinklersAPI doesn't make any.
+ */
+void SprinklerAPI::handleLs() {
+    String s((char *)0);
+    bool first = true;
+
+    if (!s.reserve(512)) {
+        sendMessage(
+            "{\"status\": \"error\", \"msg\": \"unable to allocate string\"}"
+        );
+        return;
+    }
+
+    s += "Directory of /:\n";
+
+    for (Dir dir = LittleFS.openDir("/"); dir.next();) {
+        if (!first) s += "\n";
+        first = false;
+
+        s += dir.fileName();
+    }
+
+    sendMessage(s.c_str());
+}
+
+/**
+ * API: /download/{}
+ * 
+ * Returns to the client the exact, uninterpreted file contents of the
+ * requested file.  Returns an error JSON message otherwise.
+ * 
+ * The log is stored in binary segments (/log-N.bin), so /download/log.dat
+ * returns all of them rendered as the text log it used to be stored as.
+ */
+void SprinklerAPI::handleDownload() {
+    String fn = server.pathArg(0);
+
+    if (fn == "log.dat" || fn == "/log.dat") {
+        sendLog();
+        return;
+    }
+
+    // make sure a download of the log has everything logged so far
+    flushLog();
+
+    File f = LittleFS.open(fn, "r");
+
+    // the server sends the file after this returns, and closes it
+    if (f) {
+        server.streamFile(f, "text/plain");
+    } else {
+        sendFormatted(
+            "{\"status\": \"error\", "
+            "\"msg\": \"file '%s' not found\"}",
+            fn.c_str()
+        );
+    }
+}
+
+/**
+ * API: /upload
+ * 
+ * Uploads a file to the on-board filesystem or replaces a file if it
+ * already exists.  THERE IS NO RECOURSE FOR OVERWRITING A FILE.  
+ * 
+ * The primary purpose of this API is to permit updating the index.html
+ * file.  But it also can be used by unit tests to temporarily completely
+ * replace /cycles.json by first downloading the original version, then
+ * uploading a new and specially constructed version (and then it would
+ * need to invoke /calc to drive a recalculation of the next Cycle 
+ * to run).
+ * 
+ * Example:
+ * 
+ * $ curl http://sptest.local/upload -F 'name=@data/index.html'
+ * 
+ * Notes:
+ * 
+ *  - do this from the project directory (i.e., NOT the "data" directory)
+ *  - the "@" IS REQUIRED -- don't try leaving it off
+ *  - sometimes (often) the upload fails -- just try it again and it
+ *    probably will work fine
+ *  - despite you thinking that Autosave is on, it doesn't always, so 
+ *    just Cmd-S (Save) the file change before using curl to send it up
+ * 
+ * The reason this API call is better than using PlatformIO's
+ * "Upload Filesystem Image" function is that you won't delete the cycles
+ * which are defined locally on the board in the "cycles.json" file.
+ */
+void SprinklerAPI::handleUpload() {
+    // initial responder function -- my testing shows this function
+    // can't return any text
+    server.send(200);
+}
+
+void SprinklerAPI::receiveUpload() {
+    static File fsUploadFile;
+    HTTPUpload& upload = server.upload();
+
+    switch (upload.status) {
+        case UPLOAD_FILE_START:
+            {
+                String filename = upload.filename;
+
+                if (!filename.startsWith("/")) filename = "/" + filename;
+
+                LOG_DEBUG(
+                    "handleFileUpload Name: %s ",
+                    filename.c_str()
+                );
+
+                fsUploadFile = LittleFS.open(filename, "w");
+            }
+            break;
+        case UPLOAD_FILE_WRITE:
+            {
+                if (fsUploadFile) {
+                    fsUploadFile.write(upload.buf, upload.currentSize);
+                }
+            }
+            break;
+        case UPLOAD_FILE_END:
+            {
+                if (fsUploadFile) {
+                    fsUploadFile.close();
+                    markStatusDirty(statusFs);
+
+                    // the journal followed the snapshot just replaced
+                    if (upload.filename == "cycles.json" || upload.filename == "/cycles.json") {
+                        journal.discard();
+                    }
+                    server.forgetFileTags();
+                    uiFilesVersion = ULONG_MAX;
+
+                    LOG_DEBUG(
+                        "handleFileUpload Size: %zu\n",
+                        upload.totalSize
+                    );
+
+                    logMsgf(
+                        "upload|%s|%zu", 
+                        upload.filename.c_str(),
+                        upload.totalSize
+                    );
+
+                    // these probably won't ever be used, but for a 
+                    // complete implementation, these should be here
+                    server.sendHeader("Location","/success.html");
+                    server.send(303);
+                } else {
+                    server.send(
+                        500, 
+                        "text/plain", 
+                        "500: couldn't create file"
+                    );
+                }
+            }
+            break;
+        default:
+            {
+                server.send(
+                    500,
+                    "text/plain",
+                    "500: error creating file"
+                );
+            }
+    }
+}
+
+/**
+ * API: /rm/{}
+ * 
+ * Removes a file from the on-board filesystem.
+ * THERE IS NO RECOURSE AFTER REMOVING A FILE, 
+ * nor is there any confirmation.
+ */
+void SprinklerAPI::handleRm() {
+    String fn = server.pathArg(0);
+
+    if (!fn.startsWith(F("/"))) fn = "/" + fn;
+
+    if (LittleFS.remove(fn)) {
+        markStatusDirty(statusFs);
+        server.forgetFileTags();
+        uiFilesVersion = ULONG_MAX;
+        sendOkStatusMessage();
+    } else {
+        sendMessage(
+            "{\"status\": \"error\", "
+            "\"msg\": \"file not found\"}"
+        );
+    }
+}
+
+/*
+ * todo - delete this function when this kind of testing is no longer needed
+ */
+void SprinklerAPI::handleShouldRun() {
+    bool val = shouldRunNextCycle();
+    sendFormatted("%s",(val) ? "true" : "false");
+}
+
+/**
+ * /calc API - causes the calcNextCycleStart() function to be invoked.
+ * 
+ * This API is useful for testing purposes, so it will be retained.
+ * Unlike most APIs, it returns the cycles' status message, which makes
+ * sense since we are calculating the next cycle start, so we want to see
+ * how that turned out.
+ */
+void SprinklerAPI::handleCalc() {
+    calcNextCycleStart();
+    sendCyclesStatus();
+}
+
+/*
+ * todo - delete this function when this kind of testing is no longer needed
+ */
+void SprinklerAPI::handleSer() {
+    serializeCycleItems();
+    sendOkStatusMessage();
+}
+
+/*
+ * todo - delete this function when this kind of testing is no longer needed
+ */
+void SprinklerAPI::handleDeser() {
+    // the changes journaled during this pass have to be written first, so
+    // that they are replayed along with the rest
+    flushJournal();
+    restoreState();
+    sendOkStatusMessage();
+}
+
+/*
+ * todo - delete this function when this kind of testing is no longer needed
+ */
+void SprinklerAPI::handleDel() {
+    String cycleName = server.urlDecode(server.pathArg(0));
+    deleteCycle(cycleName);
+    Serial.printf("delete: %s\n", cycleName.c_str());
+    for (CycleItemIterator it = cycleItems.begin(); it != cycleItems.end(); it++) {
+        Serial.println(it->cycleName);
+    }
+    sendMessage("ok");
+}
+
+/**
+ * /clear API
+ * 
+ * Safely removes all cycles from the controller.  While not generally
+ * useful to the UI, this is useful for API testing purposes, so it will
+ * be retained permanently.
+ */
+void SprinklerAPI::handleClear() {
+    clearCycles();
+    sendOkStatusMessage();
+}
+
+/*
+ * function for use with testing out using another digital pin (like D0) on
+ * the Wemos D1 mini board to see if I can inhibit all output from the shift
+ * register by pulling the Output Enable (OE) pin high
+ */
+void SprinklerAPI::handleSetOe() {
+    String oe = server.pathArg(0);
+
+    pinMode(outputEnablePin, OUTPUT);
+
+    if (oe.equals("off") || oe.equals("high")) {
+        digitalWrite(outputEnablePin, HIGH);
+        Serial.printf("D0 (outputEnablePin=%u) set HIGH\n", outputEnablePin);
+    } else if (oe.equals("on") || oe.equals("low")) {
+        digitalWrite(outputEnablePin, LOW);
+        Serial.printf("D0 (outputEnablePin=%u) set LOW\n", outputEnablePin);
+    } else {
+        sendFormatted("invalid: %s", server.uri().c_str());
+        return;
+    }
+    markStatusDirty(statusZones);
+    sendFormatted("ok - /oe/%s", oe.c_str());
+}
+
+void SprinklerAPI::handleOe() {
+    uint8_t retval = (uint8_t)digitalRead(outputEnablePin);
+    sendFormatted(
+        "{\"status\": \"ok\", \"oe\": \"%s\"}", 
+        (retval == 1) ? "off" : "on"
+    );
+}
+
+/* test API -- delete as soon as possible
+ */
+void SprinklerAPI::handleSetReg() {
+    ZoneMask_t val = (ZoneMask_t)strtoul(server.pathArg(0).c_str(), NULL, 10);
+    setRegisters(val);
+    checkOutputEnable();
+    sendFormatted("ok - /reg/%lu", (unsigned long)getRegisters());
+}
+
+/* test API -- delete as soon as possible
+ */
+void SprinklerAPI::handleReg() {
+    sendFormatted("ok - getAll()=%lu", (unsigned long)getRegisters());
+}
+
+/**
+ * /logic/{} API
+ * 
+ * The logic mode is fixed at compile time (NORMAL_LOGIC), so this only
+ * accepts the mode the controller was built with, in which case all of
+ * the registers are reset to "all zones off" for that mode.
+ */
+void SprinklerAPI::handleSetLogic() {
+    String mode = server.pathArg(0);
+
+    if (!mode.equals(ZoneLogic_t::name)) {
+        sendFormatted(
+            "{\"status\": \"error\", \"msg\": \"invalid: %s "
+            "(built for %s logic)\"}",
+            mode.c_str(),
+            ZoneLogic_t::name
+        );
+        return;
+    }
+
+    setRegisters(ZoneLogic_t::toRegisters(0));
+    checkOutputEnable();
+    sendOkStatusMessage();
+}
+
+void SprinklerAPI::handleLogic() {
+    sendFormatted(
+        "{\"status\": \"ok\", \"logic\": \"%s\"}",
+        ZoneLogic_t::name
+    );
+}
+
+#ifdef SHIFT_REGISTER_RECORDING
+/**
+ * /latches API
+ * 
+ * Only present when built with the recording register transport.
+ * Returns every register value latched since the last request (up to
+ * the most recent ShiftRegisterRecorder::maxLatches of them) as
+ * [micros, registers] pairs, oldest first, and then forgets them.  Tests
+ * use this to verify exactly how and when zones were switched.
+ */
+void SprinklerAPI::handleLatches() {
+    ShiftRegisterRecorder& recorder = shiftRegister.transport();
+    String s = "{\"status\": \"ok\", \"latches\": [";
+    bool first = true;
+
+    for (const ShiftRegisterRecorder::Latch_t& latch : recorder.getLatches()) {
+        s += (first) ? "[" : ",[";
+        s += latch.micros;
+        s += ',';
+        s += latch.value;
+        s += ']';
+        first = false;
+    }
+    s += "]}";
+
+    recorder.clear();
+    sendMessage(s.c_str());
+}
+#endif
+
+void SprinklerAPI::handleAdj() {
+    sendFormatted(
+        "{\"status\": \"ok\", \"adj\": \"%u\"}",
+        getSeasonalAdjustment()
+    );
+}
+
+void SprinklerAPI::handleSetAdj() {
+    String adjString = server.pathArg(0);
+    long adj = adjString.toInt();
+
+    if (adjString.isEmpty()) {
+        sendFormatted(
+            "{\"status\": \"error\", \"msg\": \"invalid: %s\"}",
+            "must supply seasonalAdjustment value"
+        );
+        return;
+    }
+
+    if (adj < 1 || adj > 255) {
+        sendFormatted(
+            "{\"status\": \"error\", \"msg\": \"invalid seasonalAdjust value: %s - %s\"}",
+            adjString.c_str(),
+            "must be between 1 and 255"
+        );
+        return;
+    }
+
+    setSeasonalAdjustment((uint8_t)adj);
+    sendFormatted(
+        "{\"status\": \"ok\", \"adj\": \"%u\"}",
+        getSeasonalAdjustment()
+    );
+}
+
+void SprinklerAPI::handleCheck() {
+    checkOutputEnable();
+    sendOkStatusMessage();
+}
+
+/* Set up the Server-Sent Event channel.  Invoker simply sends a GET
+ * request to this URL and then the controller will send events to
+ * that client until it disconnects.  Up to SSE_MAX_CLIENTS clients are
+ * subscribed at once (see SseSubscriber_t); beyond that, the client that
+ * has been subscribed the longest is dropped.
+ *
+ * /sse?log=N also subscribes the client to "log" events, one per log
+ * record as it is logged (see sendLogEvent()).  The records from
+ * sequence number N on that are still in the log are sent first, so a
+ * client that reconnects with the seq after the last one it received
+ * misses nothing.  Leave N empty (/sse?log=) to only get new records.
+ */
+void SprinklerAPI::handleSse() {
+    WiFiClient client = server.client();
+
+    if (client && client.connected()) {
+        LOG_DEBUG(
+            "client connected - ip addr: %s\n",
+            client.remoteIP().toString().c_str()
         );
-    });
 
-    LOG_DEBUG("/cycle/{}/run\n");
+        // I referenced these two guides when coming up with my own
+        // implementation:
+        // https://github.com/IU5HKU/ESP8266-ServerSentEvents/blob/master/ESP8266_ServerSentEvents/ESP8266_ServerSentEvents.ino
+        // https://developer.mozilla.org/en-US/docs/Web/API/Server-sent_events/Using_server-sent_events
 
-    /**
-     * to-do - eliminate this API, it is not needed nor used
-     * 
-     * Return a message containing the next cycle to run.  While I am not
-     * entirely certain I will need this in the UI, it is useful to be able to
-     * see the results of a recalculation or the impact of a cycle 
-     * modification.
-     */
+        // the headers are queued like any event, so that even they
+        // don't wait on the connection
 
-    server.on(F("/next-cycle"), HTTP_GET, [this]() {
-        if (nextCycleItem) {
-            sendFormatted(
-                "{\"status\": \"ok\", "
-                "\"nextCycle\": \"%s\", \"startEpoch\": %lu, "
-                "\"startDateTime\": \"%s\"}",
-                nextCycleItem->cycleName,
-                nextCycleStartEpoch,
-                getNextCycleStartAsString().c_str()
-            );
-        } else {
-            sendMessage(
-                "{\"status\": \"ok\", "
-                "\"msg\": \"no cycle scheduled\"}"
-            );
-        }
-    });
+        static const char headers[] =
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream;charset=UTF-8\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "Cache-Control: no-cache\r\n"
+            "\r\n";
 
-    LOG_DEBUG("/next-cycle\n");
-
-    yield();
-
-    /**
-     * Log API Paths
-     * 
-     * /log/show
-     *      Returns the entire log file
-     * 
-     * /log/reset
-     *      Deletes the entire log file
-     * 
-     * /log/size
-     *      Returns the size of the log
-     * 
-     * /log/mark/{}
-     *      Enables the placement of a "mark" which is any arbitrary text
-     *      obtained from the braces in the path.  Useful for putting some
-     *      text in the log to signal that the lines following the mark are
-     *      the result of some change or event.  Admittedly, not a feature
-     *      that will see wide use, but it was useful at one time for 
-     *      debugging purposes.
-     */
+        int i = addSseSubscriber(client);
+        bool replayed = false;
 
-    server.on(UriBraces("/log/{}"), HTTP_GET, [this]() {
-        String pa0 = server.pathArg(0);
+        sseBeginEvent(1 << i);
+        sseWrite(1 << i, headers, sizeof(headers) - 1);
+        sseEndEvent(1 << i);
 
-        if (pa0 == "show") {
-            sendLog();
-            return;
-        } else 
-        if (pa0 == "reset") {
-            LittleFS.remove("/log.dat");
-            LOG_DEBUG("removed '/log.dat'");
-            sendMessage("{\"status\": \"ok\"}");
-            return;
-        } else
-        if (pa0 == "size") {
-            File f = LittleFS.open("/log.dat", "r");
-            size_t s = f.size();
-            f.close();
-            sendFormatted("{\"status\": \"ok\", \"logSize\": %zu}", s);
+        sseClients[i].log = server.hasArg("log");
+
+        // a reconnecting client only needs the events it missed (the
+        // browser sends the id of the last one it received)
+
+        if (server.hasHeader("Last-Event-ID")) {
+            replayed = replaySseEvents(i, server.header("Last-Event-ID"));
+            sseClients[i].needsFull = !replayed;
         }
-        else {
-            sendServerUriNotFound();
+
+        // the records are sent from the log as the buffer drains (see
+        // sseLogCatchUp())
+        if (!replayed && sseClients[i].log && server.arg("log").length() > 0) {
+            sseClients[i].logFrom = strtoul(server.arg("log").c_str(), NULL, 10);
         }
-    });
-    
-    LOG_DEBUG("/log/{}\n");
 
-    server.on(UriBraces("/log/mark/{}"), HTTP_GET, [this]() {
-        String label = server.urlDecode(server.pathArg(0));
-        logMsgf("mark|%s", label.c_str());
-        sendLog();
-    });
+        // Align the ticker at the top of minute boundary so that a status
+        // event message is always sent at the top of the new minute.
+        // I chose to use localtime() to determine the seconds from the
+        // retrieved epoch time instead of using NTPClient::getSeconds()
+        // because the latter re-invokes getEpochTime() which takes the
+        // movement of millis() into account.  I want the seconds to be
+        // calculated directly off the epochTime value without drift, so
+        // that can only be done using localtime().
+
+        time_t tt = timeClient.getEpochTime();
+        struct tm* t = localtime(&tt);
+        int run_secs = 60 - t->tm_sec;
+        char buff[11];  
 
-    LOG_DEBUG("/log/mark/{}\n");
+        strftime(buff, 10, "%H:%M:%S", t);
 
-    server.onNotFound([this]() {
-        sendServerUriNotFound();
-    });
+        LOG_DEBUG("/sse time: %s\n", buff);
+        LOG_DEBUG("sseTicker.once() in %i secs\n", run_secs);
 
-    LOG_DEBUG("onNotFound\n");
+        sseTicker.once(run_secs, [this]() {
+            // send a status event now and then the next one will be sent
+            // on the regular cycle of every minute
 
-    /**
-     * API: /ls
-     * 
-     * Returns a listing of the root directory.  At this time there is no
-     * provision to list subdirectories since SprinklersAPI doesn't make any.
-     */
-    server.on(F("/ls"), HTTP_GET, [this]() {
-        String s((char *)0);
-        bool first = true;
+            triggerSendStatusEvent();
 
-        if (!s.reserve(512)) {
-            sendMessage(
-                "{\"status\": \"error\", \"msg\": \"unable to allocate string\"}"
-            );
-            return;
-        }
+            sseTicker.attach(60, [this]() {
+                triggerSendStatusEvent();
+            });
+        });
+
+        // immediately acknowledge the connection by sending a status
+        // event message (the full status for the new client)
+        triggerSendStatusEvent();
+    }
+}
 
-        s += "Directory of /:\n";
+/**
+ * /sse/{} API
+ * 
+ * This is a testing API, but probably worth keeping around.  It has two
+ * purposes:  1) force the sending of a status event message, and
+ * 2) manually terminate the sseTicker (which is useful for turning off
+ * the automatic updates to the UI so that you can manually work with the
+ * HTML of the UI in a web browser without updates constantly occurring
+ * because the ticker is running).
+ * 
+ * Right now, if you make the parameter any value, it will just be logged,
+ * unless you use the special value "stop", which is both logged and then
+ * the sseTicker is terminated, or "full", which makes the event the full
+ * status instead of a delta (for a client that missed an event).
+ * 
+ * /sse/stats reports the subscribers, the bytes queued for them and the
+ * events dropped because a subscriber's buffer was full.
+ */
+void SprinklerAPI::handleSseCommand() {
+    String s = server.pathArg(0);
 
-        for (Dir dir = LittleFS.openDir("/"); dir.next();) {
-            if (!first) s += "\n";
-            first = false;
+    LOG_DEBUG(
+        "clients connected = %u msg = %s\n", 
+        __builtin_popcount(getSseSubscribers()),
+        s.c_str()
+    );
 
-            s += dir.fileName();
+    if (s.equals("stats")) {
+        size_t queued = 0;
+
+        for (const SseSubscriber_t& sub : sseClients) {
+            queued += (sub.active) ? sub.queued() : 0;
         }
 
-        sendMessage(s.c_str());
-    });
+        sendFormatted(
+            "{\"clients\": %u, \"queued\": %u, \"drops\": %lu}",
+            (unsigned)__builtin_popcount(getSseSubscribers()),
+            (unsigned)queued,
+            (unsigned long)sseDrops
+        );
+        return;
+    }
 
-    LOG_DEBUG("/ls\n");
+    if (s.equals("stop")) {
+        sseTicker.detach();
 
-    /**
-     * API: /download/{}
-     * 
-     * Returns to the client the exact, uninterpreted file contents of the
-     * requested file.  Returns an error JSON message otherwise.
-     */
-    server.on(UriBraces(F("/download/{}")), HTTP_GET, [this]() {
-        String fn = server.pathArg(0);
-        File f = LittleFS.open(fn, "r");
+        sendCustomServerEvent("stop", (const char *)NULL);
 
-        if (f) {
-            server.streamFile(f, "text/plain");
-            f.close();
-        } else {
-            sendFormatted(
-                "{\"status\": \"error\", "
-                "\"msg\": \"file '%s' not found\"}",
-                fn.c_str()
-            );
-        }
-    });
+        LOG_DEBUG("sseTicker detached\n");
+    } else {
+        if (s.equals("full")) {
+            // the request doesn't come over the event stream, so the
+            // subscribers it could be from are the ones at its address
+            String addr = server.client().remoteIP().toString();
+            uint8_t fromAddr = 0;
+
+            for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+                if (sseClients[i].active &&
+                    sseClients[i].client.remoteIP().toString() == addr) {
+                    fromAddr |= 1 << i;
+                }
+            }
 
-    LOG_DEBUG("/download/{}\n");
-
-    yield();
-
-    /**
-     * API: /upload
-     * 
-     * Uploads a file to the on-board filesystem or replaces a file if it
-     * already exists.  THERE IS NO RECOURSE FOR OVERWRITING A FILE.  
-     * 
-     * The primary purpose of this API is to permit updating the index.html
-     * file.  But it also can be used by unit tests to temporarily completely
-     * replace /cycles.json by first downloading the original version, then
-     * uploading a new and specially constructed version (and then it would
-     * need to invoke /calc to drive a recalculation of the next Cycle 
-     * to run).
-     * 
-     * Example:
-     * 
-     * $ curl http://sptest.local/upload -F 'name=@data/index.html'
-     * 
-     * Notes:
-     * 
-     *  - do this from the project directory (i.e., NOT the "data" directory)
-     *  - the "@" IS REQUIRED -- don't try leaving it off
-     *  - sometimes (often) the upload fails -- just try it again and it
-     *    probably will work fine
-     *  - despite you thinking that Autosave is on, it doesn't always, so 
-     *    just Cmd-S (Save) the file change before using curl to send it up
-     * 
-     * The reason this API call is better than using PlatformIO's
-     * "Upload Filesystem Image" function is that you won't delete the cycles
-     * which are defined locally on the board in the "cycles.json" file.
-     */
-    server.on(UriBraces(F("/upload")), HTTP_POST, 
-        [this]() {
-            // initial responder function -- my testing shows this function
-            // can't return any text
-            server.send(200);
-        },
-        [this]() {
-            static File fsUploadFile;
-            HTTPUpload& upload = server.upload();
-
-            switch (upload.status) {
-                case UPLOAD_FILE_START:
-                    {
-                        String filename = upload.filename;
-
-                        if (!filename.startsWith("/")) filename = "/" + filename;
-
-                        LOG_DEBUG(
-                            "handleFileUpload Name: %s ",
-                            filename.c_str()
-                        );
-
-                        fsUploadFile = LittleFS.open(filename, "w");
-                    }
-                    break;
-                case UPLOAD_FILE_WRITE:
-                    {
-                        if (fsUploadFile) {
-                            fsUploadFile.write(upload.buf, upload.currentSize);
-                        }
-                    }
-                    break;
-                case UPLOAD_FILE_END:
-                    {
-                        if (fsUploadFile) {
-                            fsUploadFile.close();
-
-                            LOG_DEBUG(
-                                "handleFileUpload Size: %zu\n",
-                                upload.totalSize
-                            );
-
-                            logMsgf(
-                                "upload|%s|%zu", 
-                                upload.filename.c_str(),
-                                upload.totalSize
-                            );
-
-                            // these probably won't ever be used, but for a 
-                            // complete implementation, these should be here
-                            server.sendHeader("Location","/success.html");
-                            server.send(303);
-                        } else {
-                            server.send(
-                                500, 
-                                "text/plain", 
-                                "500: couldn't create file"
-                            );
-                        }
-                    }
-                    break;
-                default:
-                    {
-                        server.send(
-                            500,
-                            "text/plain",
-                            "500: error creating file"
-                        );
-                    }
+            for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+                if (!fromAddr || (fromAddr & (1 << i))) {
+                    sseClients[i].needsFull = true;
+                }
             }
         }
+        triggerSendStatusEvent();
+    }
+    
+    sendOkStatusMessage();
+}
+
+/**
+ * /hold API
+ * 
+ * GET /hold
+ *      returns the current hold days
+ * 
+ * GET /hold/{}
+ *      sets hold days as follows:
+ *          0: hold not active
+ *        > 0: do not run any cycle for the given number of days
+ *        < 0: indefinite hold (typically just use -1)
+ */
+void SprinklerAPI::handleHold() {
+    String holdStr; 
+
+    if (holdDays < 0) {
+        holdStr = "system off";
+    } else if (holdDays == 0) {
+        holdStr = "no hold active";
+    } else {
+        holdStr = epochTimeAsString(holdEpoch);
+    }
+
+    sendFormatted(
+        "{\"status\": \"ok\", \"holdDays\": %i, \"resume\": \"%s\"}",
+        holdDays,
+        holdStr.c_str()
     );
+}
 
-    LOG_DEBUG("/upload\n");
+void SprinklerAPI::handleSetHold() {
+    String holdVal = server.pathArg(0);
 
-    /**
-     * API: /rm/{}
-     * 
-     * Removes a file from the on-board filesystem.
-     * THERE IS NO RECOURSE AFTER REMOVING A FILE, 
-     * nor is there any confirmation.
-     */
-    server.on(UriBraces(F("/rm/{}")), HTTP_GET, [this]() {
-        String fn = server.pathArg(0);
+    if (holdVal.isEmpty()) {
+        sendMessage(
+            "{\"status\": \"error\", "
+            "\"msg\": \"hold is an integer specifying days to pause system "
+            "(-1 to turn off)\""
+        );
+        return;
+    }
 
-        if (!fn.startsWith(F("/"))) fn = "/" + fn;
+    setHoldDays(holdVal.toInt());
 
-        if (LittleFS.remove(fn)) {
-            sendOkStatusMessage();
-        } else {
-            sendMessage(
-                "{\"status\": \"error\", "
-                "\"msg\": \"file not found\"}"
-            );
-        }
-    });
+    String holdStr;
 
-    LOG_DEBUG("/rm/{}\n");
+    if (holdDays < 0) {
+        holdStr = "system off";
+    } else if (holdDays == 0) {
+        holdStr = "no hold active - system on";
+    } else {
+        holdStr = epochTimeAsString(holdEpoch);
+    }
 
-    /*
-     * todo - delete this function when this kind of testing is no longer needed
-     */
-    server.on(F("/shouldRun"), HTTP_GET, [this]() {
-        bool val = shouldRunNextCycle();
-        sendFormatted("%s",(val) ? "true" : "false");
-    });
+    LOG_DEBUG(
+        "holdDays=%i holdEpoch=%lu (%s)\n", 
+        holdDays, 
+        holdEpoch,
+        holdStr.c_str()
+    );
 
-    LOG_DEBUG("/shouldRun\n");
+    // sending a message back to the client terminates the request
+    sendFormatted(
+        "{\"status\": \"ok\", \"holdDays\": %i, \"resume\": \"%s\"}",
+        holdDays,
+        holdStr.c_str()
+    );
 
-    /**
-     * /calc API - causes the calcNextCycleStart() function to be invoked.
-     * 
-     * This API is useful for testing purposes, so it will be retained.
-     * Unlike most APIs, it returns the cycles' status message, which makes
-     * sense since we are calculating the next cycle start, so we want to see
-     * how that turned out.
-     */
-    server.on(F("/calc"), HTTP_GET, [this]() {
-        calcNextCycleStart();
-        sendMessage(getCyclesStatus().c_str());
-    });
+    // this proceeds now asynchronously from the client
+    calcNextCycleStart();
+}
 
-    LOG_DEBUG("/calc\n");
+/**
+ * /debug/{} API
+ * 
+ * Injects a message straight into the Serial log.  Useful for debugging
+ * unit tests -- by allowing the unit test to inject test method names
+ * directly into the log, we can see which method is causing the board to
+ * reset (which almost always is indicative of a pointer or allocation
+ * bug that needs to be fixed).
+ */
+void SprinklerAPI::handleDebug() {
+    const String msg = server.pathArg(0);
+    Serial.printf("\n%s\n\n", server.urlDecode(msg).c_str());
+    sendOkStatusMessage();
+}
 
-    /*
-     * todo - delete this function when this kind of testing is no longer needed
-     */
-    server.on(F("/ser"), HTTP_GET, [this]() {
-        serializeCycleItems();
-        sendOkStatusMessage();
-    });
+/**
+ * /test/{}/{}/{} API
+ * 
+ * This is a test API that can be used to test getNextRunDayOffset().
+ * nextRunDayOffset=-1 means that daysBitField has no days set.
+ * It probably should be renamed and then used in unit tests (which
+ * right now are implemented in the "python" directory).
+ */
+void SprinklerAPI::handleTest() {
+    uint8_t daysBitField = server.pathArg(0).toInt();
+    int startDOW = server.pathArg(1).toInt();
+    int offset = server.pathArg(2).toInt();
+    int nextRunDayOffset = getNextRunDayOffset(daysBitField, startDOW, offset);
+    sendFormatted(
+        "daysBitField=%u startDOW=%i offset=%i nextRunDayOffset=%i\n",
+        daysBitField,
+        startDOW,
+        offset,
+        nextRunDayOffset
+    );
+}
 
-    LOG_DEBUG("/ser\n");
+void SprinklerAPI::handleSeek() {
+    uint8_t pa0 = server.pathArg(0).toInt();
+    File f = LittleFS.open("/seektest.dat", "w");
 
-    yield();
+    if (f) {
+        f.printf("line1\n");
+        f.printf("line2\n");
+    } else {
+        sendMessage("unable to open '/seektest.dat'");
+        return;
+    }
 
-    /*
-     * todo - delete this function when this kind of testing is no longer needed
-     */
-    server.on(F("/deser"), HTTP_GET, [this]() {
-        deserializeCycleItems();
-        sendOkStatusMessage();
-    });
+    f.close();
 
-    LOG_DEBUG("/deser\n");
+    File f3 = LittleFS.open("/seektest.dat", "r+");
+    // seek(0, SeekEnd) is at EOF.  Since we have "\n" at the end of each
+    // string, seek(1, SeekEnd) positions us at the linefeed character of
+    // the last line.  And seek(2, SeekEnd) positions us at the last visible
+    // byte of the file, which is the '2' in the example below.  So, if we
+    // wanted to get all the way back to the beginning of the file, we would
+    // need to seek(12, SeekEnd).      
+    //
+    // Thus if we have this data:
+    //
+    //         111
+    //         210987  <-- SeekEnd value
+    // data:   line1\n
+    //
+    //         654321  eof = 0  <-- SeekEnd value
+    // data:   line2\n
+    f3.seek(pa0, SeekEnd);
+    f3.printf("x");
+    f3.close();
 
     /*
-     * todo - delete this function when this kind of testing is no longer needed
+        this is a test function that sends /seektest.dat to the client
+        to prove that the seek worked and that bytes were overwritten.
      */
-    server.on(UriBraces("/del/{}"), HTTP_GET, [this]() {
-        String cycleName = server.urlDecode(server.pathArg(0));
-        deleteCycle(cycleName);
-        Serial.printf("delete: %s\n", cycleName.c_str());
-        for (CycleItemIterator it = cycleItems.begin(); it != cycleItems.end(); it++) {
-            Serial.println(it->cycleName);
-        }
-        sendMessage("ok");
-    });
+    File f2 = LittleFS.open("/seektest.dat", "r");
+    server.streamFile(f2, "text/plain");
+    
+    /*
+    okay, now I need to think a bit about my idea of having an interval function
+    first of all that is idempotent -- it will do the same thing no matter how many
+    times it is invoked.
+
+    And what I want is for the function to put the current date at the bottom of the
+    log file whenever the day changes.  But if the last message in the log file is a 
+    date, then I want that date to be overwritten, because I don't want to waste log
+    space if no other messages have been appended to the bottom of the file since the
+    time that the date was written.
+
+    The function is intended to be invoked using the Ticker class.  I would like
+    for the timing to be accurate, so I think the interval will have to be every second.
+
+    The function needs to be able to determine if the day has changed.  At minimum, I
+    think this means I need a static variable that keeps track of the current day number.
+
+    Then I need to invoke the time service somehow to figure out what day it is.  
+    I could use the main NTPClient and pass that to this function.  It has a getDay()
+    function that I can invoke and then watch for it to change.  However, Sunday is 0,
+    so what do we initialize the static variable to?  getDay() returns and int, so since
+    it demands a signed value, I can initialize it to -1.  
+
+    There is a version of File::readBytes() that takes a char* buffer and a length.  So,
+    if I know what I am looking for is ##/##/####, then I can read the last 10 bytes of
+    the file and see if they match.  If they do, then I don't need to write anything.  If
+    */
+}
 
-    LOG_DEBUG("/del/{}\n");
+void SprinklerAPI::handleSeekTest() {
+    static int lastDay = -1;
+    uint8_t pa0 = server.pathArg(0).toInt();
 
-    /**
-     * /clear API
-     * 
-     * Safely removes all cycles from the controller.  While not generally
-     * useful to the UI, this is useful for API testing purposes, so it will
-     * be retained permanently.
-     */
-    server.on(F("/clear"), HTTP_GET, [this]() {
-        clearCycles();
-        sendOkStatusMessage();
-    });
+    if (pa0 > 0) {
+        lastDay = timeClient.getDay();
 
-    LOG_DEBUG("/clear\n");
+        char fbuff[11];
+        File f = LittleFS.open("/seektest.dat", "r");
 
-    /*
-     * function for use with testing out using another digital pin (like D0) on
-     * the Wemos D1 mini board to see if I can inhibit all output from the shift
-     * register by pulling the Output Enable (OE) pin high
-     */
-    server.on(UriBraces("/oe/{}"), HTTP_GET, [this]() {
-        String oe = server.pathArg(0);
+        // position to the first byte of the last line
+        f.seek(6, SeekEnd);
 
-        pinMode(outputEnablePin, OUTPUT);
+        // read the last line except for the linefeed
+        size_t bytesRead = f.readBytes(fbuff, 5);
 
-        if (oe.equals("off") || oe.equals("high")) {
-            digitalWrite(outputEnablePin, HIGH);
-            Serial.printf("D0 (outputEnablePin=%u) set HIGH\n", outputEnablePin);
-        } else if (oe.equals("on") || oe.equals("low")) {
-            digitalWrite(outputEnablePin, LOW);
-            Serial.printf("D0 (outputEnablePin=%u) set LOW\n", outputEnablePin);
-        } else {
-            sendFormatted("invalid: %s", server.uri().c_str());
-            return;
-        }
-        sendFormatted("ok - /oe/%s", oe.c_str());
-    });
+        f.close();
 
-    LOG_DEBUG("/oe/{}\n");
+        // null terminate the string so we can use strcmp()
+        fbuff[bytesRead] = '\0';
 
-    server.on(F("/oe"), HTTP_GET, [this]() {
-        uint8_t retval = (uint8_t)digitalRead(outputEnablePin);
         sendFormatted(
-            "{\"status\": \"ok\", \"oe\": \"%s\"}", 
-            (retval == 1) ? "off" : "on"
+            "lastDay=%i fbuff=%s result=%s", 
+            lastDay, 
+            fbuff,
+            strcmp(fbuff, "xine2") == 0 ? "match" : "no match"
         );
-    });
+        return;
+    }
 
-    LOG_DEBUG("/oe\n");
+    sendFormatted("lastDay=%i", lastDay);
+}
 
-    yield();
+/**
+ * /tz/{} API
+ * 
+ * Sets the offset (in seconds from UTC) of the clock, that is, its time
+ * zone, which moves the clock as NTP correcting it would.  It is for
+ * testing, and isn't kept over a restart.  Returns the epoch it comes to.
+ */
+void SprinklerAPI::handleSetTz() {
+    timeClient.setTimeOffset(server.pathArg(0).toInt());
+    sendFormatted(
+        "{\"status\": \"ok\", \"epoch\": %lu}",
+        timeClient.getEpochTime()
+    );
+}
 
-    /* test API -- delete as soon as possible
-     */
-    server.on(UriBraces("/reg/{}"), HTTP_GET, [this]() {
-        uint8_t val = (uint8_t)server.pathArg(0).toInt();
-        uint8_t* retval = nullptr;
-        shiftRegister.setAll(&val);
-        checkOutputEnable();
-        retval = shiftRegister.getAll();
-        sendFormatted("ok - /reg/%u", val, *retval);
-    });
+void SprinklerAPI::handleNow() {
+    time_t tt = timeClient.getEpochTime();
+    struct tm* t = localtime(&tt);
+    FSInfo64 fsinfo;
 
-    LOG_DEBUG("/reg/{}\n");
+    LittleFS.info64(fsinfo);
 
-    /* test API -- delete as soon as possible
-     */
-    server.on(F("/reg"), HTTP_GET, [this]() {
-        uint8_t* val = shiftRegister.getAll();
-        sendFormatted("ok - getAll()=%u", *val);
-    });
+    // When we calculate a percent available disk space, the canonical formula
+    // is to divide the used bytes by the total bytes and multiply by 100.  But
+    // that will always round down (because the result is truncated to an integer
+    // type).  So, to accomplish a round up, we need to add 1/2 of 1% of the 
+    // denominator.  Thus the rounding factor is calculated as follows.  It should
+    // be added to the usedBytes before dividing by the totalBytes.
 
-    LOG_DEBUG("/reg\n");
+    uint64_t roundingFactor = fsinfo.totalBytes / 100 / 2;
+    
+    // I want a char buffer to hold a log timestamp that has this format:
+    // YYYY-MM-DD HH:MM:SS
+    // So that is 19 characters plus a null terminator, so 20 characters.
+    // (Making it 25 gives a bit of buffer in case I am wrong.)
+
+    char tsbuff[25];
+
+    strftime(tsbuff, sizeof(tsbuff), "%y-%m-%d %H:%M:%S", t);
+    sendFormatted(
+        "log ts=%s epoch=%lli totalBytes=%llu usedBytes=%llu availableBytes=%llu (%i%%)",
+        tsbuff, 
+        tt,
+        fsinfo.totalBytes,
+        fsinfo.usedBytes,
+        fsinfo.totalBytes - fsinfo.usedBytes,
 
-    server.on(UriBraces("/logic/{}"), HTTP_GET, [this]() {
-        String mode = server.pathArg(0);
-        uint8_t val;
+        // to cause the percentage to round up, add roundingFactor to the numerator
 
-        if (mode.equals("normal")) {
-            setNormalLogic(true);
-            val = 0;
-        } else
-        if (mode.equals("reversed")) {
-            setNormalLogic(false);
-            val = 255;
-        }
-        else {
-            sendFormatted(
-                "{\"status\": \"error\", \"msg\": \"invalid: %s\"}",
-                mode.c_str()
-            );
-            return;
+        ((fsinfo.totalBytes - fsinfo.usedBytes + roundingFactor) * 100) / fsinfo.totalBytes
+    );
+}
+
+bool SprinklerAPI::getNormalLogic() const {
+    return ZoneLogic_t::normal;
+}
+
+void SprinklerAPI::sendMessage(const char* s) const {
+    size_t len = strlen(s);
+
+    // the message and its newline are sent as they are instead of being
+    // copied into one String first
+    server.sendHeader(String(F("Access-Control-Allow-Methods")), String(F("GET, POST, DELETE")));
+    server.setContentLength(len + 1);
+    server.send(200, "text/plain", "");
+    server.sendContent(s, len);
+    server.sendContent("\n", 1);
+}
+
+/**
+ * SprinklerAPI::sendChunked()
+ * 
+ * Sends a response (with the same headers and trailing newline as
+ * sendMessage()) that fill writes a piece at a time.  It goes out with
+ * chunked transfer encoding as the writer's buffer fills, so its size isn't
+ * limited by msg or by free heap.
+ */
+void SprinklerAPI::sendChunked(
+    std::function<void(JsonStreamWriter& json)> fill,
+    const char* contentType
+) const {
+    server.sendHeader(String(F("Access-Control-Allow-Methods")), String(F("GET, POST, DELETE")));
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, contentType, "");
+
+    {
+        JsonStreamWriter json([this](const char* data, size_t len) {
+            server.sendContent(data, len);
+        });
+
+        fill(json);
+        json.write("\n", 1);
+    }
+
+    server.sendContent("");
+}
+
+void SprinklerAPI::sendOkStatusMessage() const {
+    sendMessage("{\"status\": \"ok\"}");
+}
+
+template<typename... Args> 
+void SprinklerAPI::sendFormatted(const char* fmt, Args... vars) {
+    snprintf(
+        this->msg,
+        sizeof(this->msg),
+        fmt,
+        vars...
+    );
+    sendMessage(this->msg);
+}
+
+void SprinklerAPI::sendServerUriNotFound() {
+    snprintf(
+        msg,
+        sizeof(msg),
+        "{\"status\": \"error\", \"msg\": \"not found: %s\"}", 
+        server.uri().c_str()
+    );
+    sendMessage(msg);
+}
+
+void SprinklerAPI::sendLog() const {
+    if (logger.exists()) {
+        logger.send(server);
+    } else {
+        sendMessage(
+            "{\"status\": \"error\", "
+            "\"msg\": \"the log is empty\"}"
+        );
+    }
+}
+
+/**
+ * SprinklerAPI::sendLogQuery()
+ * 
+ * Sends the log records selected by the query args, all of which are
+ * optional:
+ * 
+ *      since, until - epoch times (in local time, like "startEpoch" of
+ *                     /cycles); a negative value is that many seconds ago
+ *      op           - on, off, or the first field of any other message
+ *                     (e.g. schd, cycle, mark)
+ *      zone         - only zone changes that include this zone
+ *      limit        - the page size (default 100, at most 500)
+ *      from         - the sequence number to start at, which is the "next"
+ *                     of the previous page
+ */
+void SprinklerAPI::sendLogQuery() {
+    LogQuery_t query;
+    long nowEpoch = (long)timeClient.getEpochTime();
+
+    auto epochArg = [&](const char* name, unsigned long defaultValue) {
+        if (!server.hasArg(name)) {
+            return defaultValue;
         }
 
-        shiftRegister.setAll(&val);
-        checkOutputEnable();
-        sendOkStatusMessage();
-    });
+        long value = server.arg(name).toInt();
 
-    LOG_DEBUG("/logic/{}\n");
+        return (unsigned long)((value < 0) ? nowEpoch + value : value);
+    };
 
-    server.on(F("/logic"), HTTP_GET, [this]() {
-        sendFormatted(
-            "{\"status\": \"ok\", \"logic\": \"%s\"}",
-            (getNormalLogic()) ? "normal" : "reversed"
-        );
-    });
+    query.since = epochArg("since", 0);
+    query.until = epochArg("until", ULONG_MAX);
+    query.from = strtoul(server.arg("from").c_str(), NULL, 10);
+    query.zone = (uint8_t)server.arg("zone").toInt();
+    strncpy(query.op, server.arg("op").c_str(), sizeof(query.op) - 1);
 
-    LOG_DEBUG("/logic\n");
+    if (server.hasArg("limit")) {
+        long limit = server.arg("limit").toInt();
 
-    server.on(F("/adj"), HTTP_GET, [this]() {
-        sendFormatted(
-            "{\"status\": \"ok\", \"adj\": \"%u\"}",
-            getSeasonalAdjustment()
-        );
-    });
+        query.limit = (limit < 1) ? 1 : (limit > 500) ? 500 : (size_t)limit;
+    }
 
-    LOG_DEBUG("/adj\n");
+    logger.query(server, query);
+}
 
-    yield();
+/**
+ * SprinklerAPI::sendStatusEvent()
+ * 
+ * Sends a status event to the SSE client.  The first event after a client
+ * connects (or after /sse/full) is the full status:
+ * 
+ *      data: {"version": 7, "apiStatus": {...}}
+ * 
+ * and every event after that carries only the members that changed since
+ * the event before it:
+ * 
+ *      data: {"version": 8, "apiDelta": {"time": "08:31:00", "on": [2]}}
+ * 
+ * A client that sees a version that doesn't follow the last one it merged
+ * has missed an event and should ask for a full one with /sse/full.
+ * 
+ * A subscriber that an event was dropped for is skipped until its buffer
+ * drains, and is then sent the full status on its own (see
+ * sendFullStatusEvent()).
+ */
+void SprinklerAPI::sendStatusEvent() {
+    uint8_t fullTargets = 0;
+    uint8_t deltaTargets = 0;
+    uint8_t dropped = 0;
+    StatusValues_t values;
 
-    server.on(UriBraces("/adj/{}"), HTTP_GET, [this]() {
-        String adjString = server.pathArg(0);
-        long adj = adjString.toInt();
+    shouldSendStatusEvent = false;
 
-        if (adjString.isEmpty()) {
-            sendFormatted(
-                "{\"status\": \"error\", \"msg\": \"invalid: %s\"}",
-                "must supply seasonalAdjustment value"
-            );
-            return;
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sseClients[i].active && !sseClients[i].behind) {
+            if (sseClients[i].needsFull) {
+                fullTargets |= 1 << i;
+            } else {
+                deltaTargets |= 1 << i;
+            }
         }
+    }
 
-        if (adj < 1 || adj > 255) {
-            sendFormatted(
-                "{\"status\": \"error\", \"msg\": \"invalid seasonalAdjust value: %s - %s\"}",
-                adjString.c_str(),
-                "must be between 1 and 255"
-            );
-            return;
-        }
+    if (!getSseSubscribers()) {
+        LOG_DEBUG("sendStatusEvent(): no clients\n");
+        sseTicker.detach();
+        return;
+    }
 
-        setSeasonalAdjustment((uint8_t)adj);
-        sendFormatted(
-            "{\"status\": \"ok\", \"adj\": \"%u\"}",
-            getSeasonalAdjustment()
-        );
-    });
+    refreshStatus();
+    getStatusValues(values);
+    statusVersion++;
+    sseEventId++;
 
-    LOG_DEBUG("/adj/{}\n");
+    // every subscriber gets the same event: the full status for the ones
+    // that need it, and the delta for the rest.  The delta is rendered even
+    // when no subscriber gets it now so that it can be replayed.
 
-    server.on(F("/check"), HTTP_GET, [this]() {
-        checkOutputEnable();
-        sendOkStatusMessage();
-    });
+    String delta((char *)0);
 
-    LOG_DEBUG("/check\n");
+    for (uint8_t full = 0; full < 2; full++) {
+        uint8_t targets = (full) ? fullTargets : deltaTargets;
+        char head[80];
+        int headLen;
 
-    /* Set up the Server-Sent Event channel.  Invoker simply sends a GET
-     * request to this URL and then the controller will send events to
-     * that client until a new client is established.  Each time this URL is
-     * invoked, the client will update to the new one.
-     */
-    server.on(F("/sse"), HTTP_GET, [this]() {
-        sseClient = server.client();
+        if (full && !targets) {
+            continue;
+        }
 
-        if (sseClient && sseClient.connected()) {
-            LOG_DEBUG(
-                "client connected - ip addr: %s\n",
-                sseClient.remoteIP().toString().c_str()
-            );
+        sseBeginEvent(targets);
+
+        headLen = snprintf(
+            head,
+            sizeof(head),
+            "id: %08lx-%lu\ndata: {\"version\": %lu, \"%s\": ",
+            (unsigned long)bootTag,
+            (unsigned long)sseEventId,
+            (unsigned long)statusVersion,
+            (full) ? "apiStatus" : "apiDelta"
+        );
+        sseWrite(targets, head, headLen);
 
-            // I referenced these two guides when coming up with my own
-            // implementation:
-            // https://github.com/IU5HKU/ESP8266-ServerSentEvents/blob/master/ESP8266_ServerSentEvents/ESP8266_ServerSentEvents.ino
-            // https://developer.mozilla.org/en-US/docs/Web/API/Server-sent_events/Using_server-sent_events
-
-            sseClient.println("HTTP/1.1 200 OK");
-            sseClient.println("Content-Type: text/event-stream;charset=UTF-8");
-            sseClient.println("Access-Control-Allow-Origin: *");  
-            sseClient.println("Cache-Control: no-cache");  
-            sseClient.println();
-            sseClient.flush();
-
-            // Align the ticker at the top of minute boundary so that a status
-            // event message is always sent at the top of the new minute.
-            // I chose to use localtime() to determine the seconds from the
-            // retrieved epoch time instead of using NTPClient::getSeconds()
-            // because the latter re-invokes getEpochTime() which takes the
-            // movement of millis() into account.  I want the seconds to be
-            // calculated directly off the epochTime value without drift, so
-            // that can only be done using localtime().
-
-            time_t tt = timeClient.getEpochTime();
-            struct tm* t = localtime(&tt);
-            int run_secs = 60 - t->tm_sec;
-            char buff[11];  
-
-            strftime(buff, 10, "%H:%M:%S", t);
-
-            LOG_DEBUG("/sse time: %s\n", buff);
-            LOG_DEBUG("sseTicker.once() in %i secs\n", run_secs);
-
-            sseTicker.once(run_secs, [this]() {
-                // send a status event now and then the next one will be sent
-                // on the regular cycle of every minute
+        if (!full) {
+            delta.reserve(256);
+            delta.concat(head, headLen);
+        }
 
-                triggerSendStatusEvent();
+        {
+            JsonStreamWriter json([this, targets, full, &delta](const char* data, size_t len) {
+                sseWrite(targets, data, len);
 
-                sseTicker.attach(60, [this]() {
-                    triggerSendStatusEvent();
-                });
+                if (!full) {
+                    delta.concat(data, len);
+                }
             });
 
-            // immediately acknowledge the connection by sending a status
-            // event message
-            triggerSendStatusEvent();
+            if (full) {
+                writeAPIStatus(json, values, nullptr, statusAll);
+            } else {
+                writeAPIStatus(json, values, &lastStatusValues, statusEventDirty);
+            }
         }
-    });
+        sseWrite(targets, "}\r\n\r\n", 5);
+        dropped |= sseEndEvent(targets);
+    }
 
-    LOG_DEBUG("/sse\n");
-
-    /**
-     * /sse/{} API
-     * 
-     * This is a testing API, but probably worth keeping around.  It has two
-     * purposes:  1) force the sending of a status event message, and
-     * 2) manually terminate the sseTicker (which is useful for turning off
-     * the automatic updates to the UI so that you can manually work with the
-     * HTML of the UI in a web browser without updates constantly occurring
-     * because the ticker is running).
-     * 
-     * Right now, if you make the parameter any value, it will just be logged,
-     * unless you use the special value "stop", which is both logged and then
-     * the sseTicker is terminated.
-     */
-    server.on(UriBraces("/sse/{}"), HTTP_GET, [this]() {
-        String s = server.pathArg(0);
+    delta.concat("}\r\n\r\n", 5);
+    rememberSseEvent(sseEventId, false, delta);
 
-        LOG_DEBUG(
-            "client connected = %s msg = %s\n", 
-            (sseClient.connected()) ? "yes" : "no",
-            s.c_str()
-        );
+    // a subscriber that the event was dropped for even though its buffer
+    // was empty (the heap had no room for the spill) would only have it
+    // dropped again once its buffer drains, so it is left for the next
+    // status event instead
+
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (dropped & (1 << i)) {
+            sseClients[i].needsFull = true;
+            sseClients[i].behind = !sseClients[i].eventSpills;
+        } else if ((fullTargets | deltaTargets) & (1 << i)) {
+            sseClients[i].needsFull = false;
+        }
+    }
+    lastStatusValues = values;
+    statusEventDirty = 0;
 
-        if (s.equals("stop")) {
-            sseTicker.detach();
+    LOG_DEBUG(
+        "sendStatusEvent(): version %lu sent to %u full, %u delta\n",
+        (unsigned long)statusVersion,
+        __builtin_popcount(fullTargets),
+        __builtin_popcount(deltaTargets)
+    );
+}
 
-            sendCustomServerEvent("stop", (const char *)NULL);
+/**
+ * SprinklerAPI::sendFullStatusEvent()
+ * 
+ * Sends the full status to subscriber i, once its buffer has drained after
+ * a status event was dropped for it (see sseDrain()).  It is sent as the
+ * latest status event (its version and id), so nothing changes for the
+ * other subscribers, and the next status event is the delta that follows
+ * it for every subscriber alike.  The buffer is empty, so the event can
+ * only be dropped if the heap has no room for it, in which case it is left
+ * for the next status event.
+ */
+void SprinklerAPI::sendFullStatusEvent(uint8_t i) {
+    StatusValues_t values;
+    char head[80];
+    int headLen;
+
+    refreshStatus();
+    getStatusValues(values);
+
+    headLen = snprintf(
+        head,
+        sizeof(head),
+        "id: %08lx-%lu\ndata: {\"version\": %lu, \"apiStatus\": ",
+        (unsigned long)bootTag,
+        (unsigned long)sseEventId,
+        (unsigned long)statusVersion
+    );
 
-            LOG_DEBUG("sseTicker detached\n");
-        } else {
-            triggerSendStatusEvent();
-        }
-        
-        sendOkStatusMessage();
-    });
+    sseBeginEvent(1 << i);
+    sseWrite(1 << i, head, headLen);
 
-    LOG_DEBUG("/sse/{}\n");
-
-    /**
-     * /hold API
-     * 
-     * GET /hold
-     *      returns the current hold days
-     * 
-     * GET /hold/{}
-     *      sets hold days as follows:
-     *          0: hold not active
-     *        > 0: do not run any cycle for the given number of days
-     *        < 0: indefinite hold (typically just use -1)
-     */
+    {
+        JsonStreamWriter json([this, i](const char* data, size_t len) {
+            sseWrite(1 << i, data, len);
+        });
 
-    server.on(F("/hold"), HTTP_GET, [this]() {
-        String holdStr; 
+        writeAPIStatus(json, values, nullptr, statusAll);
+    }
+    sseWrite(1 << i, "}\r\n\r\n", 5);
 
-        if (holdDays < 0) {
-            holdStr = "system off";
-        } else if (holdDays == 0) {
-            holdStr = "no hold active";
-        } else {
-            holdStr = epochTimeAsString(holdEpoch);
-        }
+    sseClients[i].needsFull = sseEndEvent(1 << i) != 0;
+}
 
-        sendFormatted(
-            "{\"status\": \"ok\", \"holdDays\": %i, \"resume\": \"%s\"}",
-            holdDays,
-            holdStr.c_str()
-        );
-    });
+/**
+ * SprinklerAPI::sendCustomServerEvent()
+ * 
+ * Permits the construction of a custom Server Sent Event.  A custom event
+ * looks like this:
+ * 
+ *      event: event_name
+ *      data: {"key": "json data"}
+ *      id: some_id_value
+ *      \n
+ *      \n
+ * 
+ * The "id" portion of the message is optional, and there is no need for it
+ * right now.
+ * 
+ * The main purpose for this function is to send a "stop" event.  For the
+ * stop event, the event name is enough; data can be left empty (set it to
+ * null).
+*/
+void SprinklerAPI::sendCustomServerEvent(const char* eventName, const char* data) {
+    sendServerEvent(getSseSubscribers(), eventName, data);
+}
 
-    LOG_DEBUG("/hold\n");
+/**
+ * SprinklerAPI::sendServerEvent()
+ * 
+ * Sends a custom event (see sendCustomServerEvent()) to the subscribers in
+ * targets, a bit mask of sseClients.
+ */
+void SprinklerAPI::sendServerEvent(uint8_t targets, const char* eventName, const char* data) {
+    if (!targets) {
+        LOG_DEBUG("sendServerEvent('%s') ignored\n", eventName);
+        return;
+    }
 
-    yield();
+    const char* parts[] = {"event: ", eventName, "\ndata: ", (data) ? data : "{}", "\n\r\n\r\n"};
 
-    server.on(UriBraces(F("/hold/{}")), HTTP_GET, [this]() {
-        String holdVal = server.pathArg(0);
+    sseBeginEvent(targets);
+    for (const char* part : parts) {
+        sseWrite(targets, part, strlen(part));
+    }
+    sseEndEvent(targets);
 
-        if (holdVal.isEmpty()) {
-            sendMessage(
-                "{\"status\": \"error\", "
-                "\"msg\": \"hold is an integer specifying days to pause system "
-                "(-1 to turn off)\""
-            );
-            return;
-        }
+    if (data) {
+        LOG_DEBUG("sendServerEvent('%s', '%s')\n", eventName, data);
+    } else {
+        LOG_DEBUG("sendServerEvent('%s', null)\n", eventName);
+    }
+}
 
-        setHoldDays(holdVal.toInt());
+/**
+ * SprinklerAPI::sendLogEvent()
+ * 
+ * Sends a log record to the SSE clients subscribed to the log as a "log"
+ * event, which is kept for replay (see SseReplayEvent_t) even if there are
+ * no subscribers right now:
+ * 
+ *      event: log
+ *      data: {"seq": 12, "line": "0824 183500|on|2|253"}
+ * 
+ * Subscribers that are still being sent records from the log are left to
+ * reach this one that way (see sseLogCatchUp()), as is a subscriber that
+ * this event is dropped for.
+ */
+void SprinklerAPI::sendLogEvent(const LogRecord_t& rec) {
+    char data[2 * LOG_TEXT_MAX];
+    char id[32];
 
-        String holdStr;
+    size_t len = rec.toJson(data, sizeof(data));
+    String text((char *)0);
 
-        if (holdDays < 0) {
-            holdStr = "system off";
-        } else if (holdDays == 0) {
-            holdStr = "no hold active - system on";
-        } else {
-            holdStr = epochTimeAsString(holdEpoch);
+    if (len == 0) {
+        return;
+    }
+
+    snprintf(id, sizeof(id), "id: %08lx-%lu\n", (unsigned long)bootTag, (unsigned long)++sseEventId);
+    text.reserve(len + 48);
+    text = id;
+    text += "event: log\ndata: ";
+    text.concat(data, len);
+    text += "\n\r\n\r\n";
+
+    uint8_t targets = 0;
+
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sseClients[i].active && sseClients[i].log &&
+            sseClients[i].logFrom == SseSubscriber_t::noLogFrom) {
+            targets |= 1 << i;
         }
+    }
 
-        LOG_DEBUG(
-            "holdDays=%i holdEpoch=%lu (%s)\n", 
-            holdDays, 
-            holdEpoch,
-            holdStr.c_str()
-        );
+    if (targets) {
+        sseBeginEvent(targets);
+        sseWrite(targets, text.c_str(), text.length());
 
-        // sending a message back to the client terminates the request
-        sendFormatted(
-            "{\"status\": \"ok\", \"holdDays\": %i, \"resume\": \"%s\"}",
-            holdDays,
-            holdStr.c_str()
-        );
+        uint8_t dropped = sseEndEvent(targets);
 
-        // these proceed now asynchronously from the client
-        calcNextCycleStart();
-        serializeCycleItems();
-    });
+        for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+            if (dropped & (1 << i)) {
+                sseClients[i].logFrom = rec.seq;
+            }
+        }
+    }
 
-    LOG_DEBUG("/hold/{}\n");
+    rememberSseEvent(sseEventId, true, text, rec.seq);
+}
 
-    /**
-     * /debug/{} API
-     * 
-     * Injects a message straight into the Serial log.  Useful for debugging
-     * unit tests -- by allowing the unit test to inject test method names
-     * directly into the log, we can see which method is causing the board to
-     * reset (which almost always is indicative of a pointer or allocation
-     * bug that needs to be fixed).
-     */
+/**
+ * SprinklerAPI::sseLogCatchUp()
+ * 
+ * Queues the records still in the log from subscriber i's logFrom on as
+ * "log" events, for as many as fit in its buffer.  The rest are queued by a
+ * later call as the buffer drains; once the last record is queued, the
+ * subscriber is sent log events as they are logged again.
+ * 
+ * A record whose log event is still kept for replay is sent with that
+ * event's id, so that a client reconnecting after it isn't replayed the
+ * event again.  Older records have no id to send (a replay can't resend
+ * them anyway).
+ */
+void SprinklerAPI::sseLogCatchUp(uint8_t i) {
+    SseSubscriber_t& sub = sseClients[i];
+    SprinklerLog::Reader reader(logger, logger.findSegment(0, sub.logFrom));
+    LogRecord_t rec;
+    char data[2 * LOG_TEXT_MAX];
 
-    server.on(UriBraces(F("/debug/{}")), HTTP_GET, [this]() {
-        const String msg = server.pathArg(0);
-        Serial.printf("\n%s\n\n", server.urlDecode(msg).c_str());
-        sendOkStatusMessage();
-    });
+    while (reader.next(rec)) {
+        size_t len;
 
-    LOG_DEBUG("/debug/{}\n");
+        if (rec.seq < sub.logFrom || (len = rec.toJson(data, sizeof(data))) == 0) {
+            continue;
+        }
 
-    /**
-     * /test/{}/{}/{} API
-     * 
-     * This is a test API that can be used to test getNextRunDayOffset().
-     * It probably should be renamed and then used in unit tests (which
-     * right now are implemented in the "python" directory).
-     */
+        uint32_t id = getLogEventId(rec.seq);
 
-    server.on(UriBraces(F("/test/{}/{}/{}")), HTTP_GET, [this]() {
-        uint8_t daysBitField = server.pathArg(0).toInt();
-        int startDOW = server.pathArg(1).toInt();
-        int offset = server.pathArg(2).toInt();
-        int nextRunDayOffset = getNextRunDayOffset(daysBitField, startDOW, offset);
-        sendFormatted(
-            "daysBitField=%u startDOW=%i offset=%i nextRunDayOffset=%i\n",
-            daysBitField,
-            startDOW,
-            offset,
-            nextRunDayOffset
-        );
-    });
+        sub.beginEvent();
 
-    LOG_DEBUG("/test/{}/{}/{}\n");
+        if (id) {
+            char line[32];
 
-    server.on(UriBraces(F("/seek/{}")), HTTP_GET, [this]() {
-        uint8_t pa0 = server.pathArg(0).toInt();
-        File f = LittleFS.open("/seektest.dat", "w");
+            sub.write(
+                line,
+                snprintf(line, sizeof(line), "id: %08lx-%lu\n", (unsigned long)bootTag, (unsigned long)id)
+            );
+        }
+        sub.write("event: log\ndata: ", 17);
+        sub.write(data, len);
+        sub.write("\n\r\n\r\n", 5);
 
-        if (f) {
-            f.printf("line1\n");
-            f.printf("line2\n");
-        } else {
-            sendMessage("unable to open '/seektest.dat'");
+        if (!sub.endEvent()) {
+            sub.logFrom = rec.seq;
             return;
         }
+    }
 
-        f.close();
-
-        File f3 = LittleFS.open("/seektest.dat", "r+");
-        // seek(0, SeekEnd) is at EOF.  Since we have "\n" at the end of each
-        // string, seek(1, SeekEnd) positions us at the linefeed character of
-        // the last line.  And seek(2, SeekEnd) positions us at the last visible
-        // byte of the file, which is the '2' in the example below.  So, if we
-        // wanted to get all the way back to the beginning of the file, we would
-        // need to seek(12, SeekEnd).      
-        //
-        // Thus if we have this data:
-        //
-        //         111
-        //         210987  <-- SeekEnd value
-        // data:   line1\n
-        //
-        //         654321  eof = 0  <-- SeekEnd value
-        // data:   line2\n
-        f3.seek(pa0, SeekEnd);
-        f3.printf("x");
-        f3.close();
-
-        /*
-            this is a test function that sends /seektest.dat to the client
-            to prove that the seek worked and that bytes were overwritten.
-         */
-        File f2 = LittleFS.open("/seektest.dat", "r");
-        server.streamFile(f2, "text/plain");
-        f2.close();
-        
-        /*
-        okay, now I need to think a bit about my idea of having an interval function
-        first of all that is idempotent -- it will do the same thing no matter how many
-        times it is invoked.
-
-        And what I want is for the function to put the current date at the bottom of the
-        log file whenever the day changes.  But if the last message in the log file is a 
-        date, then I want that date to be overwritten, because I don't want to waste log
-        space if no other messages have been appended to the bottom of the file since the
-        time that the date was written.
-
-        The function is intended to be invoked using the Ticker class.  I would like
-        for the timing to be accurate, so I think the interval will have to be every second.
-
-        The function needs to be able to determine if the day has changed.  At minimum, I
-        think this means I need a static variable that keeps track of the current day number.
-
-        Then I need to invoke the time service somehow to figure out what day it is.  
-        I could use the main NTPClient and pass that to this function.  It has a getDay()
-        function that I can invoke and then watch for it to change.  However, Sunday is 0,
-        so what do we initialize the static variable to?  getDay() returns and int, so since
-        it demands a signed value, I can initialize it to -1.  
-
-        There is a version of File::readBytes() that takes a char* buffer and a length.  So,
-        if I know what I am looking for is ##/##/####, then I can read the last 10 bytes of
-        the file and see if they match.  If they do, then I don't need to write anything.  If
-        */
-    });
+    sub.logFrom = SseSubscriber_t::noLogFrom;
+}
 
-    LOG_DEBUG("/seek/{}\n");
+/**
+ * SprinklerAPI::rememberSseEvent()
+ * 
+ * Keeps an event (its text as it was sent) for replay, dropping the oldest
+ * events to stay within SSE_REPLAY_BUFFER bytes (seq is the log record of a
+ * "log" event).  text is moved, not copied.
+ */
+void SprinklerAPI::rememberSseEvent(uint32_t id, bool log, String& text, uint32_t seq) {
+    if (text.length() > SSE_REPLAY_BUFFER) {
+        sseReplay.clear();
+        sseReplaySize = 0;
+        return;
+    }
 
-    server.on(UriBraces(F("/seektest/{}")), HTTP_GET, [this]() {
-        static int lastDay = -1;
-        uint8_t pa0 = server.pathArg(0).toInt();
+    while (sseReplaySize + text.length() > SSE_REPLAY_BUFFER) {
+        sseReplaySize -= sseReplay.front().text.length();
+        sseReplay.pop_front();
+    }
 
-        if (pa0 > 0) {
-            lastDay = timeClient.getDay();
+    sseReplaySize += text.length();
+    sseReplay.push_back({id, log, seq, std::move(text)});
+}
 
-            char fbuff[11];
-            File f = LittleFS.open("/seektest.dat", "r");
+/**
+ * SprinklerAPI::getLogEventId()
+ * 
+ * Returns the id of the log event that log record seq was sent as, if that
+ * event is still kept for replay, and 0 otherwise.
+ */
+uint32_t SprinklerAPI::getLogEventId(uint32_t seq) const {
+    for (const SseReplayEvent_t& e : sseReplay) {
+        if (e.log && e.seq == seq) {
+            return e.id;
+        }
+    }
 
-            // position to the first byte of the last line
-            f.seek(6, SeekEnd);
+    return 0;
+}
 
-            // read the last line except for the linefeed
-            size_t bytesRead = f.readBytes(fbuff, 5);
+/**
+ * SprinklerAPI::replaySseEvents()
+ * 
+ * Sends subscriber i the events that followed the event it received last
+ * (its Last-Event-ID).  Returns false, having sent nothing, when some of
+ * them are no longer kept (or the id isn't from this run of the controller,
+ * which its boot tag tells), in which case the subscriber has to start over
+ * from the full status.
+ */
+bool SprinklerAPI::replaySseEvents(uint8_t i, const String& lastEventId) {
+    char* end;
+    uint32_t tag = strtoul(lastEventId.c_str(), &end, 16);
 
-            f.close();
+    if (*end != '-' || tag != bootTag) {
+        return false;
+    }
 
-            // null terminate the string so we can use strcmp()
-            fbuff[bytesRead] = '\0';
+    uint32_t lastId = strtoul(end + 1, NULL, 10);
 
-            sendFormatted(
-                "lastDay=%i fbuff=%s result=%s", 
-                lastDay, 
-                fbuff,
-                strcmp(fbuff, "xine2") == 0 ? "match" : "no match"
-            );
-            return;
-        }
+    if (lastId > sseEventId) {
+        return false;
+    }
 
-        sendFormatted("lastDay=%i", lastDay);
-    });
+    if (lastId < sseEventId &&
+        (sseReplay.empty() || sseReplay.front().id > lastId + 1)) {
+        return false;
+    }
 
-    LOG_DEBUG("/seektest/{}\n");
+    for (const SseReplayEvent_t& e : sseReplay) {
+        if (e.id > lastId && (!e.log || sseClients[i].log)) {
+            sseBeginEvent(1 << i);
+            sseWrite(1 << i, e.text.c_str(), e.text.length());
 
-    yield();
+            if (sseEndEvent(1 << i)) {
+                return false;
+            }
+        }
+    }
 
-    server.on(F("/now"), HTTP_GET, [this]() {
-        time_t tt = timeClient.getEpochTime();
-        struct tm* t = localtime(&tt);
-        FSInfo64 fsinfo;
+    return true;
+}
 
-        LittleFS.info64(fsinfo);
+/**
+ * SprinklerAPI::addSseSubscriber()
+ * 
+ * Subscribes a client that has been sent the event stream headers and
+ * returns its index in sseClients.  Subscribers whose connections are gone
+ * are reaped first; if every place is still taken, the subscriber that has
+ * been subscribed the longest is dropped.
+ */
+int SprinklerAPI::addSseSubscriber(WiFiClient& client) {
+    int slot = -1;
 
-        // When we calculate a percent available disk space, the canonical formula
-        // is to divide the used bytes by the total bytes and multiply by 100.  But
-        // that will always round down (because the result is truncated to an integer
-        // type).  So, to accomplish a round up, we need to add 1/2 of 1% of the 
-        // denominator.  Thus the rounding factor is calculated as follows.  It should
-        // be added to the usedBytes before dividing by the totalBytes.
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sseClients[i].active && !sseClients[i].client.connected()) {
+            sseClients[i].stop();
+        }
+        if (!sseClients[i].active && slot < 0) {
+            slot = i;
+        }
+    }
 
-        uint64_t roundingFactor = fsinfo.totalBytes / 100 / 2;
-        
-        // I want a char buffer to hold a log timestamp that has this format:
-        // YYYY-MM-DD HH:MM:SS
-        // So that is 19 characters plus a null terminator, so 20 characters.
-        // (Making it 25 gives a bit of buffer in case I am wrong.)
+    if (slot < 0) {
+        slot = 0;
 
-        char tsbuff[25];
+        for (uint8_t i = 1; i < SSE_MAX_CLIENTS; i++) {
+            if (millis() - sseClients[i].since > millis() - sseClients[slot].since) {
+                slot = i;
+            }
+        }
 
-        strftime(tsbuff, sizeof(tsbuff), "%y-%m-%d %H:%M:%S", t);
-        sendFormatted(
-            "log ts=%s epoch=%lli totalBytes=%llu usedBytes=%llu availableBytes=%llu (%i%%)",
-            tsbuff, 
-            tt,
-            fsinfo.totalBytes,
-            fsinfo.usedBytes,
-            fsinfo.totalBytes - fsinfo.usedBytes,
+        LOG_DEBUG(
+            "dropping SSE client %s\n",
+            sseClients[slot].client.remoteIP().toString().c_str()
+        );
+        sseClients[slot].stop();
+    }
 
-            // to cause the percentage to round up, add roundingFactor to the numerator
+    SseSubscriber_t& sub = sseClients[slot];
 
-            ((fsinfo.totalBytes - fsinfo.usedBytes + roundingFactor) * 100) / fsinfo.totalBytes
-        );
-    });
+    sub.client = client;
+    sub.active = true;
+    sub.log = false;
+    sub.needsFull = true;
+    sub.since = millis();
+    sub.lastProgress = millis();
+    sub.drops = 0;
+    sub.buffLen = 0;
+    sub.eventStart = 0;
 
-    LOG_DEBUG("/now\n");
+    return slot;
 }
 
-bool SprinklerAPI::getNormalLogic() const {
-    return normalLogic;
-}
+// the subscribers (of log events, if logOnly) as a bit mask of sseClients
+uint8_t SprinklerAPI::getSseSubscribers(bool logOnly) const {
+    uint8_t subscribers = 0;
 
-void SprinklerAPI::setNormalLogic(bool setting) {
-    normalLogic = setting;
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (sseClients[i].active && (sseClients[i].log || !logOnly)) {
+            subscribers |= 1 << i;
+        }
+    }
+    return subscribers;
 }
 
-void SprinklerAPI::sendMessage(const char* s) const {
-    String ss;
-    if (ss.reserve(strlen(s) + 1)) {
-        ss = s;
-        ss += '\n';
+// starts an event for the subscribers in targets (see sseEndEvent())
+void SprinklerAPI::sseBeginEvent(uint8_t targets) {
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if ((targets & (1 << i)) && sseClients[i].active) {
+            sseClients[i].beginEvent();
+        }
     }
-    server.sendHeader(String(F("Access-Control-Allow-Methods")), String(F("GET, POST, DELETE")));
-    server.send(200, "text/plain", ss);
 }
 
-void SprinklerAPI::sendOkStatusMessage() const {
-    sendMessage("{\"status\": \"ok\"}");
+void SprinklerAPI::sseWrite(uint8_t targets, const char* data, size_t len) {
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if ((targets & (1 << i)) && sseClients[i].active) {
+            sseClients[i].write(data, len);
+        }
+    }
 }
 
-template<typename... Args> 
-void SprinklerAPI::sendFormatted(const char* fmt, Args... vars) {
-     sprintf(
-        this->msg,
-        fmt,
-        vars...
-    );
-    sendMessage(this->msg);
-}
+/**
+ * SprinklerAPI::sseEndEvent()
+ * 
+ * Finishes the event started by sseBeginEvent() and returns the subscribers
+ * it was dropped for (as a bit mask of sseClients) because it didn't fit in
+ * their buffers.  The drops are counted; it is up to the caller to make up
+ * for them.
+ */
+uint8_t SprinklerAPI::sseEndEvent(uint8_t targets) {
+    uint8_t dropped = 0;
 
-void SprinklerAPI::sendServerUriNotFound() {
-    sprintf(
-        msg,
-        "{\"status\": \"error\", \"msg\": \"not found: %s\"}", 
-        server.uri().c_str()
-    );
-    sendMessage(msg);
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if ((targets & (1 << i)) && sseClients[i].active && !sseClients[i].endEvent()) {
+            dropped |= 1 << i;
+            sseDrops++;
+            LOG_DEBUG(
+                "SSE event dropped for %s (%u drops)\n",
+                sseClients[i].client.remoteIP().toString().c_str(),
+                (unsigned)sseClients[i].drops
+            );
+        }
+    }
+    return dropped;
 }
 
-void SprinklerAPI::sendLog() const {
-    File f = LittleFS.open("/log.dat", "r");
+/**
+ * SprinklerAPI::sseDrain()
+ * 
+ * Invoked by loop() to send each subscriber as much of its buffer as its
+ * connection takes without blocking.  A subscriber whose buffer has drained
+ * after a status event was dropped for it gets the full status, and one
+ * that is behind on the log gets the next records from it.  Subscribers
+ * that are gone or stalled are stopped, and the ticker along with the last
+ * of them.
+ */
+void SprinklerAPI::sseDrain() {
+    bool stopped = false;
 
-    if (f) {
-        server.streamFile(f, "text/plain");
-        f.close();
-    } else {
-        sendMessage(
-            "{\"status\": \"error\", "
-            "\"msg\": \"file '/log.dat' not found\"}"
-        );
-    }
-}
+    for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+        SseSubscriber_t& sub = sseClients[i];
 
-void SprinklerAPI::sendStatusEvent() {
-    if (sseClient.availableForWrite()) {
-        sseClient.printf(
-            "data: {"
-            "\"apiStatus\": %s"
-            "}",
-            getAPIStatus()
-        );
-        sseClient.println();
-        sseClient.println();
-        sseClient.flush();
+        if (!sub.active) {
+            continue;
+        }
 
-        LOG_DEBUG(
-            "sendStatusEvent(): event sent successfully to %s\n",
-            sseClient.remoteIP().toString().c_str()
-        );
-    } else {
-        LOG_DEBUG(
-            "sendStatusEvent(): sseClient not available for write\n"
-        );
-        sseClient.stop();
+        if (!sub.drain()) {
+            LOG_DEBUG(
+                "SSE client %s %s\n",
+                sub.client.remoteIP().toString().c_str(),
+                (sub.client.connected()) ? "stalled" : "disconnected"
+            );
+            sub.stop();
+            stopped = true;
+            continue;
+        }
+
+        if (sub.queued() == 0 && sub.behind) {
+            sub.behind = false;
+            sendFullStatusEvent(i);
+        }
 
+        if (sub.logFrom != SseSubscriber_t::noLogFrom && sub.queued() < sizeof(sub.buff) / 2) {
+            sseLogCatchUp(i);
+        }
+    }
+
+    if (stopped && !getSseSubscribers()) {
         sseTicker.detach();
         LOG_DEBUG("sseTicker stopped\n");
     }
-    shouldSendStatusEvent = false;
+}
+
+void SprinklerAPI::triggerSendStatusEvent() {
+    shouldSendStatusEvent = true;
+    LOG_DEBUG("triggerSendStatusEvent() called\n");
 }
 
 /**
- * SprinklerAPI::sendCustomServerEvent()
+ * SprinklerAPI::markStatusDirty()
  * 
- * Permits the construction of a custom Server Sent Event.  A custom event
- * looks like this:
+ * Marks sections of the cached status as out of date.  Nothing is rebuilt
+ * here, so it is cheap to call wherever the state behind a section changes
+ * (even several times for one change).  Every change to the state (the
+ * cycles included) passes through here, so it also moves stateGeneration
+ * on.
+ */
+void SprinklerAPI::markStatusDirty(uint8_t sections) {
+    statusDirty |= sections;
+    statusEventDirty |= sections;
+    stateGeneration++;
+    server.wakeParked();
+}
+
+/**
+ * SprinklerAPI::getStateVersion()
  * 
- *      event: event_name
- *      data: {"key": "json data"}
- *      id: some_id_value
- *      \n
- *      \n
+ * The version of the state:  the boot tag and the state generation, as
+ * "<boot tag in hex>-<generation>".
+ */
+void SprinklerAPI::getStateVersion(char* version, size_t size) const {
+    snprintf(
+        version,
+        size,
+        "%08lx-%lu",
+        (unsigned long)bootTag,
+        (unsigned long)stateGeneration
+    );
+}
+
+/**
+ * SprinklerAPI::stateNotModified()
  * 
- * The "id" portion of the message is optional, and there is no need for it
- * right now.
+ * Conditional GET for the responses that are only rendered from the state
+ * (/status, /cycles and /cycle/{}):  they get an ETag of the state
+ * generation, and if the client already has it (If-None-Match) they are
+ * answered with a 304 right here, before any of the work of rendering
+ * them, and true is returned.
  * 
- * The main purpose for this function is to send a "stop" event.  For the
- * stop event, the event name is enough; data can be left empty (set it to
- * null).
-*/
-void SprinklerAPI::sendCustomServerEvent(const char* eventName, const char* data) {
-    if (sseClient.availableForWrite()) {
-        sseClient.printf(
-            "event: %s\n"
-            "data: %s\n",
-            eventName,
-            (data) ? data : "{}"
+ * The ETag is weak because the clock, heap, timer and disk space values
+ * that these responses also have aren't part of it -- a 304 means that the
+ * zones, schedule and cycles are as they were.
+ */
+bool SprinklerAPI::stateNotModified() {
+    char version[24];
+    char etag[32];
+
+    getStateVersion(version, sizeof(version));
+    snprintf(etag, sizeof(etag), "W/\"%s\"", version);
+
+    return server.notModified(etag, "no-cache");
+}
+
+/**
+ * SprinklerAPI::refreshStatus()
+ * 
+ * Rebuilds the cached status sections that are dirty.  Each section is a run
+ * of JSON members that writeAPIStatus() adds to the status object.  The
+ * available disk space is also refreshed whenever the log has written to the
+ * filesystem since it was last calculated, because that happens in the
+ * background without any API call.
+ */
+void SprinklerAPI::refreshStatus() {
+    char buff[256];
+
+    if (bootStatus.isEmpty()) {
+        // none of this changes until the next restart
+
+        snprintf(
+            buff,
+            sizeof(buff),
+            "\"logicMode\": \"%s\", "
+            "\"numZones\": %u, "
+            "\"hostname\": \"%s\", "
+            "\"sketchSize\": %lu, "
+            "\"freeSketchSpace\": %lu, "
+            "\"bootVersion\": %u, "
+            "\"chipId\": %" PRIu32 ", "
+            "\"resetReason\": \"%s\"",
+            ZoneLogic_t::name,
+            numberOfZones,
+            DEVICE_NAME,
+            (unsigned long)ESP.getSketchSize(),
+            (unsigned long)ESP.getFreeSketchSpace(),
+            ESP.getBootVersion(),
+            ESP.getChipId(),
+            ESP.getResetReason().c_str()
         );
-        sseClient.println();
-        sseClient.println();
-        sseClient.flush();
+        bootStatus = buff;
+    }
 
-        if (data) {
-            LOG_DEBUG("sendCustomServerEvent('%s', '%s')\n", eventName, data);
-        } else {
-            LOG_DEBUG("sendCustomServerEvent('%s', null)\n", eventName);
-        }
-    } else {
-        LOG_DEBUG("sendCustomServerEvent('%s') ignored\n", eventName);
+    // not through markStatusDirty():  the writes aren't a change to the state,
+    // and the version of the state has to stay as it was given out (see
+    // stateNotModified()) or no ETag or /status/wait since would ever match
+    if (logger.getWrites() + journal.getWrites() != statusFsWrites) {
+        statusFsWrites = logger.getWrites() + journal.getWrites();
+        statusDirty |= statusFs;
+        statusEventDirty |= statusFs;
     }
-}
 
-void SprinklerAPI::triggerSendStatusEvent() {
-    shouldSendStatusEvent = true;
-    LOG_DEBUG("triggerSendStatusEvent() called\n");
-}
+    if (statusDirty & statusFs) {
+        FSInfo64 fsinfo;
+        uint64_t roundingFactor;
 
-char* SprinklerAPI::getAPIStatus() {
-    FSInfo64 fsinfo;
-    uint64_t roundingFactor;
-    uint8_t* registers = shiftRegister.getAll();
-    uint8_t mask;
-    String zones;
-    zones.reserve(5); // only planning on 2 zones ever:  [2,6]
-    
-    LittleFS.info64(fsinfo);
+        LittleFS.info64(fsinfo);
 
-    // When we calculate a percent available disk space, the canonical formula
-    // is to divide the used bytes by the total bytes and multiply by 100.  But
-    // that will always round down (because the result is truncated to an integer
-    // type).  So, to accomplish a round up, we need to add 1/2 of 1% of the 
-    // denominator.  Thus the rounding factor is calculated as follows.  It should
-    // be added to the usedBytes before dividing by the totalBytes.
+        // When we calculate a percent available disk space, the canonical formula
+        // is to divide the used bytes by the total bytes and multiply by 100.  But
+        // that will always round down (because the result is truncated to an integer
+        // type).  So, to accomplish a round up, we need to add 1/2 of 1% of the 
+        // denominator.  Thus the rounding factor is calculated as follows.  It should
+        // be added to the usedBytes before dividing by the totalBytes.
 
-    roundingFactor = fsinfo.totalBytes / 100 / 2;
+        roundingFactor = fsinfo.totalBytes / 100 / 2;
 
-    // Construct a string that looks like this:  [1, 3, 4]  
-    // if zones 1, 3 and 4 were on.  It should be a JSON compatible represen-
-    // tation of the zones current running.  In practice, it will probably
-    // only ever look like this: [1], because multiple zones won't run
-    // at the same time.
+        snprintf(
+            buff,
+            sizeof(buff),
+            "\"availableDiskSpace\": \"%llu (%llu%%)\"",
+            fsinfo.totalBytes - fsinfo.usedBytes,
+            ((fsinfo.totalBytes - fsinfo.usedBytes + roundingFactor) * 100) / fsinfo.totalBytes
+        );
+        fsStatus = buff;
+    }
 
-    for (uint8_t i=0; i < 8; i++) {
-        mask = 1 << i;
+    if (statusDirty & statusZones) {
+        ZoneMask_t registers = getRegisters();
+        ZoneMask_t zonesOn = getZonesOn();
+        String zones;
+        zones.reserve(5); // only planning on 2 zones ever:  [2,6]
 
-        if (normalLogic) {
-            if (*registers & mask) {
-                if (zones.length() > 0) {
-                    zones += ",";
-                }
-                zones += String(i + 1);
-            }
-        } else {
-            // The serial register works in reverse:  if and-ing with the mask
-            // yields true (i.e., the bit is on) then the zone is actually off.
-            // So to flip this, the result is then not-ed.
+        // Construct a string that looks like this:  [1, 3, 4]  
+        // if zones 1, 3 and 4 were on.  It should be a JSON compatible represen-
+        // tation of the zones current running.  In practice, it will probably
+        // only ever look like this: [1], because multiple zones won't run
+        // at the same time.
 
-            if (!(*registers & mask)) {
+        for (uint8_t i=0; i < MAX_ZONES; i++) {
+            if (zonesOn & ((ZoneMask_t)1 << i)) {
                 if (zones.length() > 0) {
                     zones += ",";
                 }
                 zones += String(i + 1);
             }
         }
-    }
 
-    // Construct a JSON representation of the schedule that looks like this:
-    // [[1, 20], [2, 25], [3, 10]]
-    // representing three ScheduleItem_t structs for zones 1, 2 and 3, having
-    // runTime values of 20, 25 and 10, respectively.
+        snprintf(
+            buff,
+            sizeof(buff),
+            "\"outputEnable\": \"%s\", "
+            "\"registers\": %lu, "
+            "\"on\": [%s]",
+            (digitalRead(outputEnablePin) == HIGH) ? "off" : "on",
+            (unsigned long)registers, 
+            zones.c_str()
+        );
+        zonesStatus = buff;
+    }
 
-    String schd = "[";
+    if (statusDirty & statusScheduler) {
+        // Construct a JSON representation of the schedule that looks like this:
+        // [[1, 20], [2, 25], [3, 10]]
+        // representing three ScheduleItem_t structs for zones 1, 2 and 3, having
+        // runTime values of 20, 25 and 10, respectively.
 
-    if (!schedule.empty()) {
-        // believe it or not, this constructs a copy of the actual "schedule"
-        // instance variable so that we can iterate through it... the 
-        // std::queue doesn't allow standard iteration over it using a "for
-        // iterator" or a "for loop", so we approach it by using the front()
-        // item, then popping it off and continuing until the queue is empty
+        String schd = "[";
 
-        std::queue<ScheduleItem_t> q = schedule;
-        
-        while (!q.empty()) {
-            schd += q.front().asString();
-            q.pop();
-            if (!q.empty()) {
-                schd += ",";
+        if (!schedule.empty()) {
+            // believe it or not, this constructs a copy of the actual "schedule"
+            // instance variable so that we can iterate through it... the 
+            // std::queue doesn't allow standard iteration over it using a "for
+            // iterator" or a "for loop", so we approach it by using the front()
+            // item, then popping it off and continuing until the queue is empty
+
+            std::queue<ScheduleItem_t> q = schedule;
+            
+            while (!q.empty()) {
+                schd += q.front().asString();
+                q.pop();
+                if (!q.empty()) {
+                    schd += ",";
+                }
             }
         }
+        schd += "]";
+
+        snprintf(
+            buff,
+            sizeof(buff),
+            "\"scheduleSize\": %zu, "
+            "\"schedulerState\": \"%s\", "
+            "\"currCycle\": \"%s\", "
+            "\"nextCycle\": \"%s\", "
+            "\"startDateTime\": \"%s\", "
+            "\"adj\": %u, "
+            "\"holdDays\": %i, "
+            "\"holdEpoch\": %lu, "
+            "\"resume\": \"%s\", "
+            "\"toggleDelay\": %lu",
+            schedule.size(),
+            schedulerStateNames[schedulerState],
+            (runningCycleItem) ? runningCycleItem->cycleName : "",
+            (nextCycleItem) ? nextCycleItem->cycleName : "",
+            getNextCycleStartAsString().c_str(),
+            getSeasonalAdjustment(),
+            holdDays,
+            holdEpoch,
+            (holdDays > 0) ? epochTimeAsString(holdEpoch).c_str() :
+                (holdDays == 0) ? "system on" : "system off",
+            toggleDelay
+        );
+
+        schedulerStatus = "\"schedule\": ";
+        schedulerStatus += schd;
+        schedulerStatus += ", ";
+        schedulerStatus += buff;
     }
-    schd += "]";
 
-    File f = LittleFS.open("/log.dat", "r");
-    size_t logSize = f.size();
-    f.close();
+    statusDirty = 0;
+}
 
-    sprintf(
-        msg, 
-        "{"
-        "\"status\": \"ok\", "
-        "\"time\": \"%s\", "
-        "\"freeHeap\": %lu, "
-        "\"heapFragmentation\": %u, "
-        "\"availableDiskSpace\": \"%llu (%llu%%)\", "
-        "\"logicMode\": \"%s\", "
-        "\"outputEnable\": \"%s\", "
-        // current shift register info
-        "\"registers\": %u, "
-        "\"on\": [%s], "
-        // scheduler info
-        "\"siRemaining\": %i, "
-        "\"now\": %lu, "
-        "\"scheduleItemEnd\": %lu, "
-        "\"schedule\": %s, "
-        "\"scheduleSize\": %zu, "
-        "\"schedulerState\": \"%s\", "
-        "\"currCycle\": \"%s\", "
-        "\"nextCycle\": \"%s\", "
-        "\"startDateTime\": \"%s\", "
-        "\"adj\": %u, "
-        "\"holdDays\": %i, "
-        "\"holdEpoch\": %lu, "
-        "\"resume\": \"%s\", "
-        // log info
-        "\"logSize\": %zu, "
-        // config info
-        "\"numZones\": %u, "
-        "\"toggleDelay\": %lu, "
-        // host info
-        "\"addr\": \"%s\", "
-        "\"hostname\": \"%s\", "
-        "\"upTime\": \"%s\", "
-        "\"rssi\": %d, "
-        "\"sketchSize\": %lu, "
-        "\"freeSketchSpace\": %lu, "
-        "\"bootVersion\": %u, "
-        "\"chipId\": %" PRIu32 ", "
-        "\"resetReason\": \"%s\""
-        "}", 
-        timeClient.getFormattedTime().c_str(),
-        (unsigned long)ESP.getFreeHeap(),
-        (unsigned int)ESP.getHeapFragmentation(),
-        fsinfo.totalBytes - fsinfo.usedBytes,
-        ((fsinfo.totalBytes - fsinfo.usedBytes + roundingFactor) * 100) / fsinfo.totalBytes,
-        (getNormalLogic()) ? "normal" : "reversed",
-        (digitalRead(outputEnablePin) == HIGH) ? "off" : "on",
-        *registers, 
-        zones.c_str(),
-        getScheduledItemRemainingTime(),
-        now,
-        scheduleItemEnd,
-        schd.c_str(),
-        schedule.size(),
-        schedulerStateNames[schedulerState],
-        (runningCycleItem) ? runningCycleItem->cycleName : "",
-        (nextCycleItem) ? nextCycleItem->cycleName : "",
-        getNextCycleStartAsString().c_str(),
-        getSeasonalAdjustment(),
-        holdDays,
-        holdEpoch,
-        (holdDays > 0) ? epochTimeAsString(holdEpoch).c_str() :
-            (holdDays == 0) ? "system on" : "system off",
-        logSize,
-        numberOfZones,
-        toggleDelay,
-        WiFi.localIP().toString().c_str(),
-        DEVICE_NAME,
-        getUpTime().c_str(),
-        WiFi.RSSI(),
-        (unsigned long)ESP.getSketchSize(),
-        (unsigned long)ESP.getFreeSketchSpace(),
-        ESP.getBootVersion(),
-        ESP.getChipId(),
-        ESP.getResetReason().c_str()
-    );
+void SprinklerAPI::getStatusValues(StatusValues_t& values) {
+    values.time = timeClient.getFormattedTime();
+    values.freeHeap = (unsigned long)ESP.getFreeHeap();
+    values.heapFragmentation = (unsigned int)ESP.getHeapFragmentation();
+    values.siRemaining = getScheduledItemRemainingTime();
+    values.now = now;
+    values.scheduleItemEnd = scheduleItemEnd;
+    values.logSize = logger.size();
+    values.addr = WiFi.localIP().toString();
+    values.upTime = getUpTime();
+    values.rssi = (int)WiFi.RSSI();
+}
 
-    return msg;
+void SprinklerAPI::writeAPIStatus(JsonStreamWriter& json) {
+    StatusValues_t values;
+
+    refreshStatus();
+    getStatusValues(values);
+    writeAPIStatus(json, values, nullptr, statusAll);
+}
+
+/**
+ * SprinklerAPI::writeAPIStatus()
+ * 
+ * Writes the status JSON.  The values that change from moment to moment
+ * (time, heap, timers, log size, network) are passed in; the rest comes from
+ * the cached sections, which refreshStatus() rebuilds only when something
+ * has marked them dirty (it must be invoked first).
+ * 
+ * When since is given, only the values that are different from since and
+ * the given sections are written, which is a delta for a status event.
+ */
+void SprinklerAPI::writeAPIStatus(
+    JsonStreamWriter& json,
+    const StatusValues_t& values,
+    const StatusValues_t* since,
+    uint8_t sections
+) {
+    json.beginObject();
+
+    if (!since) {
+        json.key("status").value("ok");
+    }
+
+    if (!since || values.time != since->time) {
+        json.key("time").value(values.time);
+    }
+    if (!since || values.freeHeap != since->freeHeap) {
+        json.key("freeHeap").value(values.freeHeap);
+    }
+    if (!since || values.heapFragmentation != since->heapFragmentation) {
+        json.key("heapFragmentation").value(values.heapFragmentation);
+    }
+    if (sections & statusFs) {
+        json.members(fsStatus.c_str());
+    }
+    if (sections & statusZones) {
+        json.members(zonesStatus.c_str());
+    }
+    // scheduler info
+    if (!since || values.siRemaining != since->siRemaining) {
+        json.key("siRemaining").value(values.siRemaining);
+    }
+    if (!since || values.now != since->now) {
+        json.key("now").value(values.now);
+    }
+    if (!since || values.scheduleItemEnd != since->scheduleItemEnd) {
+        json.key("scheduleItemEnd").value(values.scheduleItemEnd);
+    }
+    if (sections & statusScheduler) {
+        json.members(schedulerStatus.c_str());
+    }
+    // log info
+    if (!since || values.logSize != since->logSize) {
+        json.key("logSize").value((unsigned long)values.logSize);
+    }
+    // host info
+    if (!since || values.addr != since->addr) {
+        json.key("addr").value(values.addr);
+    }
+    if (!since || values.upTime != since->upTime) {
+        json.key("upTime").value(values.upTime);
+    }
+    if (!since || values.rssi != since->rssi) {
+        json.key("rssi").value(values.rssi);
+    }
+    if (sections & statusBoot) {
+        json.members(bootStatus.c_str());
+    }
+
+    json.end();
 }
 
 void SprinklerAPI::sendApiStatus() {
-    sendMessage(getAPIStatus());
+    sendChunked([this](JsonStreamWriter& json) {
+        writeAPIStatus(json);
+    });
 }
 
 void SprinklerAPI::sendInvalidZonesError(const String& zones) {
-    sprintf(
+    snprintf(
         msg,
+        sizeof(msg),
         "{\"status\": \"error\", \"msg\": \"invalid zones=%s\"}",
         zones.c_str()
     );
     sendMessage(msg);
 }
 
-void SprinklerAPI::controlZone() {
-    String zones = server.pathArg(0);
-    String command = server.pathArg(1);
+void SprinklerAPI::controlZone(const String& zones, const String& command) {
     BitMaskItem_t mask = zonesToBitMask(zones);
 
     if (mask.status == error) {
@@ -1991,10 +3317,8 @@ void SprinklerAPI::controlZone() {
         turnZonesOff(mask.bitMask);
     }
     else if (command == "toggle") {
-        uint8_t* registers = shiftRegister.getAll();
-
-        // handle turning other zones off and delaying only if at least one
-        // zone is currently on (255 indicates no zones on)
+        // turn every other zone off and the requested zones on in a single
+        // latch
 
         // *** important note ***
         // 
@@ -2003,11 +3327,7 @@ void SprinklerAPI::controlZone() {
         // implementation of a delay() because you can't use it with that
         // framework's callbacks.
 
-        if (*registers != 255) {
-            turnAllZonesOff();
-        }
-
-        turnZonesOn(mask.bitMask);
+        commitZoneChange(ZoneChange_t().allOff().turnOn(mask.bitMask));
     }
     else {
         sendServerUriNotFound();
@@ -2015,59 +3335,89 @@ void SprinklerAPI::controlZone() {
     }
 }
 
-void SprinklerAPI::turnZonesOn(uint8_t bitMask) {
+/**
+ * SprinklerAPI::getRegisters()
+ * 
+ * Returns the current values of the whole register chain as a single
+ * ZoneMask_t, with the first register in the chain in the low byte (this is
+ * the raw register value, so it is not adjusted for reversed logic).
+ */
+ZoneMask_t SprinklerAPI::getRegisters() {
     uint8_t* digitalValues = shiftRegister.getAll();
-    uint8_t newDigitalValues;
+    ZoneMask_t registers = 0;
 
-    if (normalLogic) {
-        newDigitalValues = *digitalValues | bitMask;
-    } else {
-        newDigitalValues = *digitalValues & ~bitMask;
+    for (uint8_t i = 0; i < SHIFT_REGISTER_COUNT; i++) {
+        registers |= (ZoneMask_t)digitalValues[i] << (8 * i);
     }
-
-    shiftRegister.setAll(&newDigitalValues);
-    logZoneOp(bitMask, "on");
-    checkOutputEnable();
-    triggerSendStatusEvent();
+    return registers;
 }
 
-void SprinklerAPI::turnZonesOff(uint8_t bitMask) {
-    uint8_t* digitalValues = shiftRegister.getAll();
-    uint8_t newDigitalValues;
+/**
+ * SprinklerAPI::setRegisters()
+ * 
+ * Sets the whole register chain from a single ZoneMask_t.  setAll() shifts
+ * out every register and latches them once, so all zones change together.
+ */
+void SprinklerAPI::setRegisters(ZoneMask_t registers) {
+    uint8_t digitalValues[SHIFT_REGISTER_COUNT];
 
-    if (normalLogic) {
-        newDigitalValues = *digitalValues & ~bitMask;
-    } else {
-        newDigitalValues = *digitalValues | bitMask;
+    for (uint8_t i = 0; i < SHIFT_REGISTER_COUNT; i++) {
+        digitalValues[i] = (uint8_t)(registers >> (8 * i));
     }
+    shiftRegister.setAll(digitalValues);
+    markStatusDirty(statusZones);
+}
 
-    shiftRegister.setAll(&newDigitalValues);
-    logZoneOp(bitMask, "off");
-    checkOutputEnable();
-    triggerSendStatusEvent();
+/**
+ * SprinklerAPI::getZonesOn()
+ * 
+ * Returns the mask of zones that are currently on, taking the logic mode
+ * into account (in reversed logic a zone is on when its bit is off).
+ */
+ZoneMask_t SprinklerAPI::getZonesOn() {
+    return ZoneLogic_t::toZonesOn(getRegisters());
 }
 
-void SprinklerAPI::turnAllZonesOn() {
-    if (normalLogic) {
-        shiftRegister.setAllHigh();
-    } else {
-        shiftRegister.setAllLow();
-    }
+void SprinklerAPI::turnZonesOn(ZoneMask_t bitMask) {
+    commitZoneChange(ZoneChange_t().turnOn(bitMask));
+}
 
-    logZoneOp("all", "on");
-    checkOutputEnable();
-    triggerSendStatusEvent();
+void SprinklerAPI::turnZonesOff(ZoneMask_t bitMask) {
+    commitZoneChange(ZoneChange_t().turnOff(bitMask));
+}
+
+void SprinklerAPI::turnAllZonesOn() {
+    commitZoneChange(ZoneChange_t().allOn());
 }
 
 void SprinklerAPI::turnAllZonesOff(bool requestStatusEvent) {
-    if (normalLogic) {
-        shiftRegister.setAllLow();
-    } else {
-        shiftRegister.setAllHigh();
+    commitZoneChange(ZoneChange_t().allOff(), requestStatusEvent);
+}
+
+/**
+ * SprinklerAPI::commitZoneChange()
+ * 
+ * Applies a ZoneChange_t to the registers.  The register chain is only
+ * rewritten (and OE only rechecked) when the zones that are on actually
+ * change, so a redundant command doesn't cause a latch.  Either way a single
+ * log record is written, naming the zones turned on if there were any (any
+ * zones turned off in the same change are implied by the register value that
+ * is logged), otherwise the zones turned off.
+ */
+void SprinklerAPI::commitZoneChange(const ZoneChange_t& change, bool requestStatusEvent) {
+    ZoneMask_t zonesOn = getZonesOn();
+    ZoneMask_t newZonesOn = change.apply(zonesOn);
+
+    if (newZonesOn != zonesOn) {
+        setRegisters(ZoneLogic_t::toRegisters(newZonesOn));
+        checkOutputEnable();
     }
 
-    logZoneOp("all", "off");
-    checkOutputEnable();
+    if (change.on != 0) {
+        logZoneOp(change.on, logZonesOn);
+    } else {
+        logZoneOp(change.off, logZonesOff);
+    }
 
     if (requestStatusEvent) {
         triggerSendStatusEvent();
@@ -2084,7 +3434,7 @@ void SprinklerAPI::turnAllZonesOff(bool requestStatusEvent) {
  * This method should be invoked wherever any shiftRegister "set" function
  * is invoked.
  * 
- * This has to be compared to the normalLogic ("logic mode") of the system.
+ * This has to be compared to the ZoneLogic_t ("logic mode") of the system.
  * If logic is normal, then OE works normally.  That is, if the register is 0,
  * then that means in normal logic mode all pins are off, so squelch the 
  * register pins to (hopefully) prevent any voltage leakage.  (My hope is that
@@ -2096,19 +3446,22 @@ void SprinklerAPI::turnAllZonesOff(bool requestStatusEvent) {
  * doesn't seem right electrically, but that is what is out there right now.)
  */
 void SprinklerAPI::checkOutputEnable() {
-    uint8_t* reg = shiftRegister.getAll();
+    ZoneMask_t reg = getRegisters();
 
-    if (normalLogic && *reg == 0) {
+    if (ZoneLogic_t::normal && reg == 0) {
         digitalWrite(outputEnablePin, HIGH);
-        LOG_DEBUG("checkOutputEnable: reg=%u oePin=%u -- setting HIGH\n", *reg, outputEnablePin);
+        LOG_DEBUG("checkOutputEnable: reg=%lu oePin=%u -- setting HIGH\n", (unsigned long)reg, outputEnablePin);
     } else {
         digitalWrite(outputEnablePin, LOW);
-        LOG_DEBUG("checkOutputEnable: reg=%u oePin=%u -- setting LOW\n", *reg, outputEnablePin);
+        LOG_DEBUG("checkOutputEnable: reg=%lu oePin=%u -- setting LOW\n", (unsigned long)reg, outputEnablePin);
     }
+    markStatusDirty(statusZones);
 }
 
 void SprinklerAPI::setToggleDelay() {
     toggleDelay = (unsigned long)server.pathArg(0).toInt();
+    markStatusDirty(statusScheduler);
+    recordChange(JournalRecord_t(journalToggleDelay).putVarint(toggleDelay));
 }
 
 /**
@@ -2134,26 +3487,6 @@ void SprinklerAPI::blinkLed(uint8_t count, uint64_t onDuration, uint64_t offDura
     }
 }
 
-/**
- * SprinklerAPI::logDate()
- * 
- * Appends the current date to the end of the log file.  If the last line of the log
- * is a date, then no messages have been logged to the file since the time the previous
- * date was appended, so then the date is overwritten with the new date.  This function
- * is designed to log the date as close to midnight as possible so that subsequent log
- * messages will be associated with the correct date.
- * 
- * Parameters:
- * mode - 0 = setup, 1 = loop
-*/
-void SprinklerAPI::logDate(uint8_t mode) {
-    if (mode == 0) {
-        // setup mode
-    } else {
-        // loop mode
-    }
-}
-
 const String SprinklerAPI::getUpTime() const {
     unsigned long upMillis = millis() - startedMillis;
     int days = upMillis / DAY ;                                //number of days
@@ -2195,6 +3528,7 @@ void SprinklerAPI::controlScheduler(const String& action) {
     ScheduleItem_t& si = schedule.front();
 
     logMsgf("schd|%s", action.c_str());
+    markStatusDirty(statusScheduler);
 
     if (action == "cancel") {
         // clear runningCycleItem here so that when turnAllZonesOff()
@@ -2207,6 +3541,7 @@ void SprinklerAPI::controlScheduler(const String& action) {
         while (!schedule.empty()) {
             schedule.pop();
         }
+        scheduleChanged = true;
 
         // wait till the end of the function to invoke turnAllZonesOff()
         // so that the entire updated context of the Scheduler will be ready
@@ -2217,11 +3552,13 @@ void SprinklerAPI::controlScheduler(const String& action) {
     if (action == "pause") {
         pausedScheduleItemMillis = now;
         schedulerState = paused;
+        scheduleChanged = true;
         turnZonesOff(si.bitMask);
     } else 
     if (action == "resume") {
         scheduleItemEnd += (now - pausedScheduleItemMillis);
         schedulerState = running;
+        scheduleChanged = true;
         turnZonesOn(si.bitMask);
     } else 
     if (action == "skip") {
@@ -2261,6 +3598,8 @@ void SprinklerAPI::scheduleItem(const String& zones, const String& runTime) {
     }
 
     schedule.emplace(mask.bitMask, uintRunTime);
+    scheduleChanged = true;
+    markStatusDirty(statusScheduler);
     logMsgf("schd|%s|%u", zones.c_str(), uintRunTime);
 
     if (requestStatusEvent) {
@@ -2273,9 +3612,7 @@ void SprinklerAPI::scheduleItem(const String& zones, const String& runTime) {
  * 
  * I think it should be eliminated
  */
-void SprinklerAPI::schedulePost() {
-    String cmd = server.pathArg(0);
-    String body = server.arg("plain");
+void SprinklerAPI::schedulePost(const String& cmd, const String& body) {
     DynamicJsonDocument doc(1024);
 
     deserializeJson(doc, body);
@@ -2303,6 +3640,9 @@ void SprinklerAPI::schedulePost() {
         sendServerUriNotFound();
         return;
     }
+
+    markStatusDirty(statusScheduler);
+    scheduleChanged = true;
     
     for (JsonArray si : newSchedule) {
         BitMaskItem_t mask;
@@ -2315,8 +3655,9 @@ void SprinklerAPI::schedulePost() {
         } else if (si[0].is<JsonArray>()) {
             mask = BitMaskItem_t(si[0].as<JsonArray>());
         } else {
-            sprintf(
+            snprintf(
                 msg,
+                sizeof(msg),
                 "{\"status\": \"error\", "
                 "\"msg\": \"invalid: \"%s\"}",
                 body.c_str()
@@ -2341,24 +3682,23 @@ void SprinklerAPI::schedulePost() {
 }
 
 void SprinklerAPI::schedulerLoop() {
+    SchedulerState_t prevState = schedulerState;
+
     switch (schedulerState)
     {
     case stopped:
         if (!schedule.empty()) {
             ScheduleItem_t& si = schedule.front();
 
-            // this is done to ensure that if a schedule is set while zones
-            // are on manually, that they are all turned off so that the
-            // schedule will totally take over; also, no status event should
-            // be sent here because the correct status event will be sent
-            // shortly by turnZonesOn()
-
-            turnAllZonesOff(false);
+            // all zones are turned off in the same change to ensure that if
+            // a schedule is set while zones are on manually, the schedule
+            // will totally take over; the change is committed after the
+            // state is updated so that its status event is correct
 
             schedulerState = running;
             scheduleItemEnd = now + (si.runTime * 60 * 1000);
 
-            turnZonesOn(si.bitMask);
+            commitZoneChange(ZoneChange_t().allOff().turnOn(si.bitMask));
         }
         break;
     case running:
@@ -2370,7 +3710,7 @@ void SprinklerAPI::schedulerLoop() {
             // is needed so that the turnZonesOff() reports the correct state
             // back to the UI when it sends its status event.
 
-            uint8_t savedBitMask = si.bitMask;
+            ZoneMask_t savedBitMask = si.bitMask;
 
             // if the schedule size is 1, then we are on the last Schedule 
             // Item, which means that when we turn it off below, the Schedule
@@ -2389,6 +3729,7 @@ void SprinklerAPI::schedulerLoop() {
             }
 
             schedule.pop();
+            scheduleChanged = true;
             turnZonesOff(savedBitMask);
         }
         break;
@@ -2399,7 +3740,7 @@ void SprinklerAPI::schedulerLoop() {
         // the stopped state in the UI, so triggerSendStatusEvent() is explicitly
         // NOT INVOKED here.  We want the "stopped" state to exist for only a
         // very brief amount of time for the next look to occur and the status
-        // is then reported correctly by another turnZonesOn() invocation.
+        // is then reported correctly by the next commitZoneChange().
 
         if (now > scheduleItemEnd) {
             schedulerState = stopped;
@@ -2407,6 +3748,10 @@ void SprinklerAPI::schedulerLoop() {
     default:
         break;
     }
+
+    if (schedulerState != prevState) {
+        markStatusDirty(statusScheduler);
+    }
 }
 
 void SprinklerAPI::setFsAvailable(bool val) {
@@ -2427,7 +3772,9 @@ uint8_t SprinklerAPI::getSeasonalAdjustment() const {
 
 void SprinklerAPI::setSeasonalAdjustment(uint8_t adj) {
     seasonalAdjustment = adj;
+    markStatusDirty(statusScheduler);
     logMsgf("adj|%u", adj);
+    recordChange(JournalRecord_t(journalAdj).putByte(adj));
 }
 
 const String SprinklerAPI::getNextCycleStartAsString() const {
@@ -2440,11 +3787,11 @@ BitMaskItem_t SprinklerAPI::zoneToBitMask(uint8_t zone) {
         return BitMaskItem_t(0, error);
     }
 
-    return BitMaskItem_t(1 << (zone - 1), ok);
+    return BitMaskItem_t((ZoneMask_t)1 << (zone - 1), ok);
 }
 
 BitMaskItem_t SprinklerAPI::zonesToBitMask(const String& zones) {
-    uint8_t mask = 0;
+    ZoneMask_t mask = 0;
     uint8_t reg = 0;
 
     // special handler for "all", which is the only non-numeric or delimiter
@@ -2486,7 +3833,7 @@ BitMaskItem_t SprinklerAPI::zonesToBitMask(const String& zones) {
             return BitMaskItem_t(0, error);
         }
 
-        mask |= 1 << (reg - 1);
+        mask |= (ZoneMask_t)1 << (reg - 1);
 
         // important - subsequent invocations of strtok() pass NULL
         // to use the same string again
@@ -2497,14 +3844,11 @@ BitMaskItem_t SprinklerAPI::zonesToBitMask(const String& zones) {
     return BitMaskItem_t(mask, ok);
 }
 
-void SprinklerAPI::logZoneOp(uint8_t bitField, const char* op) {
-    String zone_str = bitFieldtoString(bitField);
-    logZoneOp(zone_str.c_str(), op);
-}
+void SprinklerAPI::logZoneOp(ZoneMask_t bitField, LogOp_t op) {
+    ZoneMask_t registers = getRegisters();
 
-void SprinklerAPI::logZoneOp(const char* literal, const char* op) {
-    uint8_t* digitalValues = shiftRegister.getAll();
-    logMsgf("%s|%s|%u", op, literal, *digitalValues);
+    logger.logZones(op, timeClient.getEpochTime(), bitField, registers);
+    Serial.printf("%s|%s|%lu\n", logOpNames[op], bitFieldtoString(bitField).c_str(), (unsigned long)registers);
 }
 
 /**
@@ -2553,21 +3897,21 @@ void SprinklerAPI::logMsgf(const char* format, ...) {
 }
 
 void SprinklerAPI::logMsg(const char* s) {
-    // YYYY-MM-DD HH:MM:SS = 19 chars + 1 for null terminator = 20
-    char ts[20];
-    time_t tt = timeClient.getEpochTime();
-    struct tm* t = localtime(&tt);
-    File f = LittleFS.open("/log.dat", "a");
-
-    strftime(ts, sizeof(ts), "%m%d %H%M%S", t);
+    // the message is only buffered here; the logger writes it to the log
+    // file in a batch with other messages
+    logger.logMessage(timeClient.getEpochTime(), s);
+    Serial.println(s);
+}
 
-    if (f) {
-        f.printf("%s|%s\n", ts, s);
-        f.close();
-        Serial.printf("%s|%s\n", ts, s);
-    } else {
-        Serial.println("unable to open '/log.dat' in logMsg()");
-    }
+/**
+ * SprinklerAPI::flushLog()
+ * 
+ * Writes any buffered log records to the log file right away.  This must be
+ * invoked before anything that restarts the controller (including an OTA
+ * update) or the buffered lines are lost.
+ */
+void SprinklerAPI::flushLog() {
+    logger.flush();
 }
 
 /**
@@ -2577,15 +3921,18 @@ void SprinklerAPI::logMsg(const char* s) {
  * 
  *      addCycle(std::move(ci))
  * 
- * This function invokes serializeCycleItems() immediately to persist the new
- * cycle to the /cycles.json file.  Then calcNextCycleStart() has to be 
- * invoked again to ensure that if the new cycle ought to be the next one to
- * run, that it will be properly considered.
+ * This function journals the new cycle immediately to persist it (a cycle
+ * of the same name is replaced when the journal is replayed).  Then
+ * calcCycleStart() has to be invoked to ensure that if the new cycle ought
+ * to be the next one to run, that it will be properly considered.
  */
 bool SprinklerAPI::addCycle(CycleItem_t&& ci) {
+    JournalRecord_t rec(journalCycle);
+
     cycleItems.push_back(ci);
-    serializeCycleItems();
-    calcNextCycleStart();
+    cycleItems.back().toJournal(rec);
+    recordChange(rec);
+    calcCycleStart(cycleItems.back());
     return true;
 }
 
@@ -2658,16 +4005,15 @@ String SprinklerAPI::validateCycle(CycleItem_t& ci) {
 
     // loop through scheduleItems and verify some bits about them
 
-    uint8_t maxZoneMask = 1 << (numberOfZones);
-
     for (ScheduleItem_t si: ci.scheduleItems) {
-        // this is weird... basically, if numberOfZones is less than 8, then
-        // we want to make sure that the user didn't include zone 8, other-
-        // wise, all we need to make sure of is that the bitMask isn't 0 --
-        // that is, at least one zone must have been supplied
-
-        if (numberOfZones < 8) {
-            if (si.bitMask & maxZoneMask) {
+        // this is weird... basically, if numberOfZones is less than
+        // MAX_ZONES, then we want to make sure that the user didn't include
+        // any zone above numberOfZones, otherwise, all we need to make sure
+        // of is that the bitMask isn't 0 -- that is, at least one zone must
+        // have been supplied
+
+        if (numberOfZones < MAX_ZONES) {
+            if (si.bitMask >> numberOfZones) {
                 msg = "max zone exceeded";
                 return msg;
             }
@@ -2721,14 +4067,22 @@ CycleItem_t* SprinklerAPI::findCycle(String& cycleName) {
  * 
  * Although it shouldn't be possible for multiple cycle items to have the same
  * name, all will nevertheless be deleted because this loop will go through
- * the entire cycleItems vector
+ * the entire cycleItems list
  * 
  * @param cycleName a String containing the name to be deleted
+ * @param recalc false when the caller is about to add a replacement cycle
+ *        (which replaces it in the journal), true to journal the deletion
  * @returns nothing
  */
 void SprinklerAPI::deleteCycle(String& cycleName, bool recalc) {
     for (CycleItemIterator it = cycleItems.begin(); it != cycleItems.end();) {
         if (cycleName.equalsIgnoreCase(it->cycleName)) {
+            unscheduleCycleStart(*it);
+
+            if (runningCycleItem == &*it) {
+                runningCycleItem = nullptr;
+            }
+
             it = cycleItems.erase(it);
         } else {
             ++it;
@@ -2736,64 +4090,107 @@ void SprinklerAPI::deleteCycle(String& cycleName, bool recalc) {
     }
 
     if (recalc) {
-        serializeCycleItems();
-        calcNextCycleStart();
+        recordChange(JournalRecord_t(journalCycleDelete).putString(cycleName.c_str()));
     }
+
+    // the entry of the deleted cycle may have been the next one to start
+    updateNextCycle();
 }
 
+/**
+ * getNextRunDayOffset()
+ * 
+ * Returns the number of days from startDOW until the next day that is set in
+ * daysBitField, not counting any day before startDOW + offset.  Instead of
+ * stepping through the days one at a time, the 7-bit field is rotated so
+ * that bit 0 is the first day that may be considered, and then the lowest
+ * set bit is the answer -- a constant time calculation.
+ * 
+ * @param daysBitField bit 0 = Sun ... bit 6 = Sat
+ * @param startDOW today's day of the week (e.g. Sat=6, Sun=0)
+ * @param offset the number of days from startDOW to begin looking
+ * @returns the offset from startDOW (>= offset) of the next run day, or -1 if
+ *          no day is set in daysBitField
+ */
 int getNextRunDayOffset(uint8_t daysBitField, int startDOW, int offset) {
-    // startDOW = today's day of the week (e.g. Sat=6, Sun=0)
-    int nextDOW;
+    uint8_t days = daysBitField & 0x7f;
 
-    while (true) {
-        nextDOW = (startDOW + offset) % 7;
+    if (days == 0) {
+        return -1;
+    }
+
+    int firstDOW = (((startDOW + offset) % 7) + 7) % 7;
+    uint8_t rotated = ((days >> firstDOW) | (days << (7 - firstDOW))) & 0x7f;
+
+    return offset + __builtin_ctz(rotated);
+}
+
+/**
+ * SprinklerAPI::calcNextCycleStart()
+ * 
+ * Calculates the next start date for each CycleItem_t from scratch and
+ * rebuilds the cycleStarts index, whose first entry is the one that will
+ * occur the soonest to now.  This is only needed when the point in time that
+ * every start is calculated from changes (at startup, when cycles are
+ * restored, or when a hold is set).  Changes to a single cycle are handled
+ * by calcCycleStart() and unscheduleCycleStart(), which only touch that
+ * cycle's entry.
+ */
+void SprinklerAPI::calcNextCycleStart() {
+    CycleCalcBase_t base;
+
+    cycleStarts.clear();
+
+    for (CycleItem_t& ci : cycleItems) {
+        ci.nextStartEpoch = ULONG_MAX;
+    }
+
+    if (getCycleCalcBase(base)) {
+        for (CycleItem_t& ci : cycleItems) {
+            scheduleCycleStart(ci, base);
+        }
+    }
+
+    updateNextCycle();
+}
+
+/**
+ * SprinklerAPI::calcCycleStart()
+ * 
+ * Recalculates the next start date of a single CycleItem_t (one that was
+ * just added, replaced or started) and moves its entry in the cycleStarts
+ * index accordingly.  The other cycles' entries are left alone.
+ */
+void SprinklerAPI::calcCycleStart(CycleItem_t& ci) {
+    CycleCalcBase_t base;
 
-        LOG_DEBUG(
-            "getNextRunDayOffset() - offset=%i daysBitField=%u nextDOW=%i (1 << nextDOW = %u)\n",
-            offset,
-            daysBitField,
-            nextDOW,
-            1 << nextDOW
-        );
+    unscheduleCycleStart(ci);
 
-        if (daysBitField & (1 << nextDOW)) {
-            return offset;
-        }
-        offset++;
+    if (getCycleCalcBase(base)) {
+        scheduleCycleStart(ci, base);
     }
+
+    updateNextCycle();
 }
 
 /**
- * SprinklerAPI::calcNextCycleStart()
+ * SprinklerAPI::getCycleCalcBase()
+ * 
+ * Determines the point in time that cycle start times are calculated from.
+ * This is normally now, but when a hold for a certain number of days is
+ * active, no cycle can run until that date, so there is no reason to
+ * consider epochs prior to it and the calculation starts at holdEpoch
+ * instead.  A hold that has expired is cleared.
  * 
- * Calculates the next start date for each CycleItem_t and stores the one that
- * will occur the soonest to now.  This is done in a two-step process for
- * each CycleItem_t.  First, "startOffsetFromMidnight" is calculated.  This is
- * the time component of the start date and time.  The time is calculated
- * the same way for specificDays, every2ndDay or every3rdDay.  Then, starting
- * with midnight today, the startOffsetFromMidnight is added to see if this
- * yields a start epoch that is greater than now.  If it is, then we're done,
- * otherwise we have to getNextRunDayOffset() (which works right now only for
- * the "specificDays" CycleType) and perform the calculation again.  This is
- * repeated while the calculation is less than the nowEpoch.  Once the 
- * calculation exceeds nowEpoch, we are done and have a future start time.
- * 
- * Note that these comments are incomplete, as is the function below.  It
- * does not yet handle every2ndDay or every3rdDay CycleTypes.
- * 
- * VERY IMPORTANT NOTE:  the sequence of calculations below is very delicately
- * balanced and perfected only after a ton of testing.  Therefore, DON'T MOVE
- * ANY LINES AROUND without doing tons of testing.
+ * @returns false if the system is in an indefinite hold (turned off), in
+ *          which case no cycle should be scheduled at all
  */
-void SprinklerAPI::calcNextCycleStart() {
+bool SprinklerAPI::getCycleCalcBase(CycleCalcBase_t& base) {
     // if holdDays is negative, then we are in an indefinite hold, which means
     // that no cycle should run — effectively, everything is turned off
 
     if (holdDays < 0) {
-        // as stated below, setting these to max & null turns everything off
-        nextCycleStartEpoch = ULONG_MAX;
-        nextCycleItem = nullptr;
-        return;
+        return false;
     }
 
     // now in seconds since 1/01/1970
@@ -2808,15 +4205,6 @@ void SprinklerAPI::calcNextCycleStart() {
         clearHold();
     }
 
-    // a day in epoch time (which is the number of seconds in a day)
-    const unsigned long dayOffsetEpochTime = 24L * 60L * 60;
-
-    // When thinking about a hold for a certain number of days, this means
-    // that no cycle can run until that date.  So there is no reason to
-    // consider epochs prior to that.  Therefore, instead of starting the
-    // calculation cycle at the nowEpoch time returned by timeClient, just
-    // start the calculation at the holdEpoch.
-
     if (holdDays > 0) {
         nowEpoch = holdEpoch;
 
@@ -2837,121 +4225,134 @@ void SprinklerAPI::calcNextCycleStart() {
     // remove hours, minutes and seconds from nowEpoch to obtain the epoch
     // time of midnight
 
-    unsigned long midnightEpoch = 
+    base.nowEpoch = nowEpoch;
+    base.midnightEpoch = 
         nowEpoch - (timeinfo->tm_hour * 60 * 60) 
                  - (timeinfo->tm_min * 60) 
                  - timeinfo->tm_sec;
 
     // this is 0=Sun based, so no adjustment needed
-    int currDOW = timeinfo->tm_wday;
+    base.currDOW = timeinfo->tm_wday;
 
     LOG_DEBUG(
         "midnightEpoch=%lu (%s)\n", 
-        midnightEpoch, 
-        epochTimeAsString(midnightEpoch).c_str()
+        base.midnightEpoch, 
+        epochTimeAsString(base.midnightEpoch).c_str()
     );
 
-    // will be calculated for each CycleItem_t as the start time in seconds 
-    // since midnight
-    unsigned long startOffsetFromMidnight = 0L;
-
-    // offset from today that is the next run day
-    int nextRunDayOffset = 0;
-
-    // start date & time in epoch seconds
-    unsigned long thisCycleStartEpoch = 0L;
-
-    // along with nextCycleItem being set to nullptr, when nextCycleStartEpoch
-    // is set to ULONG_MAX, this signals there is no next start date time
+    return true;
+}
 
-    nextCycleStartEpoch = ULONG_MAX;
-    nextCycleItem = nullptr;
+/**
+ * SprinklerAPI::scheduleCycleStart()
+ * 
+ * Calculates the next start of one CycleItem_t after base.nowEpoch and adds
+ * it to the cycleStarts index.  First, "startOffsetFromMidnight" is
+ * calculated.  This is the time component of the start date and time.  The
+ * time is calculated the same way for specificDays, every2ndDay or
+ * every3rdDay.  Then, if that time today is still ahead of now, today is the
+ * first day that can be considered, otherwise tomorrow is.
+ * getNextRunDayOffset() (which works right now only for the "specificDays"
+ * CycleType) finds the next run day on or after that day, and that day's
+ * midnight plus startOffsetFromMidnight is the future start time.  Cycles
+ * without any run days are not scheduled.
+ * 
+ * The CycleItem_t must not already have an entry in cycleStarts.
+ */
+void SprinklerAPI::scheduleCycleStart(CycleItem_t& ci, const CycleCalcBase_t& base) {
+    // a day in epoch time (which is the number of seconds in a day)
+    const unsigned long dayOffsetEpochTime = 24L * 60L * 60;
 
-    if (cycleItems.size() == 0) {
-        LOG_DEBUG("nothing scheduled to run");
+    if (ci.cycleType != specificDays) {
+        LOG_INFO( 
+            "cycleType '%s' not supported\n",
+            cycleTypeNames[ci.cycleType]
+        );
         return;
     }
 
-    // loop through each of the cycleItems looking to see if there is now a
-    // cycle that would start sooner than the nextCycleStartEpoch that was
-    // already calculated
+    // the number of seconds (for use in epoch calculations) from midnight
+    // when this cycle should start on its run day
 
-    for (CycleItem_t& ci : cycleItems) {
-        if (ci.cycleType != specificDays) {
-            LOG_INFO( 
-                "cycleType '%s' not supported\n",
-                cycleTypeNames[ci.cycleType]
-            );
-            continue;
-        }
+    unsigned long startOffsetFromMidnight = 
+        (ci.startHour * (60L * 60L)) + 
+        (ci.startMin * 60L);
 
-        // the number of seconds (for use in epoch calculations) from midnight
-        // when this cycle should start on its run day
+    LOG_DEBUG(
+        "cycle: %s %u:%02u\n", 
+        ci.cycleName,
+        ci.startHour,
+        ci.startMin
+    );
 
-        startOffsetFromMidnight = 
-            (ci.startHour * (60L * 60L)) + 
-            (ci.startMin * 60L);
+    // The start time has to be after nowEpoch.  If nowEpoch is right now and
+    // today's start time has already passed (or nowEpoch was advanced to the
+    // holdEpoch and the start time on that day is not after it), then the
+    // earliest day that can be considered is tomorrow, otherwise it is today.
+    // getNextRunDayOffset() then moves that day forward to the actual next
+    // run day as defined by the CycleItem's daysBitField.
+
+    int nextRunDayOffset = getNextRunDayOffset(
+        ci.daysBitField,
+        base.currDOW,
+        (startOffsetFromMidnight > base.nowEpoch - base.midnightEpoch) ? 0 : 1
+    );
 
-        LOG_DEBUG(
-            "cycle: %s %u:%02u\n", 
-            ci.cycleName,
-            ci.startHour,
-            ci.startMin
-        );
+    if (nextRunDayOffset < 0) {
+        LOG_INFO("cycle '%s' has no run days\n", ci.cycleName);
+        return;
+    }
 
-        // Loop through the calculations until thisCycleStartEpoch is greater
-        // than nowEpoch.  If nowEpoch is right now and the time for any 
-        // cycle to start has passed, we need to keep recalculating until the
-        // first result that is greater than nowEpoch.  Furthermore, if 
-        // nowEpoch was advanced ahead to holdEpoch, then we need to keep
-        // running the calculation loop until the result is greater than the
-        // holdEpoch (which was put into nowEpoch, if the hold is active).
-        //
-        // If we are looping again, we want to advance the nextRunDayOffset
-        // by a day so that we don't retry the same day.  This is what moves
-        // us forward in time.  The getNextRunDayOffset() will take this day
-        // and then adjust it to the actual next run day as defined by the
-        // CycleItem's daysBitField.
-
-        for (
-            nextRunDayOffset = 0, thisCycleStartEpoch = 0; 
-            thisCycleStartEpoch <= nowEpoch; 
-            ++nextRunDayOffset
-        ) {
-            // calculate the actual next run day for this CycleItem
-            nextRunDayOffset = getNextRunDayOffset(
-                ci.daysBitField, 
-                currDOW,
-                nextRunDayOffset
-            );
+    ci.nextStartEpoch = base.midnightEpoch + 
+        (nextRunDayOffset * dayOffsetEpochTime) + 
+        startOffsetFromMidnight;
 
-            thisCycleStartEpoch = midnightEpoch + 
-                (nextRunDayOffset * dayOffsetEpochTime) + 
-                startOffsetFromMidnight;
+    LOG_DEBUG(
+        "nextRunDayOffset=%i ci.daysBitField=%u nextStartEpoch=%lu nowEpoch=%lu\n",
+        nextRunDayOffset,
+        ci.daysBitField,
+        ci.nextStartEpoch,
+        base.nowEpoch
+    );
 
-            LOG_DEBUG(
-                "nextRunDayOffset=%i ci.daysBitField=%u thisCycleStartEpoch=%lu %s nowEpoch=%lu\n",
-                nextRunDayOffset,
-                ci.daysBitField,
-                thisCycleStartEpoch,
-                (thisCycleStartEpoch <= nowEpoch) ? "<=" : ">",
-                nowEpoch
-            );
-        }
+    cycleStarts.emplace(ci.nextStartEpoch, &ci);
+}
 
-        // If the result of the calculation for the CycleItem's next
-        // start epoch (thisCycleStartEpoch) has turned out to be less than
-        // the nextCycleStartEpoch, then we have found a CycleItem whose
-        // start time is sooner.  In that case, replace the global information
-        // about the next cycle to run (nextCycleStartEpoch is the time that
-        // the nextCycleItem is to start).
+/**
+ * SprinklerAPI::unscheduleCycleStart()
+ * 
+ * Removes the CycleItem_t's entry (if it has one) from the cycleStarts
+ * index.  This must be done before a CycleItem_t is deleted.
+ */
+void SprinklerAPI::unscheduleCycleStart(CycleItem_t& ci) {
+    if (ci.nextStartEpoch != ULONG_MAX) {
+        cycleStarts.erase(CycleStart_t(ci.nextStartEpoch, &ci));
+        ci.nextStartEpoch = ULONG_MAX;
+    }
+}
 
-        if (thisCycleStartEpoch < nextCycleStartEpoch) {
-            nextCycleStartEpoch = thisCycleStartEpoch;
-            nextCycleItem = &ci;
-        }
+/**
+ * SprinklerAPI::updateNextCycle()
+ * 
+ * Sets nextCycleItem and nextCycleStartEpoch from the first entry of the
+ * cycleStarts index.  Along with nextCycleItem being set to nullptr, when
+ * nextCycleStartEpoch is set to ULONG_MAX, this signals there is no next
+ * start date time.
+ */
+void SprinklerAPI::updateNextCycle() {
+    markStatusDirty(statusScheduler);
+
+    if (cycleStarts.empty()) {
+        nextCycleStartEpoch = ULONG_MAX;
+        nextCycleItem = nullptr;
+
+        LOG_DEBUG("nothing scheduled to run\n");
+        return;
     }
 
+    nextCycleStartEpoch = cycleStarts.begin()->startEpoch;
+    nextCycleItem = cycleStarts.begin()->cycleItem;
+
     LOG_INFO(
         "next cycle to start: %s nextCycleStartEpoch %lu (%s)\n",
         nextCycleItem->cycleName,
@@ -2960,6 +4361,15 @@ void SprinklerAPI::calcNextCycleStart() {
     );
 }
 
+/**
+ * SprinklerAPI::shouldRunNextCycle()
+ * 
+ * Returns true once the next cycle's start has passed.  A start that has
+ * passed by more than CYCLE_START_LATENESS isn't run:  the clock jumped
+ * over it, and running it (and every other start it jumped over, one after
+ * the other) would only pile their schedules up, so each such cycle is
+ * moved on to its following start instead.
+ */
 bool SprinklerAPI::shouldRunNextCycle() {
     unsigned long nowEpoch = timeClient.getEpochTime();
 
@@ -2975,6 +4385,19 @@ bool SprinklerAPI::shouldRunNextCycle() {
         }
     }
 
+    while (
+        nextCycleItem &&
+        nowEpoch > nextCycleStartEpoch &&
+        nowEpoch - nextCycleStartEpoch > CYCLE_START_LATENESS
+    ) {
+        logMsgf(
+            "cycle|skipped|%s|%s",
+            nextCycleItem->cycleName,
+            epochTimeAsString(nextCycleStartEpoch).c_str()
+        );
+        calcCycleStart(*nextCycleItem);
+    }
+
     bool val = nextCycleItem && (nowEpoch > nextCycleStartEpoch);
 
     return val;
@@ -2986,6 +4409,7 @@ void SprinklerAPI::initiateCycle(CycleItem_t* ci) {
     uint8_t adjustedRunTime;
 
     runningCycleItem = ci;
+    markStatusDirty(statusScheduler);
 
     for (ScheduleItem_t si : ci->scheduleItems) {
         if ((adjustedRunTime = si.runTime * runTimeAdj) < 1)
@@ -2994,6 +4418,7 @@ void SprinklerAPI::initiateCycle(CycleItem_t* ci) {
         schedule.emplace(si.bitMask, adjustedRunTime);
         siLog += si.asString(runTimeAdj);
     }
+    scheduleChanged = true;
 
     logMsgf("cycle|start|%s|%s", ci->cycleName, siLog.c_str());
     triggerSendStatusEvent();
@@ -3013,6 +4438,7 @@ void SprinklerAPI::initiateNextCycle() {
 
     runningCycleItem = nextCycleItem;
     nextCycleItem = nullptr;
+    markStatusDirty(statusScheduler);
     
     // initiating a cycle simply requires queueing the cycle's scheduleItems
     // to the schedule controller's schedule queue
@@ -3023,17 +4449,16 @@ void SprinklerAPI::initiateNextCycle() {
         Serial.println("initiateNextCycle() invoked but no nextCycleItem defined");
     }
 
-    /* delay invoking calcNextCycleStart() by a second to allow sufficient
-     * time to pass that it will calculate a new cycle to start rather than
-     * the current one.  This is the safe way to do it without using the
-     * delay() function which is prohibited if I start using the async
-     * web server.  (Note, any delay could be specified by adding more millis
-     * to nextEventMillis -- it is just my thought that 1 second is 
-     * sufficient here because that is all that is needed to exceed the
-     * current nowEpoch value).
+    /* advance only the cycle that just started to its following start.
+     * shouldRunNextCycle() only lets a cycle start once nowEpoch is past its
+     * start time, so the recalculation can't come up with the current start
+     * again and doesn't need to be delayed.
      */
-    events.push([this]() { nextEventMillis += 1000; });
-    events.push([this]() { calcNextCycleStart(); });
+    if (runningCycleItem) {
+        calcCycleStart(*runningCycleItem);
+    } else {
+        updateNextCycle();
+    }
 }
 
 void SprinklerAPI::cancelCycle() {
@@ -3044,6 +4469,7 @@ void SprinklerAPI::cancelCycle() {
 
     controlScheduler("cancel");
     runningCycleItem = nullptr;
+    markStatusDirty(statusScheduler);
 }
 
 /*
@@ -3062,9 +4488,22 @@ void SprinklerAPI::cancelCycle() {
                 "isAct":
                 "schedule": [[[int, ...], int], ...]
             }, ...
-        ]
+        ],
+        "holdDays": int,
+        "holdEpoch": int,
+        "adj": int,
+        "toggleDelay": int,
+        "schedule": [[[int, ...], int], ...],
+        "scheduleEpoch": int,
+        "scheduleRemaining": int,
+        "schedulePaused": bool,
+        "journal": int
     }
 
+    (the scheduler's schedule and how far along it was -- see
+    ScheduleProgress_t -- and the generation of the snapshot that the
+    journal follows -- see SprinklerJournal)
+
     I decided not to serialize bitFields directly but turn them into Json
     arrays, even if there is only one member in them.  My reasoning is that
     it will be much easier to debug that kind of content than it is to have
@@ -3111,11 +4550,49 @@ void SprinklerAPI::serializeCycleItems() {
 
     doc["holdDays"] = holdDays;
     doc["holdEpoch"] = holdEpoch;
+    doc["adj"] = seasonalAdjustment;
+    doc["toggleDelay"] = toggleDelay;
+
+    JsonArray scheduleJson = doc.createNestedArray("schedule");
+    std::queue<ScheduleItem_t> q = schedule;
+
+    while (!q.empty()) {
+        JsonArray item = scheduleJson.createNestedArray();
+        JsonArray zones = item.createNestedArray();
+        loadBitFieldToJsonArray(q.front().bitMask, zones);
+        item.add(q.front().runTime);
+        q.pop();
+    }
+
+    ScheduleProgress_t progress = getScheduleProgress();
+
+    doc["scheduleEpoch"] = progress.epoch;
+    doc["scheduleRemaining"] = progress.remaining;
+    doc["schedulePaused"] = progress.paused;
+    doc["journal"] = snapshotGeneration + 1;
 
-    File fp = LittleFS.open("/cycles.json", "w");
-    serializeJson(doc, fp);
+    // the new snapshot replaces the old one only once all of it is written,
+    // and the journal is started over only after that (until then it still
+    // follows the old snapshot, so a crash in between loses nothing)
+
+    File fp = LittleFS.open("/cycles.tmp", "w");
+    size_t size = serializeJson(doc, fp);
     fp.close();
 
+    if (size == 0 || !LittleFS.rename("/cycles.tmp", "/cycles.json")) {
+        Serial.printf("\n***** Error: /cycles.json could not be written\n\n");
+        return;
+    }
+
+    snapshotGeneration++;
+    snapshotSize = size;
+    scheduleChanged = false;
+    markStatusDirty(statusFs);
+
+    if (!journal.restart(snapshotGeneration, snapshotSize)) {
+        Serial.printf("\n***** Error: /journal.bin could not be written\n\n");
+    }
+
     if (doc.overflowed()) {
         Serial.printf(
             "\n***** Error: DynamicJsonDocument overflowed "
@@ -3129,6 +4606,7 @@ void SprinklerAPI::serializeCycleItems() {
 void SprinklerAPI::deserializeCycleItems() {
     File fp = LittleFS.open("/cycles.json", "r");
     DynamicJsonDocument doc(1024 * 4);
+    snapshotSize = fp.size();
     deserializeJson(doc, fp);
     fp.close();
 
@@ -3141,6 +4619,13 @@ void SprinklerAPI::deserializeCycleItems() {
         );
     }
 
+    // every CycleItem_t is about to be replaced, so nothing may keep
+    // pointing at the current ones (calcNextCycleStart() rebuilds the index)
+
+    cycleStarts.clear();
+    nextCycleItem = nullptr;
+    nextCycleStartEpoch = ULONG_MAX;
+    runningCycleItem = nullptr;
     cycleItems.clear();
 
     JsonArray cycles = doc["cycles"].as<JsonArray>();
@@ -3158,10 +4643,345 @@ void SprinklerAPI::deserializeCycleItems() {
 
     holdDays = doc["holdDays"].as<int8_t>();
     holdEpoch = doc["holdEpoch"].as<unsigned long>();
+    snapshotGeneration = doc["journal"].as<uint32_t>();
+
+    // a cycles.json from before these were persisted leaves them as they are
+
+    if (doc.containsKey("adj")) {
+        seasonalAdjustment = doc["adj"].as<uint8_t>();
+    }
+    if (doc.containsKey("toggleDelay")) {
+        toggleDelay = doc["toggleDelay"].as<unsigned long>();
+    }
+
+    if (restoringSchedule) {
+        for (JsonArray jsi : doc["schedule"].as<JsonArray>()) {
+            schedule.emplace(
+                (ZoneMask_t)jsonArrayToBitField(jsi[0].as<JsonArray>()),
+                jsi[1].as<uint8_t>()
+            );
+        }
+
+        restoredProgress.epoch = doc["scheduleEpoch"].as<unsigned long>();
+        restoredProgress.remaining = doc["scheduleRemaining"].as<uint32_t>();
+        restoredProgress.paused = doc["schedulePaused"].as<bool>();
+    }
+    markStatusDirty(statusScheduler);
 
     LOG_INFO("restored %zu cycles\n", cycleItems.size());
 }
 
+/**
+ * SprinklerAPI::restoreState()
+ * 
+ * Restores the state at boot (and for /deser):  the snapshot (cycles.json)
+ * and then the changes journaled since it was written.  If the journal
+ * can't be carried on with, it is started over:  when its end is damaged,
+ * by writing what was restored as a new snapshot, so that the changes
+ * replayed are kept; when there is none or it belongs to another snapshot
+ * (one that was uploaded), by starting an empty one for the snapshot as it
+ * is.
+ */
+void SprinklerAPI::restoreState() {
+    size_t replayed = 0;
+
+    // the schedule is only restored into an empty one (i.e. at boot), not
+    // over one that is running
+    restoringSchedule = schedule.empty();
+
+    deserializeCycleItems();
+
+    bool journalOk = journal.replay(
+        snapshotGeneration,
+        snapshotSize,
+        [this, &replayed](JournalRecord_t& rec) {
+            applyJournalRecord(rec);
+            replayed++;
+        }
+    );
+
+    LOG_INFO(
+        "journal: %zu records replayed%s\n",
+        replayed,
+        (journalOk) ? "" : ", started over"
+    );
+
+    if (restoringSchedule) {
+        restoringSchedule = false;
+        resumeRestoredSchedule();
+    }
+
+    if (journalOk) {
+        return;
+    }
+
+    if (replayed > 0) {
+        serializeCycleItems();
+    } else {
+        journal.restart(snapshotGeneration, snapshotSize);
+    }
+}
+
+/**
+ * SprinklerAPI::getScheduleProgress()
+ * 
+ * How far along the schedule is right now, to be persisted with it.  The
+ * first item's time only runs down while it is running; otherwise all of
+ * its run time (or what was left of it when it was paused) remains.
+ */
+ScheduleProgress_t SprinklerAPI::getScheduleProgress() const {
+    ScheduleProgress_t progress;
+
+    progress.epoch = timeClient.getEpochTime();
+    progress.paused = schedulerState == paused;
+
+    if (schedule.empty()) {
+        return progress;
+    }
+
+    switch (schedulerState) {
+        case running:
+            progress.remaining = (scheduleItemEnd > now) ? (scheduleItemEnd - now) / 1000UL : 0;
+            break;
+        case paused:
+            progress.remaining = (scheduleItemEnd - pausedScheduleItemMillis) / 1000UL;
+            break;
+        default:
+            progress.remaining = schedule.front().runTime * 60UL;
+            break;
+    }
+    return progress;
+}
+
+/**
+ * SprinklerAPI::resumeRestoredSchedule()
+ * 
+ * Picks up the schedule restored at boot where it would be had the
+ * controller not restarted:  the time since it was persisted is taken off
+ * its items, so the items that would have finished are dropped and the
+ * first one left runs only for what remains of it (in whole minutes).  A
+ * schedule that was paused is restored paused, with none of its time
+ * taken off, and left for the user to resume or cancel.
+ * 
+ * The whole schedule is dropped when it isn't safe to run it unattended:
+ * the clock isn't set (so how long the controller was off is unknown) or a
+ * hold is active.  Either way, the schedule as restored is journaled.
+ */
+void SprinklerAPI::resumeRestoredSchedule() {
+    if (schedule.empty()) {
+        return;
+    }
+
+    unsigned long nowEpoch = timeClient.getEpochTime();
+    uint32_t remaining = restoredProgress.remaining;
+    const char* dropped = nullptr;
+
+    scheduleChanged = true;
+    markStatusDirty(statusScheduler);
+
+    if (!timeClient.isTimeSet()) {
+        dropped = "clock";
+    } else if (holdDays < 0 || (holdDays > 0 && nowEpoch <= holdEpoch)) {
+        dropped = "hold";
+    } else if (!restoredProgress.paused) {
+        unsigned long elapsed = (nowEpoch > restoredProgress.epoch) ?
+            nowEpoch - restoredProgress.epoch : 0UL;
+
+        while (!schedule.empty() && elapsed >= remaining) {
+            elapsed -= remaining;
+            schedule.pop();
+
+            if (!schedule.empty()) {
+                remaining = schedule.front().runTime * 60UL;
+            }
+        }
+
+        if (schedule.empty()) {
+            dropped = "ended";
+        } else {
+            remaining -= elapsed;
+        }
+    }
+
+    if (dropped) {
+        while (!schedule.empty()) {
+            schedule.pop();
+        }
+        logMsgf("schd|dropped|%s", dropped);
+        return;
+    }
+
+    schedule.front().runTime = (uint8_t)std::max(1UL, (remaining + 59UL) / 60UL);
+
+    if (restoredProgress.paused) {
+        pausedScheduleItemMillis = millis();
+        scheduleItemEnd = pausedScheduleItemMillis + remaining * 1000UL;
+        schedulerState = paused;
+    }
+
+    logMsgf(
+        "schd|restored|%zu|%s",
+        schedule.size(),
+        (restoredProgress.paused) ? "paused" : "running"
+    );
+}
+
+/**
+ * SprinklerAPI::applyJournalRecord()
+ * 
+ * Replays a journaled change (see JournalOp_t) onto the state restored from
+ * the snapshot.  The state is set directly, so nothing is journaled (or
+ * logged) again.  A record that is short is ignored.
+ */
+void SprinklerAPI::applyJournalRecord(JournalRecord_t& rec) {
+    LOG_DEBUG("journal: %s\n", (rec.op <= journalSchedule) ? journalOpNames[rec.op] : "?");
+
+    switch (rec.op) {
+        case journalCycle: {
+            CycleItem_t ci;
+
+            if (CycleItem_t::fromJournal(rec, ci)) {
+                String cycleName(ci.cycleName);
+
+                cycleItems.remove_if([&cycleName](const CycleItem_t& other) {
+                    return cycleName.equalsIgnoreCase(other.cycleName);
+                });
+                cycleItems.push_back(std::move(ci));
+            }
+            break;
+        }
+        case journalCycleDelete: {
+            char name[sizeof(CycleItem_t::cycleName)];
+
+            if (rec.getString(name, sizeof(name))) {
+                String cycleName(name);
+
+                cycleItems.remove_if([&cycleName](const CycleItem_t& other) {
+                    return cycleName.equalsIgnoreCase(other.cycleName);
+                });
+            }
+            break;
+        }
+        case journalClear:
+            cycleItems.clear();
+            break;
+        case journalHold: {
+            uint8_t days;
+            uint32_t epoch;
+
+            if (rec.getByte(days) && rec.getVarint(epoch)) {
+                holdDays = (int8_t)days;
+                holdEpoch = epoch;
+            }
+            break;
+        }
+        case journalAdj:
+            rec.getByte(seasonalAdjustment);
+            break;
+        case journalToggleDelay: {
+            uint32_t delay;
+
+            if (rec.getVarint(delay)) {
+                toggleDelay = delay;
+            }
+            break;
+        }
+        case journalSchedule: {
+            uint8_t paused;
+            uint32_t epoch;
+            uint32_t remaining;
+            uint8_t count;
+
+            if (!restoringSchedule ||
+                !rec.getByte(paused) || !rec.getVarint(epoch) ||
+                !rec.getVarint(remaining) || !rec.getByte(count)) {
+                break;
+            }
+
+            restoredProgress.epoch = epoch;
+            restoredProgress.remaining = remaining;
+            restoredProgress.paused = paused;
+
+            while (!schedule.empty()) {
+                schedule.pop();
+            }
+
+            for (uint8_t i = 0; i < count; i++) {
+                uint32_t zones;
+                uint8_t runTime;
+
+                if (!rec.getVarint(zones) || !rec.getByte(runTime)) {
+                    break;
+                }
+                schedule.emplace((ZoneMask_t)zones, runTime);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    markStatusDirty(statusScheduler);
+}
+
+/**
+ * SprinklerAPI::recordChange()
+ * 
+ * Journals a change (it is written by flushJournal()).  If it can't be, the
+ * whole state is written as a new snapshot instead, so it is persisted
+ * either way.
+ */
+void SprinklerAPI::recordChange(const JournalRecord_t& rec) {
+    if (!journal.record(rec)) {
+        serializeCycleItems();
+    }
+}
+
+void SprinklerAPI::recordHold() {
+    recordChange(
+        JournalRecord_t(journalHold).putByte((uint8_t)holdDays).putVarint(holdEpoch)
+    );
+}
+
+// journals the whole schedule (it is only a few bytes per item)
+void SprinklerAPI::recordSchedule() {
+    JournalRecord_t rec(journalSchedule);
+    std::queue<ScheduleItem_t> q = schedule;
+    ScheduleProgress_t progress = getScheduleProgress();
+
+    rec.putByte(progress.paused).putVarint(progress.epoch).putVarint(progress.remaining);
+    rec.putByte((uint8_t)q.size());
+
+    while (!q.empty()) {
+        rec.putVarint(q.front().bitMask).putByte(q.front().runTime);
+        q.pop();
+    }
+
+    recordChange(rec);
+}
+
+/**
+ * SprinklerAPI::flushJournal()
+ * 
+ * Invoked at the end of every loop():  journals the schedule if it changed
+ * and writes everything journaled during the pass with a single append,
+ * compacting the journal into a new snapshot once it has grown too big.  If
+ * the append fails, the state is written as a new snapshot instead.
+ */
+void SprinklerAPI::flushJournal() {
+    if (scheduleChanged) {
+        scheduleChanged = false;
+        recordSchedule();
+    }
+
+    if (!journal.flush()) {
+        LOG_INFO("journal: write failed, writing a snapshot\n");
+        serializeCycleItems();
+    } else if (journal.needsCompaction()) {
+        LOG_INFO("journal: compacting %zu bytes\n", journal.size());
+        serializeCycleItems();
+    }
+}
+
 void SprinklerAPI::clearCycles() {
     cancelCycle();
 
@@ -3169,94 +4989,94 @@ void SprinklerAPI::clearCycles() {
     nextCycleItem = nullptr;
     runningCycleItem = nullptr;
     nextCycleStartEpoch = ULONG_MAX;
+    cycleStarts.clear();
     cycleItems.clear();
-    
+    recordChange(JournalRecord_t(journalClear));
+
     clearHold();
 }
 
-String SprinklerAPI::getCyclesStatus(String& resultType) const {
-    String s((char *)0);
-    bool first = true;
-    std::vector<CycleItem_t> sortedCycles = cycleItems;
-
-    if (!s.reserve(2048)) {
-        return String(
-            "{\"status\": \"error\", \"msg\": \"unable to allocate string\"}"
-        );
+/**
+ * SprinklerAPI::writeCyclesStatus()
+ * 
+ * Writes the cycles sorted by name, as JSON or (resultType ".text") as one
+ * line of text per cycle.  Instead of sorting a copy of the cycles, each
+ * pass over cycleItems finds the one that follows the last one written, so
+ * no more RAM is needed for many cycles than for one.
+ */
+void SprinklerAPI::writeCyclesStatus(JsonStreamWriter& json, const String& resultType) const {
+    bool text = resultType.equals(F(".text"));
+    const CycleItem_t* prev = nullptr;
+
+    // orders the cycles by name and then by position, so even two cycles
+    // with the same name are each written once
+    auto before = [](const CycleItem_t* ci1, const CycleItem_t* ci2) {
+        int cmp = strcmp(ci1->cycleName, ci2->cycleName);
+        return (cmp < 0) || (cmp == 0 && ci1 < ci2);
+    };
+
+    if (!text) {
+        json.beginObject();
+        json.key("status").value("ok");
+        json.key("cycles").beginArray();
     }
 
-    std::sort(sortedCycles.begin(), sortedCycles.end(), 
-        [](CycleItem_t& ci1, CycleItem_t& ci2) {
-            return (strcmp(ci1.cycleName, ci2.cycleName) < 0);
-        });
+    while (true) {
+        const CycleItem_t* next = nullptr;
 
-    if (resultType.equals(F(".text"))) {
-        for (CycleItem_t ci : sortedCycles) {
-            if (!first) s += "\n";
-            s += ci.asString();
-            first = false;
+        for (const CycleItem_t& ci : cycleItems) {
+            if ((!prev || before(prev, &ci)) && (!next || before(&ci, next))) {
+                next = &ci;
+            }
         }
 
-        s += "\nholdDays: ";
-        s += holdDays;
-
-        if (nextCycleItem) {
-            s += " nextCycle: ";
-            s += nextCycleItem->cycleName;
-            s += " start: ";
-            s += nextCycleStartEpoch;
-            s += " (";
-            s += getNextCycleStartAsString();
-            s += ")";
+        if (!next) {
+            break;
         }
-    } else {
 
-        /*****************************************************************
-         * the ironic thing here is that I'm pretty sure instead of re-doing
-         * the whole serialization thing, I should have just returned the
-         * /cycles.json file because the intention is for the on-board file
-         * always to reflect the cycles in memory because that has to be 
-         * true in order for the board not to lose the cycles if it reboots
-         * 
-         * so really, all this code below was sort of dumb, as was the
-         * "asJsonString", though perhaps it was good to write that so as
-         * to prepare to refactor the monolithic method way below
-         *****************************************************************/
-        s += "{\"status\": \"ok\", ";
-        s += "\"cycles\": [";
-
-        for (CycleItem_t ci : sortedCycles) {
-            if (!first) s += ",";
-            s += ci.asJsonString();
-            first = false;
+        if (text) {
+            if (prev) json.write("\n");
+            json.write(next->asString().c_str());
+        } else {
+            next->writeJson(json);
         }
+        prev = next;
+    }
 
-        s += "]";
+    if (text) {
+        json.write("\nholdDays: ");
+        json.write(String(holdDays).c_str());
 
         if (nextCycleItem) {
-            s += ", \"nextCycle\": \"";
-            s += nextCycleItem->cycleName;
-            s += "\", \"startEpoch\": ";
-            s += nextCycleStartEpoch;
-            s += ", \"startDateTime\": \"";
-            s += getNextCycleStartAsString();
-            s += "\", \"time\": \"";
-            s += timeClient.getFormattedTime();
-            s += "\"";
-        }
-
-        s += ", \"holdDays\": ";
-        s += holdDays;
-        s += ", \"holdEpoch\": ";
-        s += holdEpoch;
-        s += "}";
+            json.write(" nextCycle: ");
+            json.write(nextCycleItem->cycleName);
+            json.write(" start: ");
+            json.write(String(nextCycleStartEpoch).c_str());
+            json.write(" (");
+            json.write(getNextCycleStartAsString().c_str());
+            json.write(")");
+        }
+        return;
     }
-    return s;
+
+    json.end();
+
+    if (nextCycleItem) {
+        json.key("nextCycle").value(nextCycleItem->cycleName);
+        json.key("startEpoch").value(nextCycleStartEpoch);
+        json.key("startDateTime").value(getNextCycleStartAsString());
+        json.key("time").value(timeClient.getFormattedTime());
+    }
+
+    json.key("holdDays").value(holdDays);
+    json.key("holdEpoch").value(holdEpoch);
+    json.end();
 }
 
-String SprinklerAPI::getCyclesStatus() const {
-    String s((char *)0);
-    return getCyclesStatus(s);
+void SprinklerAPI::sendCyclesStatus(const String& resultType) {
+    sendChunked([this, &resultType](JsonStreamWriter& json) {
+        writeCyclesStatus(json, resultType);
+    });
 }
 
 /**
@@ -3273,8 +5093,9 @@ String SprinklerAPI::getCyclesStatus() const {
  * conventional C++ ctime can handle (Feb 7, 2106)
  * 
  * Since holdDays and holdEpoch are persisted with the cycle items, once the
- * hold values are set on the SprinklerAPI instance, serializeCycleItems() is
- * invoked to make them permanent and survive a restart.
+ * hold values are set on the SprinklerAPI instance, they are journaled to
+ * make them permanent and survive a restart (clearHold() journals them for
+ * 0).
  */
 void SprinklerAPI::setHoldDays(int8_t holdDays) {
     if (holdDays > 0) {
@@ -3287,8 +5108,11 @@ void SprinklerAPI::setHoldDays(int8_t holdDays) {
         this->holdDays = -1;
         this->holdEpoch = ULONG_MAX;
     }
+    markStatusDirty(statusScheduler);
 
-    serializeCycleItems();
+    if (holdDays != 0) {
+        recordHold();
+    }
 }
 
 /**
@@ -3300,5 +5124,7 @@ void SprinklerAPI::setHoldDays(int8_t holdDays) {
 void SprinklerAPI::clearHold() {
     holdDays = 0;
     holdEpoch = 0UL;
+    markStatusDirty(statusScheduler);
     logMsg("hold|end");
+    recordHold();
 }
@@ -15,12 +15,19 @@
  */
 
 #include <ArduinoJson.h>
-#include <ESP8266WebServer.h>
+#include <SprinklerWebServer.hpp>
+#include <JsonStreamWriter.hpp>
 #include <ShiftRegister74HC595.h>
+#include <SprinklerLog.hpp>
+#include <SprinklerJournal.hpp>
 #include <LittleFS.h>
 #include <NTPClient.h>
+#include <deque>
+#include <list>
 #include <queue>
+#include <set>
 #include <Ticker.h>
+#include <type_traits>
 
 // for some reason these imports aren't needed, but I don't understand why
 // so for now, I will leave them but commented out
@@ -37,27 +44,119 @@
  * convenience sake, for now they are here.
  */
 
-const String bitFieldtoString(uint8_t bitField);
-void loadBitFieldToJsonArray(uint8_t bitField, JsonArray& a);
+const String bitFieldtoString(uint32_t bitField);
+void loadBitFieldToJsonArray(uint32_t bitField, JsonArray& a);
+void writeBitFieldAsJsonArray(JsonStreamWriter& json, uint32_t bitField);
 unsigned long getMidnightEpoch(NTPClient timeClient);
 String epochTimeAsString(unsigned long epochTime);
 int getNextRunDayOffset(uint8_t daysBitField, int startDOW, int offset = 0);
 
+/**
+ * Zone masks
+ * 
+ * The number of chained 74HC595 shift registers is fixed at compile time by
+ * SHIFT_REGISTER_COUNT (e.g. -D SHIFT_REGISTER_COUNT=2 in platformio.ini).
+ * Each register drives 8 zones, and ZoneMask_t is the smallest unsigned type
+ * that holds one bit per zone (LSB = zone 1, which is Q0 of the first
+ * register in the chain).  Up to 4 registers (32 zones) are supported.
+ */
+
+#ifndef SHIFT_REGISTER_COUNT
+#define SHIFT_REGISTER_COUNT 1
+#endif
+
+static_assert(
+    SHIFT_REGISTER_COUNT >= 1 && SHIFT_REGISTER_COUNT <= 4,
+    "SHIFT_REGISTER_COUNT must be between 1 and 4"
+);
+
+#define MAX_ZONES (SHIFT_REGISTER_COUNT * 8)
+
+// the number of zones actually wired up (-D NUMBER_OF_ZONES=n to override)
+#ifndef NUMBER_OF_ZONES
+#define NUMBER_OF_ZONES 7
+#endif
+
+typedef std::conditional<
+    (SHIFT_REGISTER_COUNT == 1), uint8_t, 
+    std::conditional<(SHIFT_REGISTER_COUNT == 2), uint16_t, uint32_t>::type
+>::type ZoneMask_t;
+
+// every output of the register chain, which is "all off" in reversed logic
+constexpr ZoneMask_t allRegistersMask = (ZoneMask_t)((1ULL << MAX_ZONES) - 1);
+
+/**
+ * Register transport
+ * 
+ * How the register values get to the chips is selected at compile time:
+ * bit-banged with shiftOut() by default, -D SHIFT_REGISTER_SPI for the
+ * hardware SPI peripheral (which requires SER on D7, SRCLK on D5 and, in
+ * main.cpp, RCLK on D8 -- a different wiring than the bit-banged one), or
+ * -D SHIFT_REGISTER_RECORDING to record every latched value instead of
+ * driving pins (used by the native build and exposed by GET /latches).
+ */
+
+#if defined(SHIFT_REGISTER_RECORDING)
+typedef ShiftRegisterRecorder ZoneTransport_t;
+#elif defined(SHIFT_REGISTER_SPI)
+typedef ShiftRegisterSPI ZoneTransport_t;
+#else
+typedef ShiftRegisterBitBang ZoneTransport_t;
+#endif
+
+typedef ShiftRegister74HC595<SHIFT_REGISTER_COUNT, ZoneTransport_t> ZoneShiftRegister_t;
+
+/**
+ * Logic polarity
+ * 
+ * Whether a zone is on when its register bit is high ("normal" logic, as on
+ * the "8 Solid State Register" board) or low ("reversed" logic, as on the
+ * "8 Register Board" deployed in my system) is a property of the hardware,
+ * so it is fixed at compile time by defining NORMAL_LOGIC (or not).  The
+ * policy converts between the zones that are on and the register values.
+ */
+
+typedef struct NormalLogic {
+    static constexpr bool normal = true;
+    static constexpr const char* name = "normal";
+
+    static ZoneMask_t toRegisters(ZoneMask_t zonesOn) { return zonesOn; }
+    static ZoneMask_t toZonesOn(ZoneMask_t registers) { return registers; }
+} NormalLogic_t;
+
+typedef struct ReversedLogic {
+    static constexpr bool normal = false;
+    static constexpr const char* name = "reversed";
+
+    static ZoneMask_t toRegisters(ZoneMask_t zonesOn) {
+        return (ZoneMask_t)(~zonesOn & allRegistersMask);
+    }
+    static ZoneMask_t toZonesOn(ZoneMask_t registers) {
+        return (ZoneMask_t)(~registers & allRegistersMask);
+    }
+} ReversedLogic_t;
+
+#ifdef NORMAL_LOGIC
+typedef NormalLogic_t ZoneLogic_t;
+#else
+typedef ReversedLogic_t ZoneLogic_t;
+#endif
+
 /**
  * ScheduleItem_t
  * 
  * Define a Schedule Item, which consists of a bitMask of zones and a run time.
  * 
- * A maximum of 8 zones may be specified in this bitMask, with the LSB being
- * zone 1.  A runTime greater than 254 doesn't make sense, thus it uses
- * a uint8_t data type.
+ * A maximum of MAX_ZONES zones may be specified in this bitMask, with the
+ * LSB being zone 1.  A runTime greater than 254 doesn't make sense, thus it
+ * uses a uint8_t data type.
  */
 
 typedef struct ScheduleItem {
-    uint8_t bitMask;
+    ZoneMask_t bitMask;
     uint8_t runTime;
 
-    ScheduleItem(uint8_t bitMask, uint8_t runTime): bitMask(bitMask), runTime(runTime) {}
+    ScheduleItem(ZoneMask_t bitMask, uint8_t runTime): bitMask(bitMask), runTime(runTime) {}
     const String asString(float adj = 1.0f) const;
 } ScheduleItem_t;
 
@@ -79,19 +178,18 @@ typedef enum BitMaskStatus {
 /**
  * BitMaskItem_t
  * 
- * A struct to contain a bitMask, which is an unsigned 8 bit integer where
- * each bit represents a zone, with the LSB being zone 1.  The status value
- * indicates whether or not the bitMask could be created successfully from
- * the input.
+ * A struct to contain a bitMask, which is a ZoneMask_t where each bit
+ * represents a zone, with the LSB being zone 1.  The status value indicates
+ * whether or not the bitMask could be created successfully from the input.
  */
 
 typedef struct BitMaskItem {
-    uint8_t bitMask;
+    ZoneMask_t bitMask;
     BitMaskStatus_t status;
 
-    BitMaskItem(uint8_t bitMask, BitMaskStatus_t status): 
+    BitMaskItem(ZoneMask_t bitMask, BitMaskStatus_t status): 
         bitMask(bitMask), status(status) {}
-    BitMaskItem(uint8_t bitMask):
+    BitMaskItem(ZoneMask_t bitMask):
         bitMask(bitMask), status(ok) {}
     BitMaskItem(JsonArray zones);
     BitMaskItem() = default;
@@ -99,6 +197,34 @@ typedef struct BitMaskItem {
     const String asString() const;
 } BitMaskItem_t;
 
+/**
+ * ZoneChange_t
+ * 
+ * A zone change transaction.  The zones to turn off and on are collected
+ * first and then applied together by SprinklerAPI::commitZoneChange(), which
+ * latches the registers once (or not at all if nothing actually changes),
+ * writes one log record and raises one status event.  Zones turned off are
+ * applied before zones turned on, so allOff().turnOn(mask) switches from
+ * whatever is running to exactly "mask" in a single latch.
+ */
+
+typedef struct ZoneChange {
+    ZoneMask_t off = 0;
+    ZoneMask_t on = 0;
+
+    ZoneChange& turnOn(ZoneMask_t bitMask) { on |= bitMask; return *this; }
+    ZoneChange& turnOff(ZoneMask_t bitMask) {
+        off |= bitMask;
+        on &= ~bitMask;
+        return *this;
+    }
+    ZoneChange& allOn() { return turnOn(allRegistersMask); }
+    ZoneChange& allOff() { return turnOff(allRegistersMask); }
+    ZoneMask_t apply(ZoneMask_t zonesOn) const {
+        return (ZoneMask_t)((zonesOn & ~off) | on);
+    }
+} ZoneChange_t;
+
 // be sure to keep schedulerStateNames[] in sync in .cpp file
 typedef enum SchedulerState {
     stopped,
@@ -107,6 +233,180 @@ typedef enum SchedulerState {
     paused
 } SchedulerState_t;
 
+/**
+ * ScheduleProgress_t
+ * 
+ * How far along the schedule was when it was persisted:  when (epoch), the
+ * seconds that were left of its first item and whether it was paused.  At
+ * boot, SprinklerAPI::resumeRestoredSchedule() uses it to pick up the
+ * schedule where it would have been had the controller not restarted.
+ */
+
+typedef struct ScheduleProgress {
+    unsigned long epoch = 0UL;
+    uint32_t remaining = 0;
+    bool paused = false;
+} ScheduleProgress_t;
+
+/**
+ * StatusSection_t
+ * 
+ * The sections of the status (writeAPIStatus()) that are cached between calls.
+ * Whatever changes a section marks it dirty with markStatusDirty(), and the
+ * section is only rebuilt the next time the status is needed.  The boot
+ * section never changes, so it is built once.
+ *
+ * The sections marked dirty since the last status event are also tracked
+ * separately, so that the event only has to carry the sections that changed.
+ */
+
+typedef enum StatusSection : uint8_t {
+    statusZones = 0x01,         // registers, zones on, output enable
+    statusScheduler = 0x02,     // schedule, cycles, adjustment, hold
+    statusFs = 0x04,            // available disk space
+    statusBoot = 0x08,          // logic mode, host name, sketch, chip
+    statusAll = 0x0f
+} StatusSection_t;
+
+/**
+ * StatusValues_t
+ * 
+ * The status values that aren't cached because they change from moment to
+ * moment.  The values of the last status event are kept so the next event
+ * only has to include the ones that are different.
+ */
+
+typedef struct StatusValues {
+    String time;
+    unsigned long freeHeap = 0;
+    unsigned int heapFragmentation = 0;
+    int siRemaining = 0;
+    unsigned long now = 0;
+    unsigned long scheduleItemEnd = 0;
+    size_t logSize = 0;
+    String addr;
+    String upTime;
+    int rssi = 0;
+} StatusValues_t;
+
+/**
+ * SseSubscriber_t
+ * 
+ * One client of /sse.  Up to SSE_MAX_CLIENTS clients are subscribed at a
+ * time; a new client takes the place of the one subscribed the longest when
+ * they are all taken.  An event is formatted once and queued in the outbound
+ * buffer of every subscriber it is meant for.  The buffers are drained from
+ * loop() with only as much as each connection can take without blocking
+ * (availableForWrite()), so a client on a poor connection can't hold up the
+ * zones or the other clients.
+ * 
+ * An event that doesn't fit in what is left of a subscriber's buffer is
+ * dropped for that subscriber (and counted) rather than waited on, unless
+ * the buffer was empty when it began:  such an event (a full status with a
+ * long schedule can be bigger than the whole buffer) is never dropped, and
+ * what doesn't fit is spilled to the heap and moved into the buffer as it
+ * drains.  The
+ * dropped events are made up for once the buffer drains: a dropped status
+ * event by the full status in place of every status event it missed, and a
+ * dropped log event by sending the log records from the dropped one on.  A
+ * subscriber whose connection is gone, or that hasn't taken any of its
+ * buffer for SSE_STALL_TIMEOUT ms, is stopped and its place freed.
+ */
+
+#ifndef SSE_MAX_CLIENTS
+#define SSE_MAX_CLIENTS 4
+#endif
+
+// big enough for the full status event (a bigger one is spilled, see above)
+#ifndef SSE_CLIENT_BUFFER
+#define SSE_CLIENT_BUFFER 1536
+#endif
+
+#ifndef SSE_STALL_TIMEOUT
+#define SSE_STALL_TIMEOUT 30000
+#endif
+
+static_assert(SSE_MAX_CLIENTS <= 8, "SSE_MAX_CLIENTS must be 8 or fewer");
+
+/**
+ * /status/wait?since=<version>&timeout=<s>
+ * 
+ * Long polling, for clients that can't keep an SSE connection:  the request
+ * is parked (see SprinklerWebServer::park()) until the state has changed
+ * from the version in since, and is then answered with the status and its
+ * new version.  If nothing changes within the timeout (in seconds, up to
+ * STATUS_WAIT_MAX_TIMEOUT) it is answered with a 304.
+ */
+
+#ifndef STATUS_WAIT_TIMEOUT
+#define STATUS_WAIT_TIMEOUT 30
+#endif
+
+#ifndef STATUS_WAIT_MAX_TIMEOUT
+#define STATUS_WAIT_MAX_TIMEOUT 120
+#endif
+
+/**
+ * SseReplayEvent_t
+ * 
+ * Status and log events are sent with an "id:" that is one more than the
+ * event before it, and the most recent ones (up to SSE_REPLAY_BUFFER bytes
+ * of them) are kept as they were sent.  A client that reconnects sends the
+ * id of the last event it received as its Last-Event-ID header and is sent
+ * only the events after it.  If some of those are no longer kept, it is sent
+ * the full status instead.  Like the state version, an id is sent as
+ * "<boot tag in hex>-<n>", so an id from before a restart is never taken
+ * for one of this run's.
+ * 
+ * Status events are kept in their delta form, which is what a client that
+ * was already subscribed received.  SSE_REPLAY_BUFFER is kept smaller than
+ * SSE_CLIENT_BUFFER so that everything kept fits in a new subscriber's
+ * buffer.
+ */
+
+#ifndef SSE_REPLAY_BUFFER
+#define SSE_REPLAY_BUFFER 1024
+#endif
+
+static_assert(
+    SSE_REPLAY_BUFFER + 256 <= SSE_CLIENT_BUFFER,
+    "SSE_REPLAY_BUFFER must leave room for the headers in SSE_CLIENT_BUFFER"
+);
+
+typedef struct SseReplayEvent {
+    uint32_t id;
+    bool log;                   // a "log" event (only for log subscribers)
+    uint32_t seq;               // the log record of a "log" event
+    String text;
+} SseReplayEvent_t;
+
+typedef struct SseSubscriber {
+    static const uint32_t noLogFrom = UINT32_MAX;
+
+    WiFiClient client;
+    bool active = false;
+    bool log = false;           // also receives "log" events
+    bool needsFull = true;      // the next status event has to be the full status
+    bool behind = false;        // a status event was dropped
+    uint32_t logFrom = noLogFrom;   // the next log record to send from the log
+    unsigned long since = 0;    // millis() when it subscribed
+    unsigned long lastProgress = 0; // millis() when the buffer last drained
+    uint32_t drops = 0;         // events dropped because the buffer was full
+    char buff[SSE_CLIENT_BUFFER];
+    size_t buffLen = 0;
+    String spill;               // what follows buff of an event too big for it
+    size_t eventStart = 0;      // where the event being written starts
+    bool eventDropped = false;
+    bool eventSpills = false;   // the event may spill (it began in an empty buffer)
+
+    void beginEvent();
+    void write(const char* data, size_t len);
+    bool endEvent();
+    bool drain();
+    void stop();
+    size_t queued() const { return buffLen + spill.length(); }
+} SseSubscriber_t;
+
 // be sure to keep cycleTypeNames[] in sync in .cpp file
 // (order needs to be the same too).  The "manual" item is the way to provide
 // the ability to turn off a cycle but retain the ability to run it whenever
@@ -141,6 +441,10 @@ typedef struct CycleItem {
     uint8_t cycleCount = 1;
     std::vector<ScheduleItem_t> scheduleItems;
 
+    // calculated by the cycle controller (not persisted) -- the key of this
+    // cycle's entry in SprinklerAPI::cycleStarts, ULONG_MAX when it has none
+    unsigned long nextStartEpoch = ULONG_MAX;
+
     // causes the default constructor to be implemented despite the presence
     // of other constructors
     CycleItem() = default;
@@ -159,34 +463,121 @@ typedef struct CycleItem {
             memcpy(cycleName, name, 20);
         }
     // return various representations of a CycleItem
-    String asString();
-    String asJsonString();
+    String asString() const;
+    void writeJson(JsonStreamWriter& json) const;
+    void toJournal(JournalRecord_t& rec) const;
 
     // instantiate CycleItem by deserialization
     static CycleItem fromJsonObject(JsonObject& jo);
     static CycleItem fromJsonString(String& s);
+    static bool fromJournal(JournalRecord_t& rec, CycleItem& ci);
 } CycleItem_t;
 
-typedef std::vector<CycleItem_t>::iterator CycleItemIterator;
+// a std::list is used so that pointers to CycleItem_t (nextCycleItem,
+// runningCycleItem and the cycleStarts index) remain valid when other cycles
+// are added or deleted
+
+typedef std::list<CycleItem_t>::iterator CycleItemIterator;
+
+/**
+ * CycleStart_t
+ * 
+ * An entry in the index of upcoming cycle starts, ordered by start epoch so
+ * that the first entry is always the next cycle to start.  Ties are broken
+ * by the address of the CycleItem_t so that every entry is unique.
+ */
+
+typedef struct CycleStart {
+    unsigned long startEpoch;
+    CycleItem_t* cycleItem;
+
+    CycleStart(unsigned long startEpoch, CycleItem_t* cycleItem):
+        startEpoch(startEpoch), cycleItem(cycleItem) {}
+    bool operator<(const CycleStart& other) const {
+        return (startEpoch != other.startEpoch) 
+            ? startEpoch < other.startEpoch
+            : std::less<CycleItem_t*>()(cycleItem, other.cycleItem);
+    }
+} CycleStart_t;
+
+/**
+ * CYCLE_START_LATENESS
+ * 
+ * How late (in seconds) a cycle can still be started.  A start further in
+ * the past than that wasn't missed by the loop but jumped over by the clock
+ * (as when NTP sets it only after the starts were calculated from 1970), so
+ * the cycle is moved on to its following start instead of being run (see
+ * SprinklerAPI::shouldRunNextCycle()).
+ */
+
+#ifndef CYCLE_START_LATENESS
+#define CYCLE_START_LATENESS 120
+#endif
+
+/**
+ * BatchOp_t
+ * 
+ * One operation of a POST /batch (see SprinklerAPI::handleBatch()), parsed
+ * and checked from its path (e.g. "/schd/1,2/10") before any of the
+ * operations of the batch is applied.
+ */
+
+#ifndef BATCH_MAX_OPS
+#define BATCH_MAX_OPS 32
+#endif
+
+typedef enum BatchOpType : uint8_t {
+    batchZone,              // /zone/{zones}/{on|off|toggle}
+    batchScheduler,         // /schd/{cancel|pause|resume|skip}
+    batchScheduleItem,      // /schd/{zones}/{minutes}
+    batchAdj,               // /adj/{1-255}
+    batchHold,              // /hold/{days}
+    batchCycleRun           // /cycle/{name}/run
+} BatchOpType_t;
+
+typedef struct BatchOp {
+    BatchOpType_t type;
+    String arg0;
+    String arg1;
+    long value = 0;
+    CycleItem_t* cycleItem = nullptr;
+} BatchOp_t;
+
+/**
+ * UiBundleFile_t
+ * 
+ * Where one of the UI files is in the bundle that the build puts in flash
+ * (UiBundle.h, written by src/python/build_ui.py).  The files are gzipped.
+ */
+
+typedef struct UiBundleFile {
+    const char* path;
+    const char* contentType;
+    size_t offset;
+    size_t length;
+    const char* etag;
+} UiBundleFile_t;
+
+/**
+ * CycleCalcBase_t
+ * 
+ * The point in time that cycle start times are calculated from (either now
+ * or the end of a hold), broken down the way the calculation needs it.
+ */
+
+typedef struct CycleCalcBase {
+    unsigned long nowEpoch;
+    unsigned long midnightEpoch;
+    int currDOW;
+} CycleCalcBase_t;
 
 class SprinklerAPI {
     private:
-        ESP8266WebServer& server;
-        ShiftRegister74HC595<1>& shiftRegister;
+        SprinklerWebServer& server;
+        ZoneShiftRegister_t& shiftRegister;
         NTPClient& timeClient;
         uint8_t numberOfZones;
 
-        // normalLogic indicates whether the board uses 0-based register math
-        // or 255-based register math -- in other words, the "8 Solid State
-        // Register" board uses 0-based register math, or "normal logic", and
-        // the "8 Register Board" deployed in my system uses reverse (not 
-        // normal) math where 255 is all off.  (This is probably due to an
-        // electrical error I made in wiring up that register board, but it is
-        // now assembled this way and so this code needs to be able to support
-        // not normal logic until such time as I figure out what I did wrong.)
-
-        bool normalLogic = true;
-
         // D0 is just the default and is expected to be changed by the value
         // being set correctly at construction time; in any case this should
         // be set to the pin that is connected to the shift register's
@@ -209,7 +600,8 @@ class SprinklerAPI {
 
         // cycle controller attributes
 
-        std::vector<CycleItem_t> cycleItems;
+        std::list<CycleItem_t> cycleItems;
+        std::set<CycleStart_t> cycleStarts;
         unsigned long nextCycleStartEpoch = ULONG_MAX;
         CycleItem_t* nextCycleItem = nullptr;
         CycleItem_t* runningCycleItem = nullptr;
@@ -224,25 +616,125 @@ class SprinklerAPI {
 
         // logging/debugging
         
+        SprinklerLog logger;
+
+        // persistence (see SprinklerJournal): the generation and size of the
+        // snapshot (cycles.json) that the journal follows, whether the
+        // schedule has changed since it was last journaled and whether
+        // restoreState() may restore it
+        SprinklerJournal journal;
+        uint32_t snapshotGeneration = 0;
+        uint32_t snapshotSize = 0;
+        bool scheduleChanged = false;
+        bool restoringSchedule = false;
+        ScheduleProgress_t restoredProgress;
         int currDay = 0;
 
-        // client for Server Sent Events
-        WiFiClient sseClient;
+        // clients of Server Sent Events
+        SseSubscriber_t sseClients[SSE_MAX_CLIENTS];
 
         Ticker sseTicker;
         bool shouldSendStatusEvent = false;
 
+        // status events after the first are deltas from the one before
+        // (see sendStatusEvent())
+        uint32_t statusVersion = 0;
+        uint8_t statusEventDirty = statusAll;
+        StatusValues_t lastStatusValues;
+
+        // the id of the last event, and the events kept for replay
+        uint32_t sseEventId = 0;
+        uint32_t sseDrops = 0;
+        std::deque<SseReplayEvent_t> sseReplay;
+        size_t sseReplaySize = 0;
+
+        // cached status sections (see StatusSection_t)
+
+        uint8_t statusDirty = statusAll;
+        // the log and journal writes as of the last look at the disk space
+        uint32_t statusFsWrites = 0;
+        String bootStatus;
+        String zonesStatus;
+        String schedulerStatus;
+        String fsStatus;
+
+        // counts the changes to the state (see markStatusDirty()) for the
+        // ETags of conditional GETs and for /status/wait; the boot tag keeps
+        // a version from before a restart from matching
+        uint32_t stateGeneration = 0;
+        uint32_t bootTag = 0;
+
+        // the version (ui.ver) of the UI files in LittleFS, or ULONG_MAX if
+        // it has to be read again (see handleUiFile())
+        unsigned long uiFilesVersion = ULONG_MAX;
+
+        // the handlers of the routes (see initializeUrls())
+
+        void handleUiFile();
+        unsigned long getUiFilesVersion();
+        void handleStatus();
+        void handleStatusWait();
+        void handleZone();
+        void handleToggle();
+        void handleBlink();
+        void handleRestart();
+        void handleScheduler();
+        void handleScheduleItem();
+        void handleSchedulePost();
+        void handleBatch();
+        void handleCycles();
+        void handleCyclePost();
+        void handleCycleDelete();
+        void handleCycle();
+        void handleCycleRun();
+        void handleNextCycle();
+        void handleLog();
+        void handleLogMark();
+        void handleLs();
+        void handleDownload();
+        void handleUpload();
+        void receiveUpload();
+        void handleRm();
+        void handleShouldRun();
+        void handleCalc();
+        void handleSer();
+        void handleDeser();
+        void handleDel();
+        void handleClear();
+        void handleSetOe();
+        void handleOe();
+        void handleSetReg();
+        void handleReg();
+        void handleSetLogic();
+        void handleLogic();
+#ifdef SHIFT_REGISTER_RECORDING
+        void handleLatches();
+#endif
+        void handleAdj();
+        void handleSetAdj();
+        void handleCheck();
+        void handleSse();
+        void handleSseCommand();
+        void handleHold();
+        void handleSetHold();
+        void handleDebug();
+        void handleTest();
+        void handleSeek();
+        void handleSeekTest();
+        void handleNow();
+        void handleSetTz();
+
     public:
         SprinklerAPI(
-            ESP8266WebServer &server, 
-            ShiftRegister74HC595<1>& shiftRegister,
+            SprinklerWebServer &server, 
+            ZoneShiftRegister_t& shiftRegister,
             NTPClient& timeClient,
             uint8_t numberOfZones,
             uint8_t outputEnablePin
         ): server(server), 
             shiftRegister(shiftRegister), 
             timeClient(timeClient),
-            numberOfZones(numberOfZones),
+            numberOfZones((numberOfZones > MAX_ZONES) ? MAX_ZONES : numberOfZones),
             outputEnablePin(outputEnablePin)
             {}
 
@@ -250,9 +742,23 @@ class SprinklerAPI {
         void loop();
         void initializeUrls();
         bool getNormalLogic() const;
-        void setNormalLogic(bool setting);
-        char* getAPIStatus();
+        void writeAPIStatus(JsonStreamWriter& json);
+        void writeAPIStatus(
+            JsonStreamWriter& json,
+            const StatusValues_t& values,
+            const StatusValues_t* since,
+            uint8_t sections
+        );
+        void getStatusValues(StatusValues_t& values);
+        void markStatusDirty(uint8_t sections);
+        bool stateNotModified();
+        void getStateVersion(char* version, size_t size) const;
+        void refreshStatus();
         void sendMessage(const char* s) const;
+        void sendChunked(
+            std::function<void(JsonStreamWriter& json)> fill,
+            const char* contentType = "text/plain"
+        ) const;
         void sendOkStatusMessage() const;
         template<typename... Args>
         void sendFormatted(const char* fmt, Args... vars);
@@ -260,23 +766,42 @@ class SprinklerAPI {
         void sendServerUriNotFound();
         void sendInvalidZonesError(const String& zones);
         void sendLog() const;
+        void sendLogQuery();
         void sendStatusEvent();
+        void sendFullStatusEvent(uint8_t i);
         void sendCustomServerEvent(const char* eventName, const char* data);
+        void sendServerEvent(uint8_t targets, const char* eventName, const char* data);
+        void sendLogEvent(const LogRecord_t& rec);
+        int addSseSubscriber(WiFiClient& client);
+        uint8_t getSseSubscribers(bool logOnly = false) const;
+        void sseBeginEvent(uint8_t targets);
+        void sseWrite(uint8_t targets, const char* data, size_t len);
+        uint8_t sseEndEvent(uint8_t targets);
+        void sseDrain();
+        void sseLogCatchUp(uint8_t i);
+        void rememberSseEvent(uint32_t id, bool log, String& text, uint32_t seq = 0);
+        uint32_t getLogEventId(uint32_t seq) const;
+        bool replaySseEvents(uint8_t i, const String& lastEventId);
         void triggerSendStatusEvent();
-        void controlZone();
-        void turnZonesOn(uint8_t bitMask);
-        void turnZonesOff(uint8_t bitMask);
+        void controlZone(const String& zones, const String& command);
+        ZoneMask_t getRegisters();
+        void setRegisters(ZoneMask_t registers);
+        ZoneMask_t getZonesOn();
+        void turnZonesOn(ZoneMask_t bitMask);
+        void turnZonesOff(ZoneMask_t bitMask);
         void turnAllZonesOn();
         void turnAllZonesOff(bool shouldSendStatusEvent = true);
+        void commitZoneChange(const ZoneChange_t& change, bool requestStatusEvent = true);
         void checkOutputEnable();
         void setToggleDelay();
         void blinkLed(uint8_t count, uint64_t onDuration, uint64_t offDuration);
-        void logDate(uint8_t mode);
         const String getUpTime() const;
         void controlScheduler(const String& action);
         void controlScheduler(const char* action);
         void scheduleItem(const String& zones, const String& runTime);
-        void schedulePost();
+        void schedulePost(const String& cmd, const String& body);
+        String parseBatchOp(const char* path, BatchOp_t& op);
+        void applyBatchOp(const BatchOp_t& op);
         void schedulerLoop();
         int getScheduledItemRemainingTime() const;
         const String getNextCycleStartAsString() const;
@@ -288,10 +813,10 @@ class SprinklerAPI {
 
         // Logger methods
 
-        void logZoneOp(uint8_t bitField, const char* op);
-        void logZoneOp(const char* literal, const char* op);
+        void logZoneOp(ZoneMask_t bitField, LogOp_t op);
         void logMsg(const char* msg);
         void logMsgf(const char* format, ...);
+        void flushLog();
 
         // Cycle Controller methods
 
@@ -309,6 +834,11 @@ class SprinklerAPI {
                     what is the next cycle to start
         */
         void calcNextCycleStart();
+        void calcCycleStart(CycleItem_t& ci);
+        bool getCycleCalcBase(CycleCalcBase_t& base);
+        void scheduleCycleStart(CycleItem_t& ci, const CycleCalcBase_t& base);
+        void unscheduleCycleStart(CycleItem_t& ci);
+        void updateNextCycle();
         bool shouldRunNextCycle();
         /*
             - mostly for documentation purposes, but this
@@ -336,9 +866,17 @@ class SprinklerAPI {
         void cancelCycle();
         void serializeCycleItems();
         void deserializeCycleItems();
+        void restoreState();
+        ScheduleProgress_t getScheduleProgress() const;
+        void resumeRestoredSchedule();
+        void recordChange(const JournalRecord_t& rec);
+        void recordHold();
+        void recordSchedule();
+        void applyJournalRecord(JournalRecord_t& rec);
+        void flushJournal();
         void clearCycles();
-        String getCyclesStatus(String& resultType) const;
-        String getCyclesStatus() const;
+        void writeCyclesStatus(JsonStreamWriter& json, const String& resultType) const;
+        void sendCyclesStatus(const String& resultType = String());
         void setHoldDays(int8_t holdDays);
         void clearHold();
 };
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SprinklerJournal.hpp>
+
+#define JOURNAL_PATH "/journal.bin"
+
+// opcode, the length as a varint, the payload and the check byte
+#define MAX_RECORD_SIZE (1 + 2 + JOURNAL_PAYLOAD_MAX + 1)
+
+static_assert(MAX_RECORD_SIZE <= JOURNAL_BUFFER_SIZE, "JOURNAL_BUFFER_SIZE is too small");
+
+const char* journalOpNames[] = {
+    "",
+    "begin",
+    "cycle",
+    "delete",
+    "clear",
+    "hold",
+    "adj",
+    "toggle",
+    "schd"
+};
+
+static uint8_t checkByte(const JournalRecord_t& rec) {
+    uint8_t check = rec.op ^ (uint8_t)rec.len;
+
+    for (size_t i = 0; i < rec.len; i++) {
+        check = (uint8_t)((check << 1) | (check >> 7)) ^ rec.data[i];
+    }
+    return check;
+}
+
+JournalRecord& JournalRecord::putByte(uint8_t b) {
+    if (len < sizeof(data)) {
+        data[len++] = b;
+    } else {
+        overflowed = true;
+    }
+    return *this;
+}
+
+JournalRecord& JournalRecord::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        putByte((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    return putByte((uint8_t)value);
+}
+
+JournalRecord& JournalRecord::putString(const char* s) {
+    size_t n = strlen(s);
+
+    putVarint(n);
+
+    for (size_t i = 0; i < n; i++) {
+        putByte((uint8_t)s[i]);
+    }
+    return *this;
+}
+
+bool JournalRecord::getByte(uint8_t& b) {
+    if (pos >= len) {
+        return false;
+    }
+    b = data[pos++];
+    return true;
+}
+
+bool JournalRecord::getVarint(uint32_t& value) {
+    uint8_t b;
+
+    value = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (!getByte(b)) {
+            return false;
+        }
+
+        value |= (uint32_t)(b & 0x7f) << shift;
+
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// s is always terminated; a longer string is cut to fit
+bool JournalRecord::getString(char* s, size_t size) {
+    uint32_t n;
+
+    if (!getVarint(n) || n > len - pos) {
+        return false;
+    }
+
+    size_t copied = std::min((size_t)n, size - 1);
+
+    memcpy(s, data + pos, copied);
+    s[copied] = '\0';
+    pos += n;
+    return true;
+}
+
+/**
+ * SprinklerJournal::replay()
+ *
+ * Hands every record of the journal to fn, in order, if the journal follows
+ * the snapshot of the generation and size given.  Returns true if it does
+ * and all of it could be read, in which case new records are appended to
+ * it.  Otherwise the journal has to be started over -- which the caller
+ * does by writing a snapshot of the state (with whatever was replayed), so
+ * that nothing that was journaled is lost.
+ */
+bool SprinklerJournal::replay(uint32_t generation, uint32_t snapshotSize, Replayer_t fn) {
+    File f = LittleFS.open(JOURNAL_PATH, "r");
+    JournalRecord_t rec;
+    uint32_t journalGeneration;
+    uint32_t journalSnapshotSize;
+
+    pendingLen = 0;
+    storedSize = 0;
+
+    if (!f) {
+        return false;
+    }
+
+    if (!read(f, rec) || rec.op != journalBegin ||
+        !rec.getVarint(journalGeneration) || !rec.getVarint(journalSnapshotSize) ||
+        journalGeneration != generation || journalSnapshotSize != snapshotSize) {
+        f.close();
+        return false;
+    }
+
+    while (read(f, rec)) {
+        fn(rec);
+    }
+
+    bool complete = f.position() == f.size();
+
+    storedSize = f.size();
+    f.close();
+    return complete;
+}
+
+// reads the next record, if there is a whole one that checks
+bool SprinklerJournal::read(File& f, JournalRecord_t& rec) {
+    uint8_t header[3];
+    size_t start = f.position();
+
+    if (f.read(header, 2) != 2) {
+        f.seek(start);
+        return false;
+    }
+
+    uint32_t len = header[1] & 0x7f;
+
+    if (header[1] & 0x80) {
+        if (f.read(header + 2, 1) != 1) {
+            f.seek(start);
+            return false;
+        }
+        len |= (uint32_t)(header[2] & 0x7f) << 7;
+    }
+
+    uint8_t check;
+
+    if (len > JOURNAL_PAYLOAD_MAX ||
+        f.read(rec.data, len) != len ||
+        f.read(&check, 1) != 1) {
+        f.seek(start);
+        return false;
+    }
+
+    rec.op = (JournalOp_t)header[0];
+    rec.len = len;
+    rec.pos = 0;
+    rec.overflowed = false;
+
+    if (check != checkByte(rec)) {
+        f.seek(start);
+        return false;
+    }
+    return true;
+}
+
+size_t SprinklerJournal::encode(uint8_t* out, const JournalRecord_t& rec) {
+    size_t n = 0;
+
+    out[n++] = rec.op;
+
+    if (rec.len >= 0x80) {
+        out[n++] = (uint8_t)(rec.len | 0x80);
+        out[n++] = (uint8_t)(rec.len >> 7);
+    } else {
+        out[n++] = (uint8_t)rec.len;
+    }
+
+    memcpy(out + n, rec.data, rec.len);
+    n += rec.len;
+    out[n++] = checkByte(rec);
+    return n;
+}
+
+/**
+ * SprinklerJournal::record()
+ *
+ * Adds the record to the ones waiting for flush().  Returns false if it
+ * can't be journaled, because it overflowed or because there is no room
+ * for it and the pending records can't be written.
+ */
+bool SprinklerJournal::record(const JournalRecord_t& rec) {
+    if (rec.overflowed) {
+        return false;
+    }
+
+    if (pendingLen + MAX_RECORD_SIZE > sizeof(pending) && !flush()) {
+        return false;
+    }
+
+    pendingLen += encode(pending + pendingLen, rec);
+    return true;
+}
+
+/**
+ * SprinklerJournal::flush()
+ *
+ * Appends every pending record to the journal with a single open/close.
+ * Returns false (and keeps the records pending) if the file couldn't be
+ * opened or the write fell short, in which case the state has to be written
+ * as a new snapshot instead.  Since replaying stops at a torn record, which
+ * would lose every record after it, nothing more is appended after a short
+ * write until restart().  After discard(), the records are dropped until
+ * restart().
+ */
+bool SprinklerJournal::flush() {
+    if (pendingLen == 0) {
+        return true;
+    }
+
+    // without its begin record the journal follows no snapshot (see
+    // discard()), so there is nothing the records could be replayed onto
+
+    if (failed) {
+        return false;
+    }
+
+    if (storedSize == 0) {
+        pendingLen = 0;
+        return true;
+    }
+
+    File f = LittleFS.open(JOURNAL_PATH, "a");
+
+    if (!f) {
+        return false;
+    }
+
+    size_t n = f.write(pending, pendingLen);
+    f.close();
+    writes++;
+
+    if (n != pendingLen) {
+        failed = true;
+        return false;
+    }
+
+    storedSize += n;
+    pendingLen = 0;
+    return true;
+}
+
+/**
+ * SprinklerJournal::restart()
+ *
+ * Starts an empty journal for the snapshot just written (or loaded).  The
+ * records still pending are dropped, since the snapshot has their changes.
+ * Returns false if the begin record couldn't be written, in which case
+ * nothing is appended (flush() fails) until a restart() succeeds.
+ */
+bool SprinklerJournal::restart(uint32_t generation, uint32_t snapshotSize) {
+    JournalRecord_t begin(journalBegin);
+    uint8_t out[MAX_RECORD_SIZE];
+
+    begin.putVarint(generation).putVarint(snapshotSize);
+
+    size_t n = encode(out, begin);
+    File f = LittleFS.open(JOURNAL_PATH, "w");
+
+    failed = !f || f.write(out, n) != n;
+
+    if (f) {
+        f.close();
+    }
+
+    storedSize = n;
+    pendingLen = 0;
+    writes++;
+    return !failed;
+}
+
+/**
+ * SprinklerJournal::discard()
+ *
+ * Removes the journal, for a snapshot that is replaced by something other
+ * than SprinklerAPI (an uploaded cycles.json).  Nothing is journaled again
+ * until the journal is started over for the new snapshot by restart().
+ */
+void SprinklerJournal::discard() {
+    LittleFS.remove(JOURNAL_PATH);
+
+    storedSize = 0;
+    pendingLen = 0;
+    failed = false;
+    writes++;
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <functional>
+
+/**
+ * SprinklerJournal
+ *
+ * The controller's state is persisted as a snapshot (/cycles.json, written
+ * by SprinklerAPI::serializeCycleItems()) plus this journal of the changes
+ * made since the snapshot was written (/journal.bin).  A change costs a
+ * record of a few bytes appended to the journal instead of a rewrite of the
+ * whole snapshot, and the snapshot is only ever replaced whole (it is
+ * written to a temporary file that is renamed over it), so a crash while
+ * writing can lose the last change but never the cycles.
+ *
+ * Every record is an opcode byte, a varint length, the payload and a check
+ * byte.  The journal only frames the records; what the opcodes and their
+ * payloads mean is up to SprinklerAPI.  The first record (journalBegin)
+ * names the snapshot that the journal follows, by its generation and size,
+ * so that a journal is only replayed onto the snapshot it was written for
+ * (and not, say, onto a cycles.json that was uploaded since).  Replaying
+ * stops at the first record that is cut short or doesn't check.
+ *
+ * Like the log, records are collected in RAM and appended with a single
+ * write by flush(), which SprinklerAPI::loop() invokes at the end of every
+ * pass, so everything changed in one pass costs one write.  Once the journal
+ * is larger than JOURNAL_COMPACT_SIZE, the state is written as a new
+ * snapshot and the journal is started over (compaction).
+ */
+
+#ifndef JOURNAL_BUFFER_SIZE
+#define JOURNAL_BUFFER_SIZE 512
+#endif
+
+#ifndef JOURNAL_COMPACT_SIZE
+#define JOURNAL_COMPACT_SIZE 4096
+#endif
+
+// longer records can't be journaled (the state is compacted instead)
+#define JOURNAL_PAYLOAD_MAX 255
+
+// be sure to keep journalOpNames[] in sync in .cpp file
+typedef enum JournalOp : uint8_t {
+    journalBegin = 1,       // varint generation, varint size of the snapshot
+    journalCycle,           // a cycle added or replaced (CycleItem::toJournal())
+    journalCycleDelete,     // the name of a deleted cycle
+    journalClear,           // every cycle deleted
+    journalHold,            // int8 holdDays, varint holdEpoch
+    journalAdj,             // seasonalAdjustment
+    journalToggleDelay,     // varint toggleDelay
+    journalSchedule         // paused, varint epoch and remaining (ScheduleProgress_t),
+                            // count, then varint zones and runTime of each item
+} JournalOp_t;
+
+extern const char* journalOpNames[];
+
+/**
+ * JournalRecord_t
+ *
+ * A record to be journaled, built up with the put...() methods, or one
+ * being replayed, which is taken apart with the get...() methods (they
+ * return false when the payload runs out).  A record that outgrows
+ * JOURNAL_PAYLOAD_MAX is marked overflowed and can't be journaled.
+ */
+
+typedef struct JournalRecord {
+    JournalOp_t op;
+    uint8_t data[JOURNAL_PAYLOAD_MAX];
+    size_t len = 0;
+    size_t pos = 0;
+    bool overflowed = false;
+
+    JournalRecord(JournalOp_t op = journalBegin): op(op) {}
+
+    JournalRecord& putByte(uint8_t b);
+    JournalRecord& putVarint(uint32_t value);
+    JournalRecord& putString(const char* s);
+    bool getByte(uint8_t& b);
+    bool getVarint(uint32_t& value);
+    bool getString(char* s, size_t size);
+} JournalRecord_t;
+
+class SprinklerJournal {
+    public:
+        typedef std::function<void(JournalRecord_t& rec)> Replayer_t;
+
+        bool replay(uint32_t generation, uint32_t snapshotSize, Replayer_t fn);
+        bool record(const JournalRecord_t& rec);
+        bool flush();
+        bool restart(uint32_t generation, uint32_t snapshotSize);
+        void discard();
+        size_t size() const { return storedSize + pendingLen; }
+        bool needsCompaction() const { return size() > JOURNAL_COMPACT_SIZE; }
+        // changes whenever the journal writes to its file
+        uint32_t getWrites() const { return writes; }
+
+    private:
+        uint8_t pending[JOURNAL_BUFFER_SIZE];
+        size_t pendingLen = 0;
+        size_t storedSize = 0;
+        uint32_t writes = 0;
+        // a write failed, so nothing more is appended until restart()
+        bool failed = false;
+
+        static bool read(File& f, JournalRecord_t& rec);
+        static size_t encode(uint8_t* out, const JournalRecord_t& rec);
+};
@@ -0,0 +1,757 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SprinklerLog.hpp>
+#include <SprinklerAPI.hpp>
+
+#define SECONDS_PER_DAY 86400UL
+
+// logSeq and its varint, logDay and its 4 byte epoch, opcode, 3 varints, and
+// the text
+#define MAX_RECORD_SIZE (1 + 5 + 1 + 4 + 1 + 3 * 5 + LOG_TEXT_MAX)
+
+// a rendered line: timestamp, separators, zones or text, and the newline
+#define LOG_LINE_MAX (LOG_TEXT_MAX + 32)
+
+const char* logOpNames[] = {
+    "",
+    "day",
+    "on",
+    "off",
+    "text",
+    "seq"
+};
+
+static size_t putVarint(uint8_t* out, uint32_t value) {
+    size_t len = 0;
+
+    while (value >= 0x80) {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+/**
+ * LogRecord::format()
+ *
+ * Renders the record as a line of the text log, without the newline, e.g.
+ * "0824 183500|on|2|253".  Returns the length of the line (which, like
+ * snprintf(), may be more than was written if buff is too small).
+ */
+size_t LogRecord::format(char* buff, size_t size) const {
+    time_t tt = epoch;
+    struct tm* t = localtime(&tt);
+    size_t len = strftime(buff, size, "%m%d %H%M%S|", t);
+    int n;
+
+    if (op == logZonesOn || op == logZonesOff) {
+        n = snprintf(
+            buff + len, size - len,
+            "%s|%s|%lu",
+            logOpNames[op],
+            (zones == allRegistersMask) ? "all" : bitFieldtoString(zones).c_str(),
+            (unsigned long)registers
+        );
+    } else {
+        n = snprintf(buff + len, size - len, "%.*s", (int)textLen, text);
+    }
+    return len + ((n > 0) ? n : 0);
+}
+
+bool LogQuery::matches(const LogRecord_t& rec) const {
+    if (rec.epoch < since || rec.epoch > until || rec.seq < from) {
+        return false;
+    }
+
+    if (zone > 0) {
+        bool isZoneOp = (rec.op == logZonesOn || rec.op == logZonesOff);
+
+        if (!isZoneOp || zone > 32 || !(rec.zones & (1UL << (zone - 1)))) {
+            return false;
+        }
+    }
+
+    if (op[0] != '\0') {
+        if (rec.op == logText) {
+            size_t len = strlen(op);
+
+            // the first field of the message, e.g. "schd" of "schd|cancel"
+            if (rec.textLen < len || strncmp(rec.text, op, len) != 0 ||
+                (rec.textLen > len && rec.text[len] != '|')) {
+                return false;
+            }
+        } else if (strcmp(op, logOpNames[rec.op]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// writes s to out as the contents of a JSON string, truncating it rather
+// than writing more than size bytes
+static size_t putJsonString(char* out, size_t size, const char* s, size_t len) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = s[i];
+
+        if (c == '"' || c == '\\') {
+            if (n + 2 > size) break;
+            out[n++] = '\\';
+            out[n++] = c;
+        } else if ((uint8_t)c < 0x20) {
+            if (n + 6 > size) break;
+            n += snprintf(out + n, 7, "\\u%04x", (unsigned)c);
+        } else {
+            if (n + 1 > size) break;
+            out[n++] = c;
+        }
+    }
+    return n;
+}
+
+/**
+ * LogRecord::toJson()
+ *
+ * Renders the record as {"seq": 12, "line": "0824 183500|on|2|253"}.
+ * Returns the length written, which is always less than size (the line is
+ * truncated if it has to be).
+ */
+size_t LogRecord::toJson(char* buff, size_t size) const {
+    char line[LOG_LINE_MAX];
+    size_t lineLen = format(line, sizeof(line));
+    int len = snprintf(buff, size, "{\"seq\": %lu, \"line\": \"", (unsigned long)seq);
+
+    if (len < 0 || (size_t)len + 3 > size) {
+        return 0;
+    }
+
+    if (lineLen > sizeof(line) - 1) {
+        lineLen = sizeof(line) - 1;
+    }
+
+    len += putJsonString(buff + len, size - len - 3, line, lineLen);
+    buff[len++] = '"';
+    buff[len++] = '}';
+    buff[len] = '\0';
+    return len;
+}
+
+/*****************************************************************************
+ * SprinklerLog
+ ****************************************************************************/
+
+/**
+ * SprinklerLog::begin()
+ *
+ * Finds the segments already on the filesystem.  Must be invoked after
+ * LittleFS.begin() and before anything is logged.
+ */
+void SprinklerLog::begin() {
+    bool found = false;
+
+    storedSize = 0;
+
+    for (Dir dir = LittleFS.openDir("/"); dir.next();) {
+        String name = dir.fileName();
+
+        if (name.startsWith("/")) {
+            name = name.substring(1);
+        }
+
+        if (!name.startsWith("log-") || !name.endsWith(".bin")) {
+            continue;
+        }
+
+        uint32_t segment = strtoul(name.c_str() + 4, nullptr, 10);
+
+        if (segment == 0) {
+            continue;
+        }
+
+        storedSize += dir.fileSize();
+
+        if (!found || segment < firstSegment) {
+            firstSegment = segment;
+        }
+        if (!found || segment > lastSegment) {
+            lastSegment = segment;
+            lastSegmentSize = dir.fileSize();
+        }
+        found = true;
+    }
+
+    // the log from before it was split into segments becomes the first one
+    if (!found && LittleFS.exists("/log.bin")) {
+        File f = LittleFS.open("/log.bin", "r");
+
+        storedSize = lastSegmentSize = f.size();
+        f.close();
+        LittleFS.rename("/log.bin", segmentPath(1).c_str());
+    }
+
+    buildIndex();
+}
+
+/**
+ * SprinklerLog::buildIndex()
+ *
+ * Reads the whole log once to find where each segment starts and the next
+ * sequence number.  Segments without records start at the next sequence
+ * number.
+ */
+void SprinklerLog::buildIndex() {
+    Reader reader(*this);
+    LogRecord_t rec;
+
+    segmentStarts.assign(segmentCount(), {UINT32_MAX, 0});
+    nextSeq = 0;
+
+    while (reader.next(rec)) {
+        LogSegmentStart_t& start = segmentStarts[reader.getSegment() - firstSegment];
+
+        if (start.seq == UINT32_MAX) {
+            start = {rec.seq, rec.epoch};
+        }
+        nextSeq = rec.seq + 1;
+    }
+
+    for (LogSegmentStart_t& start : segmentStarts) {
+        if (start.seq == UINT32_MAX) {
+            start.seq = nextSeq;
+        }
+    }
+}
+
+void SprinklerLog::logZones(LogOp_t op, unsigned long epoch, uint32_t zones, uint32_t registers) {
+    append(op, epoch, zones, registers, nullptr, 0);
+}
+
+void SprinklerLog::logMessage(unsigned long epoch, const char* text) {
+    size_t len = strlen(text);
+
+    append(logText, epoch, 0, 0, text, (len > LOG_TEXT_MAX) ? LOG_TEXT_MAX : len);
+}
+
+/**
+ * SprinklerLog::append()
+ *
+ * Encodes a record into the pending buffer.  Only touches the file when the
+ * buffer has to make room for the record.
+ */
+void SprinklerLog::append(
+    LogOp_t op,
+    unsigned long epoch,
+    uint32_t zones,
+    uint32_t registers,
+    const char* text,
+    size_t textLen
+) {
+    uint8_t record[MAX_RECORD_SIZE];
+    size_t len = encode(record, op, epoch, zones, registers, text, textLen);
+    bool segmentFull = (lastSegmentSize + pendingLen + len > LOG_SEGMENT_SIZE);
+
+    if (segmentFull || pendingLen + len > LOG_BUFFER_SIZE) {
+        if (!flush()) {
+            // the records that follow need their sequence number and day
+            // since the ones before them are gone
+            pendingLen = 0;
+            lastMidnight = 0;
+            seqNeeded = true;
+        }
+
+        if (segmentFull) {
+            startSegment();
+        }
+
+        // the record may now need a logDay record ahead of it
+        len = encode(record, op, epoch, zones, registers, text, textLen);
+    }
+
+    if (pendingLen == 0) {
+        oldestPendingMillis = millis();
+    }
+
+    // the first record of a segment is where the segment starts
+    if (lastSegmentSize == 0 && pendingLen == 0) {
+        segmentStarts.back() = {nextSeq, epoch};
+    }
+
+    memcpy(pending + pendingLen, record, len);
+    pendingLen += len;
+    nextSeq++;
+    seqNeeded = false;
+
+    if (listener) {
+        LogRecord_t rec;
+
+        rec.seq = nextSeq - 1;
+        rec.op = op;
+        rec.epoch = epoch;
+        rec.zones = zones;
+        rec.registers = registers;
+        rec.textLen = textLen;
+        if (textLen > 0) {
+            memcpy(rec.text, text, textLen);
+        }
+        rec.text[textLen] = '\0';
+
+        listener(rec);
+    }
+
+    lastMidnight = epoch - (epoch % SECONDS_PER_DAY);
+    lastSecondOfDay = epoch % SECONDS_PER_DAY;
+}
+
+/**
+ * SprinklerLog::encode()
+ *
+ * Encodes a record (preceded by a logSeq record if it starts a segment, and
+ * by a logDay record if the day changed, or the clock went backwards) into
+ * out, which must hold MAX_RECORD_SIZE bytes.  Returns the number of bytes
+ * used.
+ */
+size_t SprinklerLog::encode(
+    uint8_t* out,
+    LogOp_t op,
+    unsigned long epoch,
+    uint32_t zones,
+    uint32_t registers,
+    const char* text,
+    size_t textLen
+) const {
+    unsigned long midnight = epoch - (epoch % SECONDS_PER_DAY);
+    unsigned long secondOfDay = epoch % SECONDS_PER_DAY;
+    unsigned long base = lastSecondOfDay;
+    size_t len = 0;
+
+    if (seqNeeded) {
+        out[len++] = logSeq;
+        len += putVarint(out + len, nextSeq);
+    }
+
+    if (midnight != lastMidnight || secondOfDay < lastSecondOfDay) {
+        out[len++] = logDay;
+
+        for (uint8_t i = 0; i < 4; i++) {
+            out[len++] = (uint8_t)(midnight >> (8 * i));
+        }
+        base = 0;
+    }
+
+    out[len++] = op;
+    len += putVarint(out + len, secondOfDay - base);
+
+    if (op == logText) {
+        len += putVarint(out + len, textLen);
+        memcpy(out + len, text, textLen);
+        len += textLen;
+    } else {
+        len += putVarint(out + len, zones);
+        len += putVarint(out + len, registers);
+    }
+    return len;
+}
+
+/**
+ * SprinklerLog::loop()
+ *
+ * Flushes the pending records once there are enough of them or the oldest
+ * is old enough.  Intended to be invoked from SprinklerAPI::loop().
+ */
+void SprinklerLog::loop(unsigned long now) {
+    if (pendingLen == 0) {
+        return;
+    }
+
+    if (pendingLen >= flushThreshold || now - oldestPendingMillis >= flushInterval) {
+        flush();
+    }
+}
+
+/**
+ * SprinklerLog::flush()
+ *
+ * Appends every pending record to the file with a single open/close.
+ * Returns false (and keeps the records pending) if the file couldn't be
+ * opened.
+ */
+bool SprinklerLog::flush() {
+    if (pendingLen == 0) {
+        return true;
+    }
+
+    File f = LittleFS.open(segmentPath(lastSegment), "a");
+
+    if (!f) {
+        // try again at the next interval rather than on every loop()
+        oldestPendingMillis = millis();
+        return false;
+    }
+
+    f.write(pending, pendingLen);
+    f.close();
+
+    lastSegmentSize += pendingLen;
+    storedSize += pendingLen;
+    pendingLen = 0;
+    writes++;
+    return true;
+}
+
+/**
+ * SprinklerLog::startSegment()
+ *
+ * Moves on to a new (empty) segment, removing the oldest segments that no
+ * longer fit in the budget.
+ */
+void SprinklerLog::startSegment() {
+    lastSegment++;
+    lastSegmentSize = 0;
+    lastMidnight = 0;
+    seqNeeded = true;
+    segmentStarts.push_back({nextSeq, 0});
+
+    while (segmentCount() > maxSegments) {
+        String oldest = segmentPath(firstSegment++);
+
+        segmentStarts.pop_front();
+        File f = LittleFS.open(oldest, "r");
+
+        if (f) {
+            storedSize -= f.size();
+            f.close();
+        }
+        LittleFS.remove(oldest);
+        writes++;
+    }
+}
+
+void SprinklerLog::reset() {
+    for (uint32_t segment = firstSegment; segment <= lastSegment; segment++) {
+        LittleFS.remove(segmentPath(segment));
+    }
+    writes++;
+
+    firstSegment = lastSegment = 1;
+    lastSegmentSize = 0;
+    storedSize = 0;
+    pendingLen = 0;
+    lastMidnight = 0;
+    seqNeeded = true;
+
+    // sequence numbers carry on, so a client that is following the log
+    // doesn't mistake new records for ones it has already seen
+    segmentStarts.assign(1, {nextSeq, 0});
+}
+
+/**
+ * SprinklerLog::size()
+ *
+ * The size of the (binary) log as it will be once it is flushed.
+ */
+size_t SprinklerLog::size() const {
+    return storedSize + pendingLen;
+}
+
+bool SprinklerLog::exists() const {
+    return storedSize > 0 || pendingLen > 0;
+}
+
+String SprinklerLog::segmentPath(uint32_t segment) {
+    char path[24];
+
+    snprintf(path, sizeof(path), "/log-%lu.bin", (unsigned long)segment);
+    return String(path);
+}
+
+/**
+ * SprinklerLog::send()
+ *
+ * Sends the whole log, rendered as text/plain, including the records that
+ * have not been flushed yet.  The response is chunked because its length
+ * isn't known until the log has been rendered.
+ */
+void SprinklerLog::send(SprinklerWebServer& server) const {
+    Reader reader(*this);
+    LogRecord_t rec;
+    char buff[512];
+    size_t len = 0;
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+
+    while (reader.next(rec)) {
+        if (sizeof(buff) - len < LOG_LINE_MAX) {
+            server.sendContent(buff, len);
+            len = 0;
+        }
+
+        // format() leaves room for the newline
+        size_t lineLen = rec.format(buff + len, LOG_LINE_MAX - 1);
+
+        if (lineLen > LOG_LINE_MAX - 2) {
+            lineLen = LOG_LINE_MAX - 2;
+        }
+        buff[len + lineLen] = '\n';
+        len += lineLen + 1;
+    }
+
+    if (len > 0) {
+        server.sendContent(buff, len);
+    }
+    server.sendContent("");
+}
+
+/**
+ * SprinklerLog::findSegment()
+ *
+ * Uses the index to find where a Reader looking for the records at or
+ * after both the given time and sequence number should start:  the later
+ * of the latest segment that starts before since and the latest one that
+ * starts at or before from.  (A segment that starts in the second of since
+ * may follow records of that second, hence "before".)  Pass 0 for either
+ * to leave it out.
+ */
+uint32_t SprinklerLog::findSegment(unsigned long since, uint32_t from) const {
+    size_t bySince = 0;
+    size_t byFrom = 0;
+
+    for (size_t i = 1; i < segmentStarts.size(); i++) {
+        const LogSegmentStart_t& start = segmentStarts[i];
+
+        // an epoch of 0 is a segment without records yet (or records
+        // logged before the clock was set), which says nothing about since
+        if (start.epoch != 0 && start.epoch < since) {
+            bySince = i;
+        }
+        if (start.seq <= from) {
+            byFrom = i;
+        }
+    }
+    return firstSegment + std::max(bySince, byFrom);
+}
+
+/**
+ * SprinklerLog::query()
+ *
+ * Sends the records that match the query as JSON:
+ *
+ *      {"status": "ok", "segment": n, "records": [[seq, "line"], ...], "next": seq}
+ *
+ * where segment is the segment reading started at (see findSegment()) and
+ * each line is the record rendered as in the text log.  When more
+ * records match than the limit, "next" is the sequence number to pass as
+ * "from" to get the next page, otherwise it is null.
+ *
+ * The index is used to skip the segments before since and from, and
+ * reading stops at the first record after until (the
+ * clock only goes backwards when NTP corrects it, so this is close enough).
+ */
+void SprinklerLog::query(SprinklerWebServer& server, const LogQuery_t& query) const {
+    uint32_t segment = findSegment(query.since, query.from);
+    Reader reader(*this, segment);
+    LogRecord_t rec;
+    char buff[768];
+    size_t len = 0;
+    size_t count = 0;
+    bool more = false;
+
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    len = sprintf(
+        buff,
+        "{\"status\": \"ok\", \"segment\": %lu, \"records\": [",
+        (unsigned long)segment
+    );
+
+    while (reader.next(rec)) {
+        if (rec.epoch > query.until) {
+            break;
+        }
+
+        if (!query.matches(rec)) {
+            continue;
+        }
+
+        if (count == query.limit) {
+            more = true;
+            break;
+        }
+
+        // room for the separator, seq, line and closing of one record
+        if (sizeof(buff) - len < 2 * LOG_LINE_MAX) {
+            server.sendContent(buff, len);
+            len = 0;
+        }
+
+        char line[LOG_LINE_MAX];
+        size_t lineLen = rec.format(line, sizeof(line));
+
+        if (lineLen > sizeof(line) - 1) {
+            lineLen = sizeof(line) - 1;
+        }
+
+        len += sprintf(buff + len, "%s[%lu, \"", (count > 0) ? ", " : "", (unsigned long)rec.seq);
+        len += putJsonString(buff + len, sizeof(buff) - len - 48, line, lineLen);
+        buff[len++] = '"';
+        buff[len++] = ']';
+        count++;
+    }
+
+    if (more) {
+        len += sprintf(buff + len, "], \"next\": %lu}\n", (unsigned long)rec.seq);
+    } else {
+        len += sprintf(buff + len, "], \"next\": null}\n");
+    }
+
+    server.sendContent(buff, len);
+    server.sendContent("");
+}
+
+/*****************************************************************************
+ * SprinklerLog::Reader
+ ****************************************************************************/
+
+SprinklerLog::Reader::Reader(const SprinklerLog& log, uint32_t segment):
+    log(log), segment((segment >= log.firstSegment) ? segment : log.firstSegment)
+{
+    // the segment's logSeq record sets this too, but the index is needed
+    // for a segment that was written before there were logSeq records
+    if (log.segmentStarts.size() == log.segmentCount()) {
+        seq = log.segmentStarts[this->segment - log.firstSegment].seq;
+    }
+}
+
+/**
+ * SprinklerLog::Reader::next()
+ *
+ * Decodes the next record into rec, skipping over logDay records.  Returns
+ * false at the end of the log (or at a record that was only partially
+ * written).
+ */
+bool SprinklerLog::Reader::next(LogRecord_t& rec) {
+    while (true) {
+        int op = read();
+        uint32_t delta;
+
+        if (op < 0) {
+            return false;
+        }
+
+        if (op == logDay) {
+            midnight = 0;
+
+            for (uint8_t i = 0; i < 4; i++) {
+                int b = read();
+
+                if (b < 0) return false;
+                midnight |= (unsigned long)b << (8 * i);
+            }
+            secondOfDay = 0;
+            continue;
+        }
+
+        if (op == logSeq) {
+            if (!readVarint(seq)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (op < logZonesOn || op > logText || !readVarint(delta)) {
+            return false;
+        }
+
+        secondOfDay += delta;
+        rec.seq = seq++;
+        rec.op = (LogOp_t)op;
+        rec.epoch = midnight + secondOfDay;
+        rec.zones = 0;
+        rec.registers = 0;
+        rec.textLen = 0;
+
+        if (op == logText) {
+            uint32_t textLen;
+
+            if (!readVarint(textLen) || textLen > LOG_TEXT_MAX) {
+                return false;
+            }
+
+            for (uint32_t i = 0; i < textLen; i++) {
+                int c = read();
+
+                if (c < 0) return false;
+                rec.text[i] = (char)c;
+            }
+            rec.textLen = textLen;
+        } else if (!readVarint(rec.zones) || !readVarint(rec.registers)) {
+            return false;
+        }
+
+        rec.text[rec.textLen] = '\0';
+        return true;
+    }
+}
+
+// the next byte of the segments, then of the pending records, or -1 at the
+// end
+int SprinklerLog::Reader::read() {
+    while (buffPos == buffLen && segment <= log.lastSegment) {
+        if (!f) {
+            f = LittleFS.open(segmentPath(segment), "r");
+        }
+
+        buffLen = (f) ? f.read(buff, sizeof(buff)) : 0;
+        buffPos = 0;
+
+        if (buffLen == 0) {
+            f.close();
+            segment++;
+        }
+    }
+
+    if (buffPos < buffLen) {
+        return buff[buffPos++];
+    }
+
+    if (pendingPos < log.pendingLen) {
+        return log.pending[pendingPos++];
+    }
+    return -1;
+}
+
+bool SprinklerLog::Reader::readVarint(uint32_t& value) {
+    value = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        int b = read();
+
+        if (b < 0) {
+            return false;
+        }
+
+        value |= (uint32_t)(b & 0x7f) << shift;
+
+        if (!(b & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <SprinklerWebServer.hpp>
+#include <LittleFS.h>
+#include <deque>
+#include <functional>
+
+/**
+ * SprinklerLog
+ *
+ * The controller's log.  It is stored in a compact binary format and
+ * rendered back to text lines ("MMDD HHMMSS|message") only when it is read.
+ * Every record starts with an opcode byte:
+ *
+ *  - logDay:       the local midnight epoch (4 bytes, little endian) of the
+ *                  records that follow
+ *  - logZonesOn:   varint seconds since the previous record (or since
+ *  - logZonesOff:  midnight after a logDay), varint zone mask, varint
+ *                  register value
+ *  - logText:      varint seconds as above, varint length, then the text of
+ *                  any other message
+ *  - logSeq:       varint sequence number of the record that follows
+ *
+ * A logDay record is written ahead of the first record of each day (and of
+ * the first record after a restart), so a typical zone change takes around 6
+ * bytes instead of the ~20 of its text line.
+ *
+ * Records are not written to flash as they are logged; instead they are
+ * collected in a RAM buffer, which is appended to the file in one batch when
+ * it is more than flushThreshold bytes full, when its oldest record has
+ * waited flushInterval ms, or when flush() is invoked explicitly (before a
+ * restart or an OTA update).  This keeps LittleFS open/close cycles (and
+ * flash erases) out of zone switching.
+ *
+ * Records that are still pending are lost if the controller crashes or
+ * loses power, and they are discarded if the buffer fills up while the file
+ * can't be written.
+ *
+ * The log is stored in segment files (/log-1.bin, /log-2.bin, ...) of at
+ * most LOG_SEGMENT_SIZE bytes.  A new segment is started (with a logDay
+ * record, so each segment can be read on its own) when the records being
+ * flushed don't fit in the current one, and the oldest segments are removed
+ * to keep the whole log within LOG_BUDGET bytes.  This keeps appends small
+ * and leaves the rest of the filesystem to cycles.json.
+ *
+ * Every record has a sequence number, one more than the record before it.
+ * Each segment starts with a logSeq record so the numbering survives the
+ * removal of old segments.  The first sequence number and time of every
+ * segment are kept in RAM as a sparse index, which query() uses to skip the
+ * segments that can't hold any of the records asked for.
+ */
+
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE 1024
+#endif
+
+#ifndef LOG_SEGMENT_SIZE
+#define LOG_SEGMENT_SIZE 8192
+#endif
+
+#ifndef LOG_BUDGET
+#define LOG_BUDGET (8 * LOG_SEGMENT_SIZE)
+#endif
+
+static_assert(
+    LOG_BUFFER_SIZE <= LOG_SEGMENT_SIZE && LOG_SEGMENT_SIZE <= LOG_BUDGET,
+    "LOG_BUFFER_SIZE <= LOG_SEGMENT_SIZE <= LOG_BUDGET is required"
+);
+
+// longer messages are truncated
+#define LOG_TEXT_MAX 255
+
+// be sure to keep logOpNames[] in sync in .cpp file
+typedef enum LogOp : uint8_t {
+    logDay = 1,
+    logZonesOn,
+    logZonesOff,
+    logText,
+    logSeq
+} LogOp_t;
+
+extern const char* logOpNames[];
+
+typedef struct LogRecord {
+    uint32_t seq;
+    LogOp_t op;
+    unsigned long epoch;
+    uint32_t zones;
+    uint32_t registers;
+    size_t textLen;
+    char text[LOG_TEXT_MAX + 1];
+
+    size_t format(char* buff, size_t size) const;
+    size_t toJson(char* buff, size_t size) const;
+} LogRecord_t;
+
+/**
+ * LogQuery_t
+ *
+ * Selects records for SprinklerLog::query().  A record matches when its time
+ * is within since..until, its sequence number is at least from, it is a
+ * zone record for zone (if zone isn't 0) and its op is op (if op isn't
+ * empty).  The op of a text record is its first field, e.g. "schd" or
+ * "mark".  At most limit records are returned.
+ */
+
+typedef struct LogQuery {
+    unsigned long since = 0;
+    unsigned long until = ULONG_MAX;
+    uint32_t from = 0;
+    uint8_t zone = 0;
+    char op[16] = "";
+    size_t limit = 100;
+
+    bool matches(const LogRecord_t& rec) const;
+} LogQuery_t;
+
+// one entry of the sparse index: where each segment starts
+typedef struct LogSegmentStart {
+    uint32_t seq;
+    unsigned long epoch;
+} LogSegmentStart_t;
+
+class SprinklerLog {
+    public:
+        typedef std::function<void(const LogRecord_t& rec)> Listener_t;
+
+        static const size_t flushThreshold = LOG_BUFFER_SIZE * 3 / 4;
+        static const unsigned long flushInterval = 60UL * 1000UL;
+        static const uint32_t maxSegments = LOG_BUDGET / LOG_SEGMENT_SIZE;
+
+        /**
+         * Reader
+         *
+         * Decodes the log from the start of a segment (the oldest by
+         * default) through the records that are still pending, one record
+         * at a time.
+         */
+        class Reader {
+            public:
+                Reader(const SprinklerLog& log, uint32_t segment = 0);
+                ~Reader() { f.close(); }
+
+                bool next(LogRecord_t& rec);
+                // the segment of the last record (pending records are in the
+                // last segment)
+                uint32_t getSegment() const {
+                    return (segment <= log.lastSegment) ? segment : log.lastSegment;
+                }
+
+            private:
+                const SprinklerLog& log;
+                uint32_t segment;
+                uint32_t seq = 0;
+                File f;
+                uint8_t buff[128];
+                size_t buffLen = 0;
+                size_t buffPos = 0;
+                size_t pendingPos = 0;
+                unsigned long midnight = 0;
+                unsigned long secondOfDay = 0;
+
+                int read();
+                bool readVarint(uint32_t& value);
+        };
+
+        void begin();
+        void logZones(LogOp_t op, unsigned long epoch, uint32_t zones, uint32_t registers);
+        void logMessage(unsigned long epoch, const char* text);
+        void loop(unsigned long now);
+        bool flush();
+        void reset();
+        size_t size() const;
+        size_t pendingSize() const { return pendingLen; }
+        uint32_t segmentCount() const { return lastSegment - firstSegment + 1; }
+        bool exists() const;
+        uint32_t getNextSeq() const { return nextSeq; }
+        // changes whenever the log writes to (or removes) a file
+        uint32_t getWrites() const { return writes; }
+        void send(SprinklerWebServer& server) const;
+        void query(SprinklerWebServer& server, const LogQuery_t& query) const;
+        uint32_t findSegment(unsigned long since, uint32_t from) const;
+        uint32_t getFirstSegment() const { return firstSegment; }
+        const std::deque<LogSegmentStart_t>& getSegmentStarts() const { return segmentStarts; }
+
+        // the listener is handed every record as it is logged
+        void setListener(Listener_t fn) { listener = fn; }
+
+    private:
+        uint32_t firstSegment = 1;
+        uint32_t lastSegment = 1;
+        size_t lastSegmentSize = 0;
+        size_t storedSize = 0;
+        std::deque<LogSegmentStart_t> segmentStarts;
+        uint32_t nextSeq = 0;
+        bool seqNeeded = true;
+        Listener_t listener;
+        uint32_t writes = 0;
+        uint8_t pending[LOG_BUFFER_SIZE];
+        size_t pendingLen = 0;
+        unsigned long oldestPendingMillis = 0L;
+
+        // the day and time of the last record appended, which the next
+        // record's time is encoded relative to (0 forces a logDay record)
+        unsigned long lastMidnight = 0;
+        unsigned long lastSecondOfDay = 0;
+
+        static String segmentPath(uint32_t segment);
+        void buildIndex();
+        void startSegment();
+        void append(
+            LogOp_t op,
+            unsigned long epoch,
+            uint32_t zones,
+            uint32_t registers,
+            const char* text,
+            size_t textLen
+        );
+        size_t encode(
+            uint8_t* out,
+            LogOp_t op,
+            unsigned long epoch,
+            uint32_t zones,
+            uint32_t registers,
+            const char* text,
+            size_t textLen
+        ) const;
+};
@@ -0,0 +1,1153 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <SprinklerWebServer.hpp>
+
+static const char* methodNames[] = {
+    "ANY", "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS"
+};
+
+void SprinklerWebServer::Connection::reset() {
+    client = WiFiClient();
+    state = connIdle;
+    in = String();
+    method = HTTP_ANY;
+    uri = String();
+    args.clear();
+    headers.clear();
+    pathArgs.clear();
+    contentType = String();
+    bodyLength = 0;
+    bodyReceived = 0;
+    route = noRoute;
+    delimiter = String();
+    partState = partPreamble;
+    upload.reset();
+    responseHeaders = String();
+    contentLength = CONTENT_LENGTH_NOT_SET;
+    chunked = false;
+    responseStarted = false;
+    file = fs::File();
+    progmem = nullptr;
+    progmemLeft = 0;
+    parkedAt = 0;
+    parkTimeout = 0;
+    parking = false;
+    parkExpired = false;
+}
+
+void SprinklerWebServer::begin() {
+    listener.begin();
+    listener.setNoDelay(true);
+}
+
+void SprinklerWebServer::close() {
+    listener.close();
+
+    for (Connection& conn : connections) {
+        if (conn.state != connIdle) {
+            conn.client.stop();
+            release(conn);
+        }
+    }
+}
+
+void SprinklerWebServer::clearRoutes() {
+    routeNodes[0] = {"", 0, noNode, noNode, noRoute};
+    routeNodeCount = 1;
+}
+
+uint8_t SprinklerWebServer::newRouteNode(const char* label, uint8_t length) {
+    if (routeNodeCount >= WEB_MAX_ROUTE_NODES) {
+        return noNode;
+    }
+
+    routeNodes[routeNodeCount] = {label, length, noNode, noNode, noRoute};
+    return routeNodeCount++;
+}
+
+/**
+ * SprinklerWebServer::addRoute()
+ *
+ * Adds the pattern of route i to the trie.  The literal text of the
+ * pattern follows the nodes that share it (splitting the node where the
+ * pattern parts from it) and each "{}" is a node of its own.  Routes with
+ * the same pattern are kept in the order of the table.  Returns false (and
+ * the route isn't served) if WEB_MAX_ROUTE_NODES is too small.
+ */
+bool SprinklerWebServer::addRoute(uint8_t i, HTTPMethod method, const char* pattern, bool upload) {
+    uint8_t node = 0;
+    const char* p = pattern;
+
+    while (*p) {
+        bool braces = (p[0] == '{' && p[1] == '}');
+        const char* nextBraces = strstr(p, "{}");
+        uint8_t length = (braces) ? 0 : (nextBraces) ? nextBraces - p : strlen(p);
+        uint8_t c = routeNodes[node].child;
+
+        while (c != noNode) {
+            const RouteNode& child = routeNodes[c];
+
+            if ((braces) ? child.length == 0 : child.length > 0 && child.label[0] == *p) {
+                break;
+            }
+            c = child.sibling;
+        }
+
+        if (c == noNode) {
+            if ((c = newRouteNode(p, length)) == noNode) {
+                Serial.printf("route not served (see WEB_MAX_ROUTE_NODES): %s\n", pattern);
+                return false;
+            }
+
+            routeNodes[c].sibling = routeNodes[node].child;
+            routeNodes[node].child = c;
+            node = c;
+            p += (braces) ? 2 : length;
+            continue;
+        }
+
+        if (braces) {
+            node = c;
+            p += 2;
+            continue;
+        }
+
+        uint8_t common = 1;
+
+        while (common < routeNodes[c].length && common < length &&
+            routeNodes[c].label[common] == p[common]) {
+            common++;
+        }
+
+        if (common < routeNodes[c].length) {
+            uint8_t rest = newRouteNode(routeNodes[c].label + common, routeNodes[c].length - common);
+
+            if (rest == noNode) {
+                Serial.printf("route not served (see WEB_MAX_ROUTE_NODES): %s\n", pattern);
+                return false;
+            }
+
+            routeNodes[rest].child = routeNodes[c].child;
+            routeNodes[rest].route = routeNodes[c].route;
+            routeNodes[c].length = common;
+            routeNodes[c].child = rest;
+            routeNodes[c].route = noRoute;
+        }
+
+        node = c;
+        p += common;
+    }
+
+    routes[i] = {(uint8_t)method, noRoute, upload};
+
+    if (routeNodes[node].route == noRoute) {
+        routeNodes[node].route = i;
+    } else {
+        uint8_t last = routeNodes[node].route;
+
+        while (routes[last].next != noRoute) {
+            last = routes[last].next;
+        }
+        routes[last].next = i;
+    }
+
+    return true;
+}
+
+/**
+ * SprinklerWebServer::matchRoute()
+ *
+ * Returns the route for the request whose URI, from pos on, is matched by
+ * what follows the node in the trie (or noRoute), and leaves the path
+ * arguments of that route in the connection's pathArgs.  A literal child is
+ * tried ahead of a "{}", and when what follows one doesn't lead to a route
+ * for the request's method the next possibility is tried.  The time this
+ * takes depends on the length of the URI, not on the number of routes.
+ */
+uint8_t SprinklerWebServer::matchRoute(Connection& conn, uint8_t node, unsigned int pos) {
+    const String& uri = conn.uri;
+    uint8_t braces = noNode;
+    uint8_t route;
+
+    if (pos == uri.length() && (route = routeFor(node, conn.method)) != noRoute) {
+        return route;
+    }
+
+    for (uint8_t c = routeNodes[node].child; c != noNode; c = routeNodes[c].sibling) {
+        const RouteNode& child = routeNodes[c];
+
+        if (child.length == 0) {
+            braces = c;
+        } else if (strncmp(uri.c_str() + pos, child.label, child.length) == 0) {
+            route = matchRoute(conn, c, pos + child.length);
+
+            if (route != noRoute) {
+                return route;
+            }
+        }
+    }
+
+    if (braces == noNode) {
+        return noRoute;
+    }
+
+    // a "{}" that the pattern goes on from runs up to the character that
+    // the pattern goes on with
+
+    for (uint8_t c = routeNodes[braces].child; c != noNode; c = routeNodes[c].sibling) {
+        const RouteNode& child = routeNodes[c];
+        int end = uri.indexOf(child.label[0], pos);
+
+        if (end < 0 || strncmp(uri.c_str() + end, child.label, child.length) != 0) {
+            continue;
+        }
+
+        conn.pathArgs.push_back(uri.substring(pos, end));
+        route = matchRoute(conn, c, end + child.length);
+
+        if (route != noRoute) {
+            return route;
+        }
+        conn.pathArgs.pop_back();
+    }
+
+    // a "{}" that ends the pattern runs to the end of the URI
+
+    if (uri.indexOf('/', pos) < 0 && (route = routeFor(braces, conn.method)) != noRoute) {
+        conn.pathArgs.push_back(uri.substring(pos));
+        return route;
+    }
+
+    return noRoute;
+}
+
+// the first route whose pattern ends at the node that takes the method
+uint8_t SprinklerWebServer::routeFor(uint8_t node, HTTPMethod method) const {
+    uint8_t i = routeNodes[node].route;
+
+    while (i != noRoute && routes[i].method != HTTP_ANY && routes[i].method != method) {
+        i = routes[i].next;
+    }
+    return i;
+}
+
+/**
+ * SprinklerWebServer::handleClient()
+ *
+ * Invoked on every loop().  Accepts the connections that are waiting (as
+ * long as there is room for them), reads what has arrived on every open
+ * connection, sends the next piece of every file being sent, and then
+ * dispatches at most one request whose reading is complete.  Connections
+ * take turns at being dispatched, so a client sending a stream of requests
+ * can't keep the others waiting.
+ */
+void SprinklerWebServer::handleClient() {
+    Connection* ready = nullptr;
+
+    accept();
+
+    for (uint8_t n = 0; n < WEB_MAX_CONNECTIONS; n++) {
+        uint8_t i = (nextDispatch + n) % WEB_MAX_CONNECTIONS;
+        Connection& conn = connections[i];
+
+        if (conn.state == connHead || conn.state == connBody) {
+            receive(conn);
+        } else if (conn.state == connStreaming) {
+            streamMore(conn);
+        } else if (conn.state == connParked) {
+            checkParked(conn);
+        }
+
+        if (conn.state == connReady && !ready) {
+            ready = &conn;
+            nextDispatch = (i + 1) % WEB_MAX_CONNECTIONS;
+        }
+    }
+
+    if (ready) {
+        dispatch(*ready);
+    }
+}
+
+uint8_t SprinklerWebServer::connectionCount() const {
+    uint8_t count = 0;
+
+    for (const Connection& conn : connections) {
+        if (conn.state != connIdle) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// takes the waiting connections into the free places
+void SprinklerWebServer::accept() {
+    for (Connection& conn : connections) {
+        if (conn.state != connIdle) {
+            continue;
+        }
+
+        WiFiClient client = listener.accept();
+
+        if (!client) {
+            return;
+        }
+
+        conn.reset();
+        conn.client = client;
+        conn.state = connHead;
+        conn.lastActivity = millis();
+    }
+}
+
+/**
+ * SprinklerWebServer::receive()
+ *
+ * Reads whatever has arrived on the connection (up to WEB_IO_CHUNK bytes)
+ * and parses as much of the request as it completes.  A connection that
+ * has gone away, or has sent nothing for WEB_IDLE_TIMEOUT ms, is closed.
+ */
+void SprinklerWebServer::receive(Connection& conn) {
+    int available = conn.client.available();
+
+    if (available <= 0) {
+        if (!conn.client.connected() || millis() - conn.lastActivity > WEB_IDLE_TIMEOUT) {
+            conn.client.stop();
+            release(conn);
+        }
+        return;
+    }
+
+    char buff[WEB_IO_CHUNK];
+    int n = conn.client.read((uint8_t*)buff, std::min((size_t)available, sizeof(buff)));
+
+    if (n <= 0) {
+        return;
+    }
+
+    conn.lastActivity = millis();
+
+    if (conn.state == connHead) {
+        // the blank line may have started in the previous read
+        unsigned int from = (conn.in.length() > 3) ? conn.in.length() - 3 : 0;
+        int headEnd;
+
+        conn.in.concat(buff, n);
+        headEnd = conn.in.indexOf("\r\n\r\n", from);
+
+        if (headEnd < 0) {
+            if (conn.in.length() > WEB_MAX_HEAD) {
+                reject(conn, 400);
+            }
+            return;
+        }
+
+        if (!parseHead(conn, headEnd)) {
+            return;
+        }
+    } else {
+        conn.in.concat(buff, n);
+        conn.bodyReceived += n;
+    }
+
+    receiveBody(conn);
+}
+
+/**
+ * SprinklerWebServer::parseHead()
+ *
+ * Parses the request line and headers (the first headEnd bytes of what has
+ * been received) and finds the handler for the request.  What follows the
+ * headers is the beginning of the body.  Returns false, having rejected
+ * the request, if it can't be served.
+ */
+bool SprinklerWebServer::parseHead(Connection& conn, int headEnd) {
+    String head = conn.in.substring(0, headEnd + 2);
+    int lineEnd = head.indexOf("\r\n");
+    int sp1 = head.indexOf(' ');
+    int sp2 = head.indexOf(' ', sp1 + 1);
+
+    if (sp1 < 0 || sp2 < 0 || sp2 > lineEnd) {
+        reject(conn, 400);
+        return false;
+    }
+
+    String methodName = head.substring(0, sp1);
+    String target = head.substring(sp1 + 1, sp2);
+    int q = target.indexOf('?');
+
+    for (uint8_t i = 1; i < sizeof(methodNames) / sizeof(methodNames[0]); i++) {
+        if (methodName == methodNames[i]) {
+            conn.method = (HTTPMethod)i;
+        }
+    }
+
+    if (q >= 0) {
+        conn.uri = target.substring(0, q);
+        parseArgs(conn, target.substring(q + 1));
+    } else {
+        conn.uri = target;
+    }
+
+    for (int pos = lineEnd + 2; pos < (int)head.length(); ) {
+        int end = head.indexOf("\r\n", pos);
+        int colon = head.indexOf(':', pos);
+
+        if (colon > 0 && colon < end) {
+            String name = head.substring(pos, colon);
+            String value = head.substring(colon + 1, end);
+
+            value.trim();
+
+            for (const String& key : headerKeys) {
+                if (name.equalsIgnoreCase(key)) {
+                    conn.headers.push_back({key, value});
+                }
+            }
+
+            if (name.equalsIgnoreCase("Content-Length")) {
+                conn.bodyLength = (size_t)value.toInt();
+            } else if (name.equalsIgnoreCase("Content-Type")) {
+                conn.contentType = value;
+            }
+        }
+
+        pos = end + 2;
+    }
+
+    conn.route = matchRoute(conn, 0, 0);
+
+    int b = conn.contentType.indexOf("boundary=");
+    bool multipart = conn.contentType.startsWith("multipart/form-data") && b >= 0;
+
+    if (!multipart && conn.bodyLength > WEB_MAX_BODY) {
+        reject(conn, 413);
+        return false;
+    }
+
+    conn.in.remove(0, headEnd + 4);
+    conn.bodyReceived = conn.in.length();
+    conn.state = connBody;
+
+    if (multipart) {
+        // every boundary is preceded by a line break, so one is supplied
+        // for the first boundary as well
+        conn.delimiter = "\r\n--" + conn.contentType.substring(b + 9);
+        conn.in = "\r\n" + conn.in;
+    }
+
+    return true;
+}
+
+/**
+ * SprinklerWebServer::receiveBody()
+ *
+ * Takes the body in as it arrives.  Once all of it is in, the request is
+ * ready to be dispatched.
+ */
+void SprinklerWebServer::receiveBody(Connection& conn) {
+    if (conn.delimiter.length() > 0) {
+        receiveParts(conn);
+    }
+
+    if (conn.state != connBody || conn.bodyReceived < conn.bodyLength) {
+        return;
+    }
+
+    if (conn.delimiter.length() > 0) {
+        if (conn.partState == partData) {
+            callUpload(conn, UPLOAD_FILE_ABORTED);
+        }
+    } else {
+        conn.in.remove(conn.bodyLength);
+
+        if (conn.contentType.startsWith("application/x-www-form-urlencoded")) {
+            parseArgs(conn, conn.in);
+        } else if (conn.in.length() > 0) {
+            conn.args.push_back({String("plain"), conn.in});
+        }
+    }
+
+    conn.in = String();
+    conn.state = connReady;
+}
+
+/**
+ * SprinklerWebServer::receiveParts()
+ *
+ * Walks as much of a multipart/form-data body as has arrived, handing the
+ * data of each file part to the upload handler as it goes.  Only the few
+ * bytes that could be the start of a boundary are held back.
+ */
+void SprinklerWebServer::receiveParts(Connection& conn) {
+    while (conn.state == connBody && conn.partState != partDone) {
+        if (conn.partState == partHead) {
+            // what follows a boundary is "--" after the last one, or else
+            // the line break that ends it and the part's headers
+            if (conn.in.length() < 2) {
+                return;
+            }
+
+            if (conn.in.startsWith("--")) {
+                conn.partState = partDone;
+                break;
+            }
+
+            int headEnd = conn.in.indexOf("\r\n\r\n");
+
+            if (headEnd < 0) {
+                if (conn.in.length() > WEB_MAX_HEAD) {
+                    reject(conn, 400);
+                }
+                return;
+            }
+
+            String partHead = conn.in.substring(0, headEnd);
+            int fn = partHead.indexOf("filename=\"");
+
+            conn.in.remove(0, headEnd + 4);
+            conn.partState = partSkip;
+
+            if (fn >= 0 && conn.route != noRoute && routes[conn.route].upload) {
+                int nm = partHead.indexOf("name=\"");
+                int ct = partHead.indexOf("Content-Type:");
+
+                if (!conn.upload) {
+                    conn.upload.reset(new HTTPUpload());
+                }
+
+                conn.upload->filename = partHead.substring(fn + 10, partHead.indexOf('"', fn + 10));
+                conn.upload->name = (nm >= 0) ?
+                    partHead.substring(nm + 6, partHead.indexOf('"', nm + 6)) : String();
+                conn.upload->type = (ct >= 0) ?
+                    partHead.substring(ct + 13, partHead.indexOf("\r\n", ct)) : String();
+                conn.upload->type.trim();
+                conn.upload->totalSize = 0;
+                callUpload(conn, UPLOAD_FILE_START);
+                conn.partState = partData;
+            }
+            continue;
+        }
+
+        // the preamble, or the data of a part, runs up to the next boundary
+        int next = conn.in.indexOf(conn.delimiter);
+        size_t dataLen = (next >= 0) ? (size_t)next :
+            (conn.in.length() >= conn.delimiter.length()) ?
+                conn.in.length() - conn.delimiter.length() + 1 : 0;
+
+        if (conn.partState == partData) {
+            for (size_t i = 0; i < dataLen; i += HTTP_UPLOAD_BUFLEN) {
+                callUpload(
+                    conn,
+                    UPLOAD_FILE_WRITE,
+                    conn.in.c_str() + i,
+                    std::min((size_t)HTTP_UPLOAD_BUFLEN, dataLen - i)
+                );
+            }
+        }
+
+        if (next < 0) {
+            conn.in.remove(0, dataLen);
+            return;
+        }
+
+        if (conn.partState == partData) {
+            callUpload(conn, UPLOAD_FILE_END);
+        }
+
+        conn.in.remove(0, next + conn.delimiter.length());
+        conn.partState = partHead;
+    }
+
+    // nothing after the last boundary matters
+    conn.in = String();
+}
+
+void SprinklerWebServer::callUpload(Connection& conn, HTTPUploadStatus status, const char* data, size_t len) {
+    Connection* previous = current;
+
+    conn.upload->status = status;
+    conn.upload->currentSize = len;
+
+    if (len > 0) {
+        memcpy(conn.upload->buf, data, len);
+        conn.upload->totalSize += len;
+    }
+
+    current = &conn;
+    invokeRoute(routeContext, routeTable, conn.route, true);
+    current = previous;
+}
+
+/**
+ * SprinklerWebServer::dispatch()
+ *
+ * Runs the handler of a request that has been read.  The connection is
+ * let go of afterwards, unless a file is still being sent on it.  Handlers
+ * that write straight to client() (like /sse) never call send(), so no
+ * response is not an error; and letting go of the connection only closes
+ * it if no handler kept its own copy of the client.
+ */
+void SprinklerWebServer::dispatch(Connection& conn) {
+    current = &conn;
+
+    if (conn.route != noRoute) {
+        invokeRoute(routeContext, routeTable, conn.route, false);
+    } else if (corsEnabled && conn.method == HTTP_OPTIONS) {
+        sendHeader(String(F("Access-Control-Allow-Headers")), String("*"));
+        send(200);
+    } else if (notFoundHandler) {
+        notFoundHandler();
+    } else {
+        send(404, "text/plain", String("Not found: ") + conn.uri);
+    }
+
+    // a chunked response that the handler didn't terminate is terminated
+    if (conn.chunked) {
+        sendContent("", 0);
+    }
+
+    current = &noRequest;
+
+    if (conn.parking) {
+        conn.parking = false;
+        conn.state = connParked;
+    } else if (conn.file || conn.progmemLeft > 0) {
+        conn.state = connStreaming;
+        conn.lastActivity = millis();
+    } else {
+        release(conn);
+    }
+}
+
+// sends as much more of the file as the connection takes without blocking
+void SprinklerWebServer::streamMore(Connection& conn) {
+    if (!conn.client.connected() || millis() - conn.lastActivity > WEB_IDLE_TIMEOUT) {
+        conn.client.stop();
+        release(conn);
+        return;
+    }
+
+    int room = conn.client.availableForWrite();
+
+    if (room <= 0) {
+        return;
+    }
+
+    uint8_t buff[WEB_IO_CHUNK];
+    size_t n = std::min((size_t)room, sizeof(buff));
+
+    if (conn.progmem) {
+        n = std::min(n, conn.progmemLeft);
+        memcpy_P(buff, conn.progmem, n);
+        conn.progmem += n;
+        conn.progmemLeft -= n;
+    } else {
+        n = conn.file.read(buff, n);
+    }
+
+    if (n > 0) {
+        conn.client.write(buff, n);
+        conn.lastActivity = millis();
+    }
+
+    if (n == 0 || ((conn.progmem) ? conn.progmemLeft == 0 : !conn.file.available())) {
+        release(conn);
+    }
+}
+
+/**
+ * SprinklerWebServer::park()
+ * 
+ * Called by a handler instead of answering its request:  the connection is
+ * kept open, without a response, and the request is dispatched to the
+ * handler again (with the same args) when wakeParked() is called, or once
+ * timeout ms have passed since it was first parked, when parkExpired() is
+ * true.  The handler decides each time whether to answer or to park it
+ * again, which doesn't extend the timeout.
+ * 
+ * At most WEB_MAX_PARKED connections are parked at once, so that there are
+ * always connections left for other requests.  Returns false, and the
+ * handler has to answer, if it can't be parked:  there is no room, it has
+ * expired, or a response has been started.
+ */
+bool SprinklerWebServer::park(unsigned long timeout) {
+    Connection& conn = *current;
+
+    if (&conn == &noRequest || conn.parkExpired || conn.responseStarted) {
+        return false;
+    }
+
+    if (conn.parkTimeout == 0) {
+        uint8_t parked = 0;
+
+        for (const Connection& c : connections) {
+            if (c.state == connParked) {
+                parked++;
+            }
+        }
+
+        if (parked >= WEB_MAX_PARKED) {
+            return false;
+        }
+
+        conn.parkedAt = millis();
+        conn.parkTimeout = std::max(timeout, 1UL);
+    }
+
+    conn.parking = true;
+    return true;
+}
+
+// dispatches the parked requests again
+void SprinklerWebServer::wakeParked() {
+    for (Connection& conn : connections) {
+        if (conn.state == connParked) {
+            conn.state = connReady;
+        }
+    }
+}
+
+// closes a parked connection that has gone away, and dispatches one whose
+// time is up again
+void SprinklerWebServer::checkParked(Connection& conn) {
+    if (!conn.client.connected()) {
+        conn.client.stop();
+        release(conn);
+    } else if (millis() - conn.parkedAt >= conn.parkTimeout) {
+        conn.parkExpired = true;
+        conn.state = connReady;
+    }
+}
+
+// answers a request that can't be served and closes its connection
+void SprinklerWebServer::reject(Connection& conn, int code) {
+    current = &conn;
+    send(code, "text/plain", String(code) + ": " + statusText(code));
+    current = &noRequest;
+
+    conn.client.stop();
+    release(conn);
+}
+
+void SprinklerWebServer::release(Connection& conn) {
+    if (conn.file) {
+        conn.file.close();
+    }
+    conn.reset();
+}
+
+void SprinklerWebServer::parseArgs(Connection& conn, const String& query) {
+    int pos = 0;
+
+    while (pos < (int)query.length()) {
+        int amp = query.indexOf('&', pos);
+
+        if (amp < 0) amp = query.length();
+
+        String pair = query.substring(pos, amp);
+        int eq = pair.indexOf('=');
+
+        if (eq >= 0) {
+            conn.args.push_back({
+                urlDecode(pair.substring(0, eq)),
+                urlDecode(pair.substring(eq + 1))
+            });
+        } else if (pair.length() > 0) {
+            conn.args.push_back({urlDecode(pair), String()});
+        }
+
+        pos = amp + 1;
+    }
+}
+
+/**
+ * SprinklerWebServer::sendFile()
+ *
+ * Sends the file (with the content type of its extension) as the response,
+ * or a 404 if there is no such file, in which case it returns false.
+ *
+ * If there is a gzipped copy of the file (path + ".gz") it is sent instead
+ * when the client takes gzip (or when there is only the gzipped copy).  The
+ * response has a strong ETag, and a request whose If-None-Match has it is
+ * answered with a 304 and no file.  The Accept-Encoding and If-None-Match
+ * headers have to be collected for this (see collectHeaders()).
+ *
+ * If the URL named a version of the file (see notModified()) it is given as
+ * version.
+ */
+bool SprinklerWebServer::sendFile(
+    fs::FS& fs,
+    const String& path,
+    const char* cacheHeader,
+    const char* version
+) {
+    String gzPath = path + ".gz";
+    bool gzip = (header(String("Accept-Encoding")).indexOf("gzip") >= 0 || !fs.exists(path)) &&
+        fs.exists(gzPath);
+    fs::File f = fs.open((gzip) ? gzPath : path, "r");
+
+    if (!f) {
+        send(404, "text/plain", String("Not found: ") + current->uri);
+        return false;
+    }
+
+    char etag[12];
+
+    snprintf(etag, sizeof(etag), "\"%08lx\"", (unsigned long)fileTag(f, (gzip) ? gzPath : path));
+    sendHeader(String("Vary"), String("Accept-Encoding"));
+
+    if (notModified(etag, cacheHeader, version)) {
+        f.close();
+        return true;
+    }
+
+    streamFile(f, String(contentTypeFor(path)));
+    return true;
+}
+
+/**
+ * SprinklerWebServer::sendProgmem()
+ *
+ * Sends gzipped data that is in PROGMEM (it has to stay there) as a file,
+ * just as sendFile() would, with the ETag that is given.
+ */
+void SprinklerWebServer::sendProgmem(
+    const uint8_t* data,
+    size_t length,
+    const char* contentType,
+    const char* etag,
+    const char* cacheHeader,
+    const char* version
+) {
+    if (current == &noRequest) {
+        return;
+    }
+
+    sendHeader(String("Vary"), String("Accept-Encoding"));
+
+    if (notModified(etag, cacheHeader, version)) {
+        return;
+    }
+
+    sendHeader(String("Content-Encoding"), String("gzip"));
+    current->contentLength = CONTENT_LENGTH_NOT_SET;
+    sendResponseHeaders(200, contentType, length);
+    current->progmem = data;
+    current->progmemLeft = length;
+}
+
+/**
+ * SprinklerWebServer::notModified()
+ *
+ * Adds the ETag (and Cache-Control) header to the response, and answers
+ * with a 304 if the client already has what it is for (its If-None-Match
+ * has the ETag), in which case it returns true and the handler has nothing
+ * more to send.  If-None-Match has to be collected for this (see
+ * collectHeaders()).
+ *
+ * version is the version the URL named (/sprinklers.js?v=<version>), if it
+ * did.  Only when it is the ETag (without the quotes) can what is sent be
+ * cached for good; otherwise cacheHeader is sent as usual, so that a stale
+ * copy sent under a new URL doesn't stick.
+ */
+bool SprinklerWebServer::notModified(
+    const char* etag,
+    const char* cacheHeader,
+    const char* version
+) {
+    size_t versionLen = (version) ? strlen(version) : 0;
+
+    if (
+        version &&
+        strlen(etag) == versionLen + 2 &&
+        strncmp(etag + 1, version, versionLen) == 0
+    ) {
+        cacheHeader = "public, max-age=31536000, immutable";
+    }
+
+    sendHeader(String("ETag"), String(etag));
+
+    if (cacheHeader) {
+        sendHeader(String("Cache-Control"), String(cacheHeader));
+    }
+
+    if (header(String("If-None-Match")).indexOf(etag) >= 0) {
+        send(304);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * SprinklerWebServer::fileTag()
+ *
+ * Returns the ETag of the file, a hash (FNV-1a) of its contents.  The last
+ * WEB_FILE_TAGS of them are remembered (as long as the size of the file
+ * doesn't change) so that the file is only read twice when it is sent the
+ * first time, and not at all when a client already has it.
+ */
+uint32_t SprinklerWebServer::fileTag(fs::File& file, const String& path) {
+    for (const FileTag& t : fileTags) {
+        if (t.path == path && t.size == file.size()) {
+            return t.tag;
+        }
+    }
+
+    uint8_t buff[WEB_IO_CHUNK];
+    uint32_t hash = 2166136261UL;
+    size_t n;
+
+    while ((n = file.read(buff, sizeof(buff))) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            hash = (hash ^ buff[i]) * 16777619UL;
+        }
+    }
+
+    file.seek(0);
+
+    fileTags[nextFileTag] = {path, file.size(), hash};
+    nextFileTag = (nextFileTag + 1) % WEB_FILE_TAGS;
+
+    return hash;
+}
+
+void SprinklerWebServer::forgetFileTags() {
+    for (FileTag& t : fileTags) {
+        t = FileTag();
+    }
+}
+
+/**
+ * SprinklerWebServer::collectHeaders()
+ *
+ * As in the ESP8266 core, only the request headers named here are kept for
+ * header() and hasHeader() (names are matched without regard to case).
+ */
+void SprinklerWebServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    this->headerKeys.clear();
+
+    for (size_t i = 0; i < headerKeysCount; i++) {
+        this->headerKeys.push_back(String(headerKeys[i]));
+    }
+}
+
+const String& SprinklerWebServer::header(const String& name) const {
+    static const String empty;
+
+    for (const Arg& h : current->headers) {
+        if (h.key.equalsIgnoreCase(name)) return h.value;
+    }
+    return empty;
+}
+
+bool SprinklerWebServer::hasHeader(const String& name) const {
+    for (const Arg& h : current->headers) {
+        if (h.key.equalsIgnoreCase(name)) return true;
+    }
+    return false;
+}
+
+const String& SprinklerWebServer::pathArg(unsigned int i) const {
+    static const String empty;
+    return (i < current->pathArgs.size()) ? current->pathArgs[i] : empty;
+}
+
+const String& SprinklerWebServer::arg(const String& name) const {
+    static const String empty;
+
+    for (const Arg& a : current->args) {
+        if (a.key == name) return a.value;
+    }
+    return empty;
+}
+
+bool SprinklerWebServer::hasArg(const String& name) const {
+    for (const Arg& a : current->args) {
+        if (a.key == name) return true;
+    }
+    return false;
+}
+
+void SprinklerWebServer::sendHeader(const String& name, const String& value, bool first) {
+    if (current == &noRequest) {
+        return;
+    }
+
+    String header = name + ": " + value + "\r\n";
+
+    current->responseHeaders = (first) ?
+        header + current->responseHeaders : current->responseHeaders + header;
+}
+
+void SprinklerWebServer::sendResponseHeaders(int code, const char* contentType, size_t length) {
+    String head((char *)0);
+
+    head.reserve(256);
+    head += "HTTP/1.1 ";
+    head += code;
+    head += ' ';
+    head += statusText(code);
+    head += "\r\n";
+
+    if (contentType && *contentType) {
+        head += "Content-Type: ";
+        head += contentType;
+        head += "\r\n";
+    }
+
+    if (length == CONTENT_LENGTH_UNKNOWN) {
+        current->chunked = true;
+        head += "Transfer-Encoding: chunked\r\n";
+    } else {
+        head += "Content-Length: ";
+        head += (unsigned long)length;
+        head += "\r\n";
+    }
+
+    if (corsEnabled) {
+        head += "Access-Control-Allow-Origin: *\r\n";
+    }
+
+    head += current->responseHeaders;
+    head += "Connection: close\r\n\r\n";
+
+    current->client.write((const uint8_t*)head.c_str(), head.length());
+    current->responseHeaders = String();
+    current->responseStarted = true;
+}
+
+/**
+ * SprinklerWebServer::send()
+ *
+ * Sends a complete response.  Only the first response of a request is
+ * written, which guards against handlers (like /upload's) that answer
+ * twice.  Outside of a request (e.g. from an event) nothing is sent.
+ */
+void SprinklerWebServer::send(int code, const char* contentType, const String& content) {
+    if (current->responseStarted || current == &noRequest) {
+        return;
+    }
+
+    size_t length = (current->contentLength == CONTENT_LENGTH_NOT_SET) ?
+        content.length() : current->contentLength;
+
+    sendResponseHeaders(code, contentType, length);
+
+    if (content.length() > 0) {
+        sendContent(content);
+    }
+}
+
+void SprinklerWebServer::sendContent(const String& content) {
+    sendContent(content.c_str(), content.length());
+}
+
+void SprinklerWebServer::sendContent(const char* content, size_t size) {
+    WiFiClient& client = current->client;
+
+    if (current == &noRequest) {
+        return;
+    }
+
+    if (current->chunked) {
+        char sizeLine[12];
+
+        // a zero length chunk terminates the response
+        snprintf(sizeLine, sizeof(sizeLine), "%x\r\n", (unsigned)size);
+        client.write((const uint8_t*)sizeLine, strlen(sizeLine));
+        client.write((const uint8_t*)content, size);
+        client.write((const uint8_t*)"\r\n", 2);
+
+        if (size == 0) {
+            current->chunked = false;
+        }
+    } else {
+        client.write((const uint8_t*)content, size);
+    }
+}
+
+/**
+ * SprinklerWebServer::streamFile()
+ *
+ * Sends the headers of the file's response.  The file itself is sent from
+ * handleClient() after the handler returns, as the connection takes it, and
+ * is closed when it has been sent, so the handler must leave it open.
+ */
+size_t SprinklerWebServer::streamFile(fs::File& file, const String& contentType) {
+    if (String(file.name()).endsWith(".gz")) {
+        sendHeader(String("Content-Encoding"), String("gzip"));
+    }
+
+    if (current == &noRequest) {
+        return 0;
+    }
+
+    current->contentLength = CONTENT_LENGTH_NOT_SET;
+    sendResponseHeaders(200, contentType.c_str(), file.size());
+    current->file = file;
+
+    return file.size();
+}
+
+String SprinklerWebServer::urlDecode(const String& text) {
+    String decoded;
+    unsigned int len = text.length();
+
+    decoded.reserve(len);
+
+    for (unsigned int i = 0; i < len; i++) {
+        char c = text[i];
+
+        if (c == '+') {
+            decoded += ' ';
+        } else if (c == '%' && i + 2 < len) {
+            char hex[3] = {text[i + 1], text[i + 2], '\0'};
+            decoded += (char)strtol(hex, nullptr, 16);
+            i += 2;
+        } else {
+            decoded += c;
+        }
+    }
+
+    return decoded;
+}
+
+const char* SprinklerWebServer::statusText(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 303: return "See Other";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "";
+    }
+}
+
+const char* SprinklerWebServer::contentTypeFor(const String& path) {
+    if (path.endsWith(".html") || path.endsWith(".htm")) return "text/html";
+    if (path.endsWith(".js")) return "application/javascript";
+    if (path.endsWith(".css")) return "text/css";
+    if (path.endsWith(".json")) return "application/json";
+    if (path.endsWith(".ico")) return "image/x-icon";
+    return "text/plain";
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+// HTTPMethod and HTTPUpload come from the core's web server library
+#include <ESP8266WebServer.h>
+#include <FS.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * SprinklerWebServer
+ *
+ * The HTTP server that SprinklerAPI's routes are served by.  It has the
+ * same interface as the core's ESP8266WebServer for handlers (arg(), send(),
+ * ...) so the route handlers are written just as they were, but instead of
+ * taking one connection at a time and waiting on it until its request has
+ * been read and answered, it is event driven:
+ *
+ *  - up to WEB_MAX_CONNECTIONS connections are open at once, and each
+ *    handleClient() reads whatever has arrived on each of them without
+ *    waiting for the rest
+ *  - a request is dispatched to its handler only once all of it is in, and
+ *    at most one request is dispatched per handleClient()
+ *  - files (sendFile(), streamFile(), sendProgmem()) are sent a piece at a
+ *    time, as much as each connection takes without blocking
+ *  - a connection that doesn't make progress for WEB_IDLE_TIMEOUT ms is
+ *    closed
+ *
+ * So a slow or stalled client only holds up itself, and since handlers are
+ * only ever run from handleClient() (i.e. from SprinklerAPI::loop(),
+ * between runs of schedulerLoop()), a handler is free to change the
+ * scheduler's state.  Work that takes long is still pushed onto the events
+ * queue by the handler, as before.
+ *
+ * Uploads (multipart/form-data) are handed to the upload handler in
+ * HTTP_UPLOAD_BUFLEN pieces as they arrive, with the same START, WRITE, END
+ * sequence that the core produces.  Any other body is limited to
+ * WEB_MAX_BODY bytes and is available as the "plain" arg (or as args, if it
+ * is form-encoded).  Connections aren't kept alive.
+ *
+ * A handler can also park its request instead of answering it (see park()),
+ * for long polling:  the connection is kept open without a response until
+ * the handler is run again for it.
+ *
+ * The routes are a constant table of WebRoute (see setRoutes()) instead of
+ * handlers registered one at a time with on(); the server only keeps an
+ * index of their patterns, in fixed arrays, so that a request is matched in
+ * the same time however many routes there are.
+ */
+
+#ifndef WEB_MAX_CONNECTIONS
+#define WEB_MAX_CONNECTIONS 4
+#endif
+
+#ifndef WEB_IDLE_TIMEOUT
+#define WEB_IDLE_TIMEOUT 5000
+#endif
+
+#ifndef WEB_MAX_HEAD
+#define WEB_MAX_HEAD 2048
+#endif
+
+#ifndef WEB_MAX_BODY
+#define WEB_MAX_BODY 4096
+#endif
+
+// how much is read from (or written to) a connection at a time
+#define WEB_IO_CHUNK 512
+
+#ifndef WEB_MAX_ROUTES
+#define WEB_MAX_ROUTES 64
+#endif
+
+// the nodes of the index of the route patterns (about 2 per route)
+#ifndef WEB_MAX_ROUTE_NODES
+#define WEB_MAX_ROUTE_NODES 112
+#endif
+
+// the connections that can be parked at once (see park())
+#ifndef WEB_MAX_PARKED
+#define WEB_MAX_PARKED 2
+#endif
+
+// the files whose ETag (see sendFile()) is remembered
+#ifndef WEB_FILE_TAGS
+#define WEB_FILE_TAGS 4
+#endif
+
+static_assert(WEB_MAX_ROUTES < 255 && WEB_MAX_ROUTE_NODES < 255, "routes are indexed by uint8_t");
+
+/**
+ * WebRoute
+ *
+ * One entry of a route table: the method and URI pattern of the requests
+ * that the member handler of T answers.  A "{}" in the pattern matches a
+ * path argument, as with the core's UriBraces:  the last one runs to the
+ * end of the URI (and can't contain a '/'), any other one runs up to the
+ * first occurrence of the character that follows it in the pattern.  A
+ * route that takes uploads also names the member that the pieces of an
+ * upload are handed to.
+ */
+template<typename T>
+struct WebRoute {
+    HTTPMethod method;
+    const char* pattern;
+    void (T::*handler)();
+    void (T::*upload)() = nullptr;
+};
+
+class SprinklerWebServer {
+    public:
+        typedef std::function<void(void)> THandlerFunction;
+
+        SprinklerWebServer(int port = 80) : listener(port) {}
+
+        void begin();
+        void close();
+        void handleClient();
+
+        /**
+         * SprinklerWebServer::setRoutes()
+         *
+         * Serves the routes of the table with the members of context.  The
+         * table (and its patterns) must outlive the server, which is why
+         * it is meant to be a static constexpr array.  The patterns are
+         * indexed once, here, in a trie whose nodes point into them, so
+         * that nothing is allocated for them.  When two routes match a
+         * request, the one whose pattern has the literal text where the
+         * other has a "{}" is chosen (and then the one that is first in
+         * the table).
+         */
+        template<typename T, size_t N>
+        void setRoutes(T& context, const WebRoute<T> (&table)[N]) {
+            static_assert(N <= WEB_MAX_ROUTES, "too many routes (see WEB_MAX_ROUTES)");
+
+            routeContext = &context;
+            routeTable = table;
+            invokeRoute = [](void* context, const void* table, uint8_t i, bool upload) {
+                const WebRoute<T>& route = ((const WebRoute<T>*)table)[i];
+
+                (((T*)context)->*((upload) ? route.upload : route.handler))();
+            };
+
+            clearRoutes();
+
+            for (size_t i = 0; i < N; i++) {
+                addRoute(i, table[i].method, table[i].pattern, table[i].upload != nullptr);
+            }
+        }
+        void onNotFound(THandlerFunction fn) { notFoundHandler = fn; }
+        void enableCORS(bool enable) { corsEnabled = enable; }
+
+        // the request being handled
+        const String& uri() const { return current->uri; }
+        HTTPMethod method() const { return current->method; }
+        WiFiClient& client() { return current->client; }
+        HTTPUpload& upload() { return *current->upload; }
+
+        void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+        const String& header(const String& name) const;
+        bool hasHeader(const String& name) const;
+
+        const String& pathArg(unsigned int i) const;
+        const String& arg(const String& name) const;
+        bool hasArg(const String& name) const;
+        int args() const { return (int)current->args.size(); }
+
+        void sendHeader(const String& name, const String& value, bool first = false);
+        void setContentLength(size_t contentLength) { current->contentLength = contentLength; }
+        void send(int code, const char* contentType = nullptr, const String& content = String(""));
+        void send(int code, const String& contentType, const String& content) {
+            send(code, contentType.c_str(), content);
+        }
+        void sendContent(const String& content);
+        void sendContent(const char* content, size_t size);
+        size_t streamFile(fs::File& file, const String& contentType);
+        bool sendFile(
+            fs::FS& fs,
+            const String& path,
+            const char* cacheHeader = nullptr,
+            const char* version = nullptr
+        );
+        void sendProgmem(
+            const uint8_t* data,
+            size_t length,
+            const char* contentType,
+            const char* etag,
+            const char* cacheHeader = nullptr,
+            const char* version = nullptr
+        );
+        // for when files that were sent may have changed
+        void forgetFileTags();
+        bool notModified(
+            const char* etag,
+            const char* cacheHeader = nullptr,
+            const char* version = nullptr
+        );
+
+        // long polling (see park())
+        bool park(unsigned long timeout);
+        bool parkExpired() const { return current->parkExpired; }
+        void wakeParked();
+
+        // the connections that are open
+        uint8_t connectionCount() const;
+
+        static String urlDecode(const String& text);
+
+    private:
+        static const uint8_t noRoute = 0xff;
+        static const uint8_t noNode = 0xff;
+
+        // a node of the trie of route patterns:  it matches a piece of
+        // literal text of the patterns, or a "{}" if length is 0
+        struct RouteNode {
+            const char* label;
+            uint8_t length;
+            uint8_t child;      // the first, or noNode
+            uint8_t sibling;    // the next child of the parent, or noNode
+            uint8_t route;      // the first route whose pattern ends here
+        };
+
+        struct RouteInfo {
+            uint8_t method;     // HTTPMethod
+            uint8_t next;       // the next route with the same pattern
+            bool upload;
+        };
+
+        struct FileTag {
+            String path;
+            size_t size = 0;
+            uint32_t tag = 0;
+        };
+
+        struct Arg {
+            String key;
+            String value;
+        };
+
+        typedef enum ConnectionState : uint8_t {
+            connIdle,           // not in use
+            connHead,           // reading the request line and headers
+            connBody,           // reading the body
+            connReady,          // waiting to be dispatched
+            connParked,         // waiting to be dispatched again (see park())
+            connStreaming       // sending a file
+        } ConnectionState_t;
+
+        // where a multipart/form-data body is
+        typedef enum PartState : uint8_t {
+            partPreamble,       // ahead of the first boundary
+            partHead,           // the headers of a part
+            partData,           // the data of a file part
+            partSkip,           // the data of any other part
+            partDone            // after the last boundary
+        } PartState_t;
+
+        struct Connection {
+            WiFiClient client;
+            ConnectionState_t state = connIdle;
+            unsigned long lastActivity = 0;
+            String in;                  // received but not yet parsed
+
+            HTTPMethod method = HTTP_ANY;
+            String uri;
+            std::vector<Arg> args;
+            std::vector<Arg> headers;
+            std::vector<String> pathArgs;
+            String contentType;
+            size_t bodyLength = 0;      // Content-Length
+            size_t bodyReceived = 0;
+            uint8_t route = noRoute;
+
+            String delimiter;           // "\r\n--" + the multipart boundary
+            PartState_t partState = partPreamble;
+            std::unique_ptr<HTTPUpload> upload;
+
+            String responseHeaders;
+            size_t contentLength = CONTENT_LENGTH_NOT_SET;
+            bool chunked = false;
+            bool responseStarted = false;
+            fs::File file;
+            const uint8_t* progmem = nullptr;   // or the file is in PROGMEM
+            size_t progmemLeft = 0;
+
+            unsigned long parkedAt = 0;
+            unsigned long parkTimeout = 0;      // 0 if it was never parked
+            bool parking = false;               // park() by this dispatch
+            bool parkExpired = false;
+
+            void reset();
+        };
+
+        WiFiServer listener;
+        bool corsEnabled = false;
+        void* routeContext = nullptr;
+        const void* routeTable = nullptr;
+        void (*invokeRoute)(void* context, const void* table, uint8_t i, bool upload) = nullptr;
+        RouteInfo routes[WEB_MAX_ROUTES];
+        RouteNode routeNodes[WEB_MAX_ROUTE_NODES];
+        uint8_t routeNodeCount = 0;
+        std::vector<String> headerKeys;
+        THandlerFunction notFoundHandler;
+
+        FileTag fileTags[WEB_FILE_TAGS];
+        uint8_t nextFileTag = 0;
+
+        Connection connections[WEB_MAX_CONNECTIONS];
+        uint8_t nextDispatch = 0;
+        // the connection whose request is being handled (noRequest outside
+        // of a handler)
+        Connection noRequest;
+        Connection* current = &noRequest;
+
+        void clearRoutes();
+        bool addRoute(uint8_t i, HTTPMethod method, const char* pattern, bool upload);
+        uint8_t newRouteNode(const char* label, uint8_t length);
+        uint8_t matchRoute(Connection& conn, uint8_t node, unsigned int pos);
+        uint8_t routeFor(uint8_t node, HTTPMethod method) const;
+        void accept();
+        void receive(Connection& conn);
+        bool parseHead(Connection& conn, int headEnd);
+        void receiveBody(Connection& conn);
+        void receiveParts(Connection& conn);
+        void callUpload(Connection& conn, HTTPUploadStatus status, const char* data = nullptr, size_t len = 0);
+        void dispatch(Connection& conn);
+        void streamMore(Connection& conn);
+        void checkParked(Connection& conn);
+        void reject(Connection& conn, int code);
+        void release(Connection& conn);
+        void parseArgs(Connection& conn, const String& query);
+        uint32_t fileTag(fs::File& file, const String& path);
+        void sendResponseHeaders(int code, const char* contentType, size_t length);
+        static const char* statusText(int code);
+        static const char* contentTypeFor(const String& path);
+};
@@ -15,7 +15,7 @@
  */
 
 #include <Arduino.h>
-#include <ESP8266WebServer.h>
+#include <SprinklerWebServer.hpp>
 #include <WiFiUdp.h>
 #include <ShiftRegister74HC595.h>
 #include <LittleFS.h>
@@ -32,15 +32,28 @@
 // ssid_name, ssid_password come from secrets.h
 SimpleWiFi wifi(ssid_name, ssid_password);
 OTA ota(DEVICE_NAME);
-ESP8266WebServer server(80);
+SprinklerWebServer server(80);
 WiFiUDP ntpUDP;
 NTPClient timeClient(ntpUDP, MTN_DAYLIGHT_OFFSET_SECONDS);
-ShiftRegister74HC595<1> shiftRegister(
+// SHIFT_REGISTER_COUNT chained registers (see SprinklerAPI.hpp).  The SPI
+// transport can't use the bit-banged wiring:  HSPI fixes SER on MOSI (D7)
+// and SRCLK on SCLK (D5), so a board built with -D SHIFT_REGISTER_SPI has
+// to be rewired with data on D7, clock on D5 and the latch moved to D8
+// (free once the clock is on D5, and its boot pull-down keeps RCLK low)
+#ifdef SHIFT_REGISTER_SPI
+ZoneShiftRegister_t shiftRegister(
+    /* serialDataPin */ D7, 
+    /* clockPin      */ D5, 
+    /* latchPin      */ D8
+);
+#else
+ZoneShiftRegister_t shiftRegister(
     /* serialDataPin */ D5, 
     /* clockPin      */ D8, 
     /* latchPin      */ D7
 );
-SprinklerAPI api(server, shiftRegister, timeClient, 7, D0);
+#endif
+SprinklerAPI api(server, shiftRegister, timeClient, NUMBER_OF_ZONES, D0);
 unsigned long now = millis();
 unsigned long newMillis = 0L;
 Ticker heartbeat[2];
@@ -51,10 +64,8 @@ void setup() {
 
 // do this immediately to ensure start up has no zones on
 #ifdef NORMAL_LOGIC
-    api.setNormalLogic(true);
     shiftRegister.setAllLow();
 #else
-    api.setNormalLogic(false);
     shiftRegister.setAllHigh();
 #endif
 
@@ -65,7 +76,10 @@ void setup() {
     }
 
     wifi.setup();
-    ota.setup();
+    // buffered log lines have to be written before an update restarts us
+    ota.setup([]() {
+        api.flushLog();
+    });
 
     // because SprinklerAPI uses timeClient, it must be set up first, and the
     // update is required to apply the timezone offset from the constructor
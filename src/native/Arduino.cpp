@@ -0,0 +1,220 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// simulated pin states -- the ESP8266 has 17 GPIOs
+static uint8_t pinStates[17];
+
+static const auto bootTime = std::chrono::steady_clock::now();
+
+/*****************************************************************************
+ * Timing
+ ****************************************************************************/
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime
+    ).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime
+    ).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+    // nothing to give time back to -- there is no watchdog on Linux
+}
+
+/*****************************************************************************
+ * Simulated pins
+ ****************************************************************************/
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < sizeof(pinStates)) {
+        pinStates[pin] = val ? HIGH : LOW;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return (pin < sizeof(pinStates)) ? pinStates[pin] : LOW;
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val) {
+    (void)dataPin;
+    (void)clockPin;
+    (void)bitOrder;
+    (void)val;
+}
+
+/*****************************************************************************
+ * Print, Stream and Serial
+ ****************************************************************************/
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+
+    while (size--) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char* str) {
+    return (str) ? write((const uint8_t*)str, strlen(str)) : 0;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buff[64];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(buff, sizeof(buff), format, args);
+    va_end(args);
+
+    if (len < 0) {
+        return 0;
+    }
+
+    if ((size_t)len < sizeof(buff)) {
+        return write((const uint8_t*)buff, len);
+    }
+
+    std::vector<char> big(len + 1);
+
+    va_start(args, format);
+    vsnprintf(big.data(), big.size(), format, args);
+    va_end(args);
+
+    return write((const uint8_t*)big.data(), len);
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+
+    while (count < length) {
+        int c = read();
+
+        if (c < 0) break;
+        *buffer++ = (char)c;
+        count++;
+    }
+    return count;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+/*****************************************************************************
+ * EspClass
+ ****************************************************************************/
+
+void EspClass::setCommandLine(int argc, char** argv) {
+    this->argc = argc;
+    this->argv = argv;
+}
+
+uint32_t EspClass::getFreeHeap() {
+    struct mallinfo2 mi = mallinfo2();
+    return (uint32_t)mi.fordblks;
+}
+
+uint8_t EspClass::getHeapFragmentation() {
+    return 0;
+}
+
+uint32_t EspClass::getSketchSize() {
+    struct stat st;
+
+    if (stat("/proc/self/exe", &st) == 0) {
+        return (uint32_t)st.st_size;
+    }
+    return 0;
+}
+
+uint32_t EspClass::getFreeSketchSpace() {
+    return 0;
+}
+
+uint8_t EspClass::getBootVersion() {
+    return 0;
+}
+
+uint32_t EspClass::getChipId() {
+    return (uint32_t)gethostid() & 0x00ffffff;
+}
+
+uint32_t EspClass::random() {
+    static std::random_device device;
+    return device();
+}
+
+String EspClass::getResetReason() {
+    return String("Power On");
+}
+
+String EspClass::getResetInfo() {
+    return String("Fatal exception:0 flag:0 (Power On)");
+}
+
+rst_info* EspClass::getResetInfoPtr() {
+    static rst_info info = {REASON_DEFAULT_RST, 0, 0, 0, 0, 0, 0};
+    return &info;
+}
+
+void EspClass::reset() {
+    fflush(stdout);
+
+    // re-executing the process is the closest thing to a reset; if that
+    // isn't possible (no command line was recorded) just exit
+    if (argv) {
+        execv("/proc/self/exe", argv);
+    }
+    exit(0);
+}
+
+void EspClass::restart() {
+    reset();
+}
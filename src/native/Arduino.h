@@ -0,0 +1,154 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Arduino.h (native)
+ *
+ * The native (Linux) port of the small slice of the Arduino/ESP8266 core that
+ * the controller actually uses.  It is only on the include path of the
+ * [env:native] build, where it stands in for the real core so that
+ * SprinklerAPI compiles unmodified.
+ *
+ * Pins are simulated:  pinMode()/digitalWrite() simply remember the value
+ * so that digitalRead() (which the status API uses for the Output Enable
+ * pin) reports what was last written, and shiftOut() does nothing since
+ * there is no shift register attached to a Linux box.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cinttypes>
+#include <climits>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <vector>
+
+#include <WString.h>
+#include <Print.h>
+#include <Stream.h>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x00
+#define OUTPUT 0x01
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+// the Wemos D1 mini pin assignments, so that main.cpp-style wiring compiles
+#define D0 16
+#define D1 5
+#define D2 4
+#define D3 0
+#define D4 2
+#define D5 14
+#define D6 12
+#define D7 13
+#define D8 15
+#define LED_BUILTIN 2
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define memcpy_P memcpy
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
+
+/**
+ * HardwareSerial (native)
+ *
+ * Serial output goes to stdout, which is where the controller's log echo
+ * and the LOG_INFO/LOG_DEBUG macros end up.
+ */
+class HardwareSerial : public Print {
+    public:
+        void begin(unsigned long baud) { (void)baud; }
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * EspClass (native)
+ *
+ * Answers the ESP.xxx() questions asked by getAPIStatus() and setup() with
+ * values that make sense for a Linux process.  The free heap is what malloc
+ * reports as free in its arena, and reset() re-executes the process so that
+ * /restart behaves like it does on the board.
+ */
+enum rst_reason {
+    REASON_DEFAULT_RST = 0,
+    REASON_WDT_RST = 1,
+    REASON_EXCEPTION_RST = 2,
+    REASON_SOFT_WDT_RST = 3,
+    REASON_SOFT_RESTART = 4,
+    REASON_DEEP_SLEEP_AWAKE = 5,
+    REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+};
+
+class EspClass {
+    public:
+        void setCommandLine(int argc, char** argv);
+        uint32_t getFreeHeap();
+        uint8_t getHeapFragmentation();
+        uint32_t getSketchSize();
+        uint32_t getFreeSketchSpace();
+        uint8_t getBootVersion();
+        uint32_t getChipId();
+        uint32_t random();
+        String getResetReason();
+        String getResetInfo();
+        rst_info* getResetInfoPtr();
+        [[noreturn]] void reset();
+        [[noreturn]] void restart();
+
+    private:
+        int argc = 0;
+        char** argv = nullptr;
+};
+
+extern EspClass ESP;
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ESP8266WiFi.h>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ESP8266WiFiClass WiFi;
+
+/*****************************************************************************
+ * IPAddress
+ ****************************************************************************/
+
+IPAddress::IPAddress(uint32_t address) {
+    // address is in network byte order, as it comes out of sockaddr_in
+    memcpy(octets, &address, sizeof(octets));
+}
+
+String IPAddress::toString() const {
+    char buff[16];
+
+    snprintf(buff, sizeof(buff), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buff);
+}
+
+/*****************************************************************************
+ * WiFiClient
+ ****************************************************************************/
+
+WiFiClient::Socket::~Socket() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+WiFiClient::WiFiClient(int fd) : socket(std::make_shared<Socket>(fd)) {}
+
+int WiFiClient::fd() const {
+    return (socket) ? socket->fd : -1;
+}
+
+size_t WiFiClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+/**
+ * WiFiClient::write()
+ *
+ * Writes the whole buffer, blocking until the kernel accepts it, which is
+ * how the ESP8266 client behaves too.  MSG_NOSIGNAL keeps a client that has
+ * gone away from killing the process with SIGPIPE.
+ */
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    size_t sent = 0;
+
+    while (sent < size && fd() >= 0) {
+        ssize_t n = send(fd(), buf + sent, size - sent, MSG_NOSIGNAL);
+
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        sent += (size_t)n;
+    }
+    return sent;
+}
+
+int WiFiClient::availableForWrite() {
+    struct pollfd pfd = {fd(), POLLOUT, 0};
+
+    if (!connected() || poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLOUT)) {
+        return 0;
+    }
+
+    int sndbuf = 0;
+    int queued = 0;
+    socklen_t len = sizeof(sndbuf);
+
+    getsockopt(fd(), SOL_SOCKET, SO_SNDBUF, &sndbuf, &len);
+    ioctl(fd(), TIOCOUTQ, &queued);
+
+    return (sndbuf > queued) ? sndbuf - queued : 1;
+}
+
+int WiFiClient::available() {
+    int count = 0;
+
+    if (fd() < 0 || ioctl(fd(), FIONREAD, &count) != 0) {
+        return 0;
+    }
+    return count;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return (readBytes((char*)&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::peek() {
+    uint8_t c;
+
+    if (fd() < 0 || recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1) {
+        return -1;
+    }
+    return c;
+}
+
+size_t WiFiClient::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    struct pollfd pfd = {fd(), POLLIN, 0};
+
+    while (count < length && fd() >= 0 && poll(&pfd, 1, (int)timeout) > 0) {
+        ssize_t n = recv(fd(), buffer + count, length - count, 0);
+
+        if (n <= 0) break;
+        count += (size_t)n;
+    }
+    return count;
+}
+
+// reads only what has already arrived (never waits)
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    if (fd() < 0) {
+        return -1;
+    }
+
+    ssize_t n = recv(fd(), buf, size, MSG_DONTWAIT);
+
+    return (n < 0) ? 0 : (int)n;
+}
+
+/**
+ * WiFiClient::connected()
+ *
+ * A connection is considered closed once the peer has hung up, which shows
+ * up as a readable socket with no bytes to read.
+ */
+uint8_t WiFiClient::connected() {
+    if (fd() < 0) {
+        return 0;
+    }
+
+    struct pollfd pfd = {fd(), POLLIN, 0};
+
+    if (poll(&pfd, 1, 0) > 0) {
+        char c;
+
+        if (pfd.revents & (POLLHUP | POLLERR)) {
+            return 0;
+        }
+        if (recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void WiFiClient::stop() {
+    if (socket && socket->fd >= 0) {
+        shutdown(socket->fd, SHUT_RDWR);
+        close(socket->fd);
+        socket->fd = -1;
+    }
+}
+
+void WiFiClient::setNoDelay(bool noDelay) {
+    int on = (noDelay) ? 1 : 0;
+
+    if (fd() >= 0) {
+        setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+}
+
+IPAddress WiFiClient::remoteIP() const {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+
+    if (fd() < 0 || getpeername(fd(), (struct sockaddr*)&addr, &len) != 0) {
+        return IPAddress();
+    }
+    return IPAddress((uint32_t)addr.sin_addr.s_addr);
+}
+
+/*****************************************************************************
+ * WiFiServer
+ ****************************************************************************/
+
+/**
+ * WiFiServer::begin()
+ *
+ * Opens a non-blocking listening socket on all interfaces.  SO_REUSEADDR
+ * lets the process restart (see ESP.reset()) without waiting for old
+ * connections to time out.
+ */
+void WiFiServer::begin() {
+    struct sockaddr_in addr;
+    int on = 1;
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (listenFd < 0) {
+        Serial.printf("unable to create server socket: %s\n", strerror(errno));
+        return;
+    }
+
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listenFd, 16) != 0) {
+        Serial.printf("unable to listen on port %d: %s\n", port, strerror(errno));
+        ::close(listenFd);
+        listenFd = -1;
+        return;
+    }
+
+    Serial.printf("HTTP server listening on port %d\n", port);
+}
+
+void WiFiServer::close() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        listenFd = -1;
+    }
+}
+
+/**
+ * WiFiServer::accept()
+ *
+ * The accepted socket is blocking, so writes wait for the kernel to take
+ * the data just as the ESP8266 client waits for lwIP.
+ */
+WiFiClient WiFiServer::accept() {
+    if (listenFd < 0) {
+        return WiFiClient();
+    }
+
+    int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+
+    if (fd < 0) {
+        return WiFiClient();
+    }
+
+    WiFiClient client(fd);
+
+    client.setNoDelay(noDelay);
+    return client;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * ESP8266WiFi.h (native)
+ *
+ * IPAddress, WiFiClient, WiFiServer and the WiFi object.  A WiFiClient
+ * wraps a TCP socket descriptor that is shared by all copies of the client
+ * (exactly as the ESP8266 core shares its ClientContext), so the /sse
+ * handler can keep a copy of server.client() after the request handler
+ * returns.  The socket is closed when the last copy goes away or stop() is
+ * called.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+
+class IPAddress {
+    public:
+        IPAddress() = default;
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+        explicit IPAddress(uint32_t address);
+
+        String toString() const;
+        uint8_t operator[](int index) const { return octets[index]; }
+
+    private:
+        uint8_t octets[4] = {0, 0, 0, 0};
+};
+
+class WiFiClient : public Stream {
+    public:
+        WiFiClient() = default;
+        explicit WiFiClient(int fd);
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buf, size_t size) override;
+        using Print::write;
+        int availableForWrite() override;
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t readBytes(char* buffer, size_t length) override;
+        using Stream::readBytes;
+        int read(uint8_t* buf, size_t size);
+        void flush() override {}
+
+        uint8_t connected();
+        void setNoDelay(bool noDelay);
+        void stop();
+        IPAddress remoteIP() const;
+        int fd() const;
+        operator bool() const { return socket && socket->fd >= 0; }
+
+    private:
+        struct Socket {
+            int fd;
+            Socket(int fd) : fd(fd) {}
+            ~Socket();
+        };
+
+        std::shared_ptr<Socket> socket;
+};
+
+/**
+ * WiFiServer
+ *
+ * A non-blocking listening socket; accept() returns an empty client when no
+ * connection is waiting.
+ */
+
+class WiFiServer {
+    public:
+        WiFiServer(uint16_t port) : port(port) {}
+        ~WiFiServer() { close(); }
+
+        void begin();
+        void close();
+        void setNoDelay(bool noDelay) { this->noDelay = noDelay; }
+        WiFiClient accept();
+
+    private:
+        uint16_t port;
+        int listenFd = -1;
+        bool noDelay = false;
+};
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class ESP8266WiFiClass {
+    public:
+        wl_status_t begin(const char* ssid, const char* passphrase) {
+            (void)ssid;
+            (void)passphrase;
+            return WL_CONNECTED;
+        }
+        wl_status_t status() { return WL_CONNECTED; }
+        IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+        int32_t RSSI() { return 0; }
+};
+
+extern ESP8266WiFiClass WiFi;
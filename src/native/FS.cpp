@@ -0,0 +1,248 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <LittleFS.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+fs::FS LittleFS;
+
+namespace fs {
+
+// LittleFS on the D1 mini allocates in 8 KB blocks, so usage is rounded up
+// to this size per file to keep availableDiskSpace honest
+static const size_t blockSize = 8192;
+
+/*****************************************************************************
+ * File
+ ****************************************************************************/
+
+File::File(FILE* fp, const String& name) :
+    fp(fp, [](FILE* f) { fclose(f); }),
+    fileName(name) {}
+
+size_t File::write(uint8_t c) {
+    return (fp) ? fwrite(&c, 1, 1, fp.get()) : 0;
+}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+    return (fp) ? fwrite(buf, 1, size, fp.get()) : 0;
+}
+
+int File::availableForWrite() {
+    return (fp) ? INT_MAX : 0;
+}
+
+int File::available() {
+    if (!fp) return 0;
+    return (int)(size() - position());
+}
+
+int File::read() {
+    if (!fp) return -1;
+
+    int c = fgetc(fp.get());
+    return (c == EOF) ? -1 : c;
+}
+
+int File::peek() {
+    if (!fp) return -1;
+
+    int c = fgetc(fp.get());
+
+    if (c == EOF) return -1;
+    ungetc(c, fp.get());
+    return c;
+}
+
+size_t File::readBytes(char* buffer, size_t length) {
+    return (fp) ? fread(buffer, 1, length, fp.get()) : 0;
+}
+
+void File::flush() {
+    if (fp) fflush(fp.get());
+}
+
+/**
+ * File::seek()
+ *
+ * Mirrors the ESP8266 LittleFS behavior where the position given with
+ * SeekEnd counts backwards from the end of the file (see the /seek API in
+ * SprinklerAPI.cpp), which is not what fseek() does.
+ */
+bool File::seek(uint32_t pos, SeekMode mode) {
+    if (!fp) return false;
+
+    switch (mode) {
+        case SeekEnd:
+            return fseek(fp.get(), -(long)pos, SEEK_END) == 0;
+        case SeekCur:
+            return fseek(fp.get(), (long)pos, SEEK_CUR) == 0;
+        default:
+            return fseek(fp.get(), (long)pos, SEEK_SET) == 0;
+    }
+}
+
+size_t File::position() const {
+    if (!fp) return 0;
+
+    long pos = ftell(fp.get());
+    return (pos < 0) ? 0 : (size_t)pos;
+}
+
+size_t File::size() const {
+    struct stat st;
+
+    if (!fp) return 0;
+
+    fflush(fp.get());
+
+    if (fstat(fileno(fp.get()), &st) != 0) {
+        return 0;
+    }
+    return (size_t)st.st_size;
+}
+
+void File::close() {
+    fp.reset();
+}
+
+/*****************************************************************************
+ * Dir
+ ****************************************************************************/
+
+Dir::Dir(const std::string& path) : path(path) {
+    DIR* d = opendir(path.c_str());
+
+    if (!d) return;
+
+    for (struct dirent* e = readdir(d); e; e = readdir(d)) {
+        if (e->d_name[0] != '.') {
+            names.push_back(e->d_name);
+        }
+    }
+    closedir(d);
+
+    std::sort(names.begin(), names.end());
+}
+
+bool Dir::next() {
+    if (index >= names.size()) {
+        return false;
+    }
+    index++;
+    return true;
+}
+
+String Dir::fileName() const {
+    return (index > 0) ? String(names[index - 1].c_str()) : String();
+}
+
+size_t Dir::fileSize() const {
+    struct stat st;
+
+    if (index == 0 || stat((path + "/" + names[index - 1]).c_str(), &st) != 0) {
+        return 0;
+    }
+    return (size_t)st.st_size;
+}
+
+/*****************************************************************************
+ * FS
+ ****************************************************************************/
+
+void FS::setRoot(const char* root) {
+    this->root = root;
+}
+
+void FS::setCapacity(uint64_t totalBytes) {
+    this->totalBytes = totalBytes;
+}
+
+bool FS::begin() {
+    struct stat st;
+
+    if (stat(root.c_str(), &st) == 0) {
+        return S_ISDIR(st.st_mode);
+    }
+    return mkdir(root.c_str(), 0755) == 0;
+}
+
+std::string FS::resolve(const char* path) const {
+    std::string p(path ? path : "");
+
+    if (p.empty() || p[0] != '/') {
+        p = "/" + p;
+    }
+    return root + p;
+}
+
+File FS::open(const String& path, const char* mode) {
+    return open(path.c_str(), mode);
+}
+
+File FS::open(const char* path, const char* mode) {
+    FILE* fp = fopen(resolve(path).c_str(), mode);
+
+    if (!fp) {
+        return File();
+    }
+    return File(fp, String(path));
+}
+
+bool FS::exists(const String& path) {
+    return exists(path.c_str());
+}
+
+bool FS::exists(const char* path) {
+    struct stat st;
+    return stat(resolve(path).c_str(), &st) == 0;
+}
+
+bool FS::remove(const String& path) {
+    return remove(path.c_str());
+}
+
+bool FS::remove(const char* path) {
+    return ::remove(resolve(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+    return ::rename(resolve(pathFrom).c_str(), resolve(pathTo).c_str()) == 0;
+}
+
+Dir FS::openDir(const char* path) {
+    return Dir(resolve(path));
+}
+
+bool FS::info64(FSInfo64& info) {
+    Dir dir = openDir("/");
+
+    info.totalBytes = totalBytes;
+    info.usedBytes = 0;
+    info.blockSize = blockSize;
+    info.pageSize = 256;
+    info.maxOpenFiles = 5;
+    info.maxPathLength = 32;
+
+    while (dir.next()) {
+        info.usedBytes += ((dir.fileSize() + blockSize - 1) / blockSize) * blockSize;
+    }
+
+    return true;
+}
+
+} // namespace fs
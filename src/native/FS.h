@@ -0,0 +1,131 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * FS.h (native)
+ *
+ * The fs::FS, fs::File and fs::Dir classes backed by a directory on the
+ * Linux filesystem.  Every path the controller uses ("/log.dat",
+ * "/cycles.json", ...) is resolved relative to the root directory given to
+ * setRoot(), and the root is flat -- just like the controller's use of
+ * LittleFS.
+ *
+ * The reported capacity is a simulated flash partition (see setCapacity())
+ * so that availableDiskSpace in /status behaves like it does on the board.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+namespace fs {
+
+enum SeekMode {
+    SeekSet = 0,
+    SeekCur = 1,
+    SeekEnd = 2
+};
+
+struct FSInfo64 {
+    uint64_t totalBytes;
+    uint64_t usedBytes;
+    size_t blockSize;
+    size_t pageSize;
+    size_t maxOpenFiles;
+    size_t maxPathLength;
+};
+
+class File : public Stream {
+    public:
+        File() = default;
+        File(FILE* fp, const String& name);
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buf, size_t size) override;
+        using Print::write;
+        int availableForWrite() override;
+        int available() override;
+        int read() override;
+        size_t read(uint8_t* buf, size_t size) { return readBytes((char*)buf, size); }
+        int peek() override;
+        size_t readBytes(char* buffer, size_t length) override;
+        using Stream::readBytes;
+        void flush() override;
+        bool seek(uint32_t pos, SeekMode mode);
+        bool seek(uint32_t pos) { return seek(pos, SeekSet); }
+        size_t position() const;
+        size_t size() const;
+        void close();
+        const char* name() const { return fileName.c_str(); }
+        operator bool() const { return (bool)fp; }
+
+    private:
+        std::shared_ptr<FILE> fp;
+        String fileName;
+};
+
+class Dir {
+    public:
+        Dir() = default;
+        Dir(const std::string& path);
+
+        bool next();
+        String fileName() const;
+        size_t fileSize() const;
+
+    private:
+        std::string path;
+        std::vector<std::string> names;
+        size_t index = 0;
+};
+
+class FS {
+    public:
+        void setRoot(const char* root);
+        void setCapacity(uint64_t totalBytes);
+
+        bool begin();
+        void end() {}
+        File open(const String& path, const char* mode);
+        File open(const char* path, const char* mode);
+        bool exists(const String& path);
+        bool exists(const char* path);
+        bool remove(const String& path);
+        bool remove(const char* path);
+        bool rename(const char* pathFrom, const char* pathTo);
+        Dir openDir(const char* path);
+        Dir openDir(const String& path) { return openDir(path.c_str()); }
+        bool info64(FSInfo64& info);
+
+    private:
+        std::string root = "littlefs";
+        uint64_t totalBytes = 1024 * 1024;
+
+        std::string resolve(const char* path) const;
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::Dir;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::FSInfo64;
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * NTPClient.h (native)
+ *
+ * The clock.  Rather than asking an NTP server, the time comes from the
+ * system clock (which on Linux is already NTP disciplined), offset by the
+ * time zone given to the constructor exactly as the real NTPClient does.
+ * The controller then treats the epoch as local time, so the native build
+ * runs with TZ=UTC0 just like the ESP8266.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+class NTPClient {
+    public:
+        NTPClient(WiFiUDP& udp, long timeOffset = 0) : timeOffset(timeOffset) {
+            (void)udp;
+        }
+
+        void begin() {}
+        bool update() { return true; }
+        bool forceUpdate() { return true; }
+        bool isTimeSet() const { return true; }
+        void setTimeOffset(int timeOffset) { this->timeOffset = timeOffset; }
+
+        unsigned long getEpochTime() const {
+            return (unsigned long)(time(nullptr) + timeOffset);
+        }
+        int getDay() const { return (((getEpochTime() / 86400L) + 4) % 7); }
+        int getHours() const { return ((getEpochTime() % 86400L) / 3600); }
+        int getMinutes() const { return ((getEpochTime() % 3600) / 60); }
+        int getSeconds() const { return (getEpochTime() % 60); }
+
+        String getFormattedTime() const {
+            char buff[9];
+
+            snprintf(buff, sizeof(buff), "%02d:%02d:%02d", getHours(), getMinutes(), getSeconds());
+            return String(buff);
+        }
+
+    private:
+        long timeOffset;
+};
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Print.h (native)
+ *
+ * Base class for everything that can be written to:  Serial, files and
+ * network clients.  Subclasses only have to provide write().
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <WString.h>
+
+class Print {
+    public:
+        virtual ~Print() = default;
+
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size);
+        size_t write(const char* str);
+        size_t write(const char* buffer, size_t size) {
+            return write((const uint8_t*)buffer, size);
+        }
+        virtual int availableForWrite() { return 0; }
+        virtual void flush() {}
+
+        size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+        size_t print(const char* s) { return write(s); }
+        size_t print(const String& s) { return write(s.c_str(), s.length()); }
+        size_t print(const __FlashStringHelper* s) { return print(String(s)); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(unsigned char n) { return print(String(n)); }
+        size_t print(int n) { return print(String(n)); }
+        size_t print(unsigned int n) { return print(String(n)); }
+        size_t print(long n) { return print(String(n)); }
+        size_t print(unsigned long n) { return print(String(n)); }
+        size_t print(double n, int digits = 2) { return print(String(n, digits)); }
+
+        size_t println() { return write("\r\n"); }
+
+        template<typename T>
+        size_t println(const T& value) {
+            size_t n = print(value);
+            return n + println();
+        }
+};
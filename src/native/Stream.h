@@ -0,0 +1,42 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Stream.h (native)
+ *
+ * Base class for everything that can be read from as well as written to.
+ * ArduinoJson's deserializeJson(doc, file) reads through this interface.
+ */
+
+#pragma once
+
+#include <Print.h>
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        virtual size_t readBytes(char* buffer, size_t length);
+        size_t readBytes(uint8_t* buffer, size_t length) {
+            return readBytes((char*)buffer, length);
+        }
+        void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+
+    protected:
+        unsigned long timeout = 1000;
+};
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Ticker.h>
+
+// every Ticker that is currently armed
+static std::vector<Ticker*> tickers;
+
+Ticker::~Ticker() {
+    detach();
+}
+
+void Ticker::attach(float seconds, callback_function_t callback) {
+    arm((uint32_t)(seconds * 1000), true, callback);
+}
+
+void Ticker::attach_ms(uint32_t milliseconds, callback_function_t callback) {
+    arm(milliseconds, true, callback);
+}
+
+void Ticker::once(float seconds, callback_function_t callback) {
+    arm((uint32_t)(seconds * 1000), false, callback);
+}
+
+void Ticker::once_ms(uint32_t milliseconds, callback_function_t callback) {
+    arm(milliseconds, false, callback);
+}
+
+void Ticker::arm(uint32_t milliseconds, bool repeat, callback_function_t callback) {
+    detach();
+
+    this->callback = callback;
+    this->interval = milliseconds;
+    this->nextMillis = millis() + milliseconds;
+    this->repeat = repeat;
+    this->armed = true;
+
+    tickers.push_back(this);
+}
+
+void Ticker::detach() {
+    if (armed) {
+        tickers.erase(std::remove(tickers.begin(), tickers.end(), this), tickers.end());
+        armed = false;
+    }
+}
+
+/**
+ * Ticker::service()
+ *
+ * Runs the callbacks that are due.  A callback is allowed to re-arm or
+ * detach its own Ticker (the /sse handler's once() callback calls attach()
+ * on the same Ticker), so the due list is collected before any callback
+ * runs and each callback is copied before it is invoked.
+ */
+void Ticker::service() {
+    unsigned long now = millis();
+    std::vector<Ticker*> due;
+
+    for (Ticker* t : tickers) {
+        if ((long)(now - t->nextMillis) >= 0) {
+            due.push_back(t);
+        }
+    }
+
+    for (Ticker* t : due) {
+        // skip any Ticker detached by an earlier callback in this pass
+        if (std::find(tickers.begin(), tickers.end(), t) == tickers.end()) {
+            continue;
+        }
+
+        callback_function_t callback = t->callback;
+
+        if (t->repeat) {
+            t->nextMillis += t->interval;
+        } else {
+            t->detach();
+        }
+
+        callback();
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Ticker.h (native)
+ *
+ * On the ESP8266 a Ticker callback is run by the SDK's timer between
+ * iterations of loop().  The native port keeps the same guarantee without
+ * threads:  Ticker::service() must be called from the main loop and runs
+ * every callback whose time has come.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class Ticker {
+    public:
+        typedef std::function<void(void)> callback_function_t;
+
+        Ticker() = default;
+        Ticker(const Ticker&) = delete;
+        Ticker& operator=(const Ticker&) = delete;
+        ~Ticker();
+
+        void attach(float seconds, callback_function_t callback);
+        void attach_ms(uint32_t milliseconds, callback_function_t callback);
+        void once(float seconds, callback_function_t callback);
+        void once_ms(uint32_t milliseconds, callback_function_t callback);
+        void detach();
+        bool active() const { return armed; }
+
+        static void service();
+
+    private:
+        callback_function_t callback;
+        unsigned long interval = 0;
+        unsigned long nextMillis = 0;
+        bool repeat = false;
+        bool armed = false;
+
+        void arm(uint32_t milliseconds, bool repeat, callback_function_t callback);
+};
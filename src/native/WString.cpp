@@ -0,0 +1,392 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <WString.h>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <strings.h>
+
+/*****************************************************************************
+ * Number formatting helpers
+ ****************************************************************************/
+
+static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+    const char* digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    char buff[65];
+    int i = sizeof(buff) - 1;
+
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+
+    buff[i] = '\0';
+
+    do {
+        buff[--i] = digits[value % base];
+        value /= base;
+    } while (value > 0);
+
+    return std::string(&buff[i]);
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    // Arduino only prints a minus sign for base 10; other bases show the
+    // two's complement bits, which is what the cast below accomplishes
+    if (base == 10 && value < 0) {
+        return "-" + formatUnsigned((unsigned long long)(-(value + 1)) + 1, base);
+    }
+    return formatUnsigned((unsigned long long)value, base);
+}
+
+static std::string formatFloat(double value, unsigned char decimalPlaces) {
+    char buff[64];
+    snprintf(buff, sizeof(buff), "%.*f", decimalPlaces, value);
+    return std::string(buff);
+}
+
+/*****************************************************************************
+ * Constructors and assignment
+ ****************************************************************************/
+
+String::String(const char* cstr) {
+    if (cstr) buffer = cstr;
+}
+
+String::String(const char* cstr, size_t length) {
+    if (cstr) buffer.assign(cstr, length);
+}
+
+String::String(const __FlashStringHelper* str) :
+    String(reinterpret_cast<const char*>(str)) {}
+
+String::String(char c) : buffer(1, c) {}
+
+String::String(unsigned char value, unsigned char base) :
+    buffer(formatUnsigned(value, base)) {}
+
+String::String(int value, unsigned char base) :
+    buffer(formatSigned(value, base)) {}
+
+String::String(unsigned int value, unsigned char base) :
+    buffer(formatUnsigned(value, base)) {}
+
+String::String(long value, unsigned char base) :
+    buffer(formatSigned(value, base)) {}
+
+String::String(unsigned long value, unsigned char base) :
+    buffer(formatUnsigned(value, base)) {}
+
+String::String(long long value, unsigned char base) :
+    buffer(formatSigned(value, base)) {}
+
+String::String(unsigned long long value, unsigned char base) :
+    buffer(formatUnsigned(value, base)) {}
+
+String::String(float value, unsigned char decimalPlaces) :
+    buffer(formatFloat(value, decimalPlaces)) {}
+
+String::String(double value, unsigned char decimalPlaces) :
+    buffer(formatFloat(value, decimalPlaces)) {}
+
+String& String::operator=(const char* cstr) {
+    if (cstr) {
+        buffer = cstr;
+    } else {
+        buffer.clear();
+    }
+    return *this;
+}
+
+String& String::operator=(const __FlashStringHelper* str) {
+    return *this = reinterpret_cast<const char*>(str);
+}
+
+String& String::operator=(char c) {
+    buffer.assign(1, c);
+    return *this;
+}
+
+unsigned char String::reserve(unsigned int size) {
+    buffer.reserve(size);
+    return 1;
+}
+
+/*****************************************************************************
+ * Concatenation
+ ****************************************************************************/
+
+bool String::concat(const String& str) {
+    buffer += str.buffer;
+    return true;
+}
+
+bool String::concat(const char* cstr) {
+    if (!cstr) return false;
+    buffer += cstr;
+    return true;
+}
+
+bool String::concat(const char* cstr, unsigned int length) {
+    if (!cstr) return false;
+    buffer.append(cstr, length);
+    return true;
+}
+
+bool String::concat(const __FlashStringHelper* str) {
+    return concat(reinterpret_cast<const char*>(str));
+}
+
+bool String::concat(char c) {
+    buffer += c;
+    return true;
+}
+
+bool String::concat(unsigned char num) {
+    buffer += formatUnsigned(num, 10);
+    return true;
+}
+
+bool String::concat(int num) {
+    buffer += formatSigned(num, 10);
+    return true;
+}
+
+bool String::concat(unsigned int num) {
+    buffer += formatUnsigned(num, 10);
+    return true;
+}
+
+bool String::concat(long num) {
+    buffer += formatSigned(num, 10);
+    return true;
+}
+
+bool String::concat(unsigned long num) {
+    buffer += formatUnsigned(num, 10);
+    return true;
+}
+
+bool String::concat(long long num) {
+    buffer += formatSigned(num, 10);
+    return true;
+}
+
+bool String::concat(unsigned long long num) {
+    buffer += formatUnsigned(num, 10);
+    return true;
+}
+
+bool String::concat(float num) {
+    buffer += formatFloat(num, 2);
+    return true;
+}
+
+bool String::concat(double num) {
+    buffer += formatFloat(num, 2);
+    return true;
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+
+String operator+(const String& lhs, char rhs) {
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+
+String operator+(char lhs, const String& rhs) {
+    String s(lhs);
+    s.concat(rhs);
+    return s;
+}
+
+/*****************************************************************************
+ * Comparison
+ ****************************************************************************/
+
+int String::compareTo(const String& s) const {
+    return buffer.compare(s.buffer);
+}
+
+bool String::equals(const String& s) const {
+    return buffer == s.buffer;
+}
+
+bool String::equals(const char* cstr) const {
+    return buffer == (cstr ? cstr : "");
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    return buffer.length() == s.buffer.length() &&
+        strcasecmp(buffer.c_str(), s.buffer.c_str()) == 0;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return startsWith(prefix, 0);
+}
+
+bool String::startsWith(const String& prefix, unsigned int offset) const {
+    return offset + prefix.buffer.length() <= buffer.length() &&
+        buffer.compare(offset, prefix.buffer.length(), prefix.buffer) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return buffer.length() >= suffix.buffer.length() &&
+        buffer.compare(
+            buffer.length() - suffix.buffer.length(),
+            suffix.buffer.length(),
+            suffix.buffer
+        ) == 0;
+}
+
+/*****************************************************************************
+ * Character access and searching
+ ****************************************************************************/
+
+char String::charAt(unsigned int index) const {
+    return (index < buffer.length()) ? buffer[index] : '\0';
+}
+
+void String::setCharAt(unsigned int index, char c) {
+    if (index < buffer.length()) buffer[index] = c;
+}
+
+char& String::operator[](unsigned int index) {
+    static char dummy;
+
+    if (index >= buffer.length()) {
+        dummy = '\0';
+        return dummy;
+    }
+    return buffer[index];
+}
+
+int String::indexOf(char ch, unsigned int fromIndex) const {
+    size_t pos = buffer.find(ch, fromIndex);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::indexOf(const String& str, unsigned int fromIndex) const {
+    size_t pos = buffer.find(str.buffer, fromIndex);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char ch) const {
+    size_t pos = buffer.rfind(ch);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String& str) const {
+    size_t pos = buffer.rfind(str.buffer);
+    return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+    return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+    String s;
+
+    if (beginIndex > endIndex) std::swap(beginIndex, endIndex);
+    if (beginIndex >= buffer.length()) return s;
+    if (endIndex > buffer.length()) endIndex = buffer.length();
+
+    s.buffer = buffer.substr(beginIndex, endIndex - beginIndex);
+    return s;
+}
+
+/*****************************************************************************
+ * Modification
+ ****************************************************************************/
+
+void String::replace(char find, char replace) {
+    for (char& c : buffer) {
+        if (c == find) c = replace;
+    }
+}
+
+void String::replace(const String& find, const String& replace) {
+    if (find.buffer.empty()) return;
+
+    size_t pos = 0;
+
+    while ((pos = buffer.find(find.buffer, pos)) != std::string::npos) {
+        buffer.replace(pos, find.buffer.length(), replace.buffer);
+        pos += replace.buffer.length();
+    }
+}
+
+void String::remove(unsigned int index) {
+    if (index < buffer.length()) buffer.erase(index);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < buffer.length()) buffer.erase(index, count);
+}
+
+void String::toLowerCase() {
+    for (char& c : buffer) c = (char)tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : buffer) c = (char)toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t first = buffer.find_first_not_of(" \t\r\n");
+
+    if (first == std::string::npos) {
+        buffer.clear();
+        return;
+    }
+
+    size_t last = buffer.find_last_not_of(" \t\r\n");
+    buffer = buffer.substr(first, last - first + 1);
+}
+
+/*****************************************************************************
+ * Conversion
+ ****************************************************************************/
+
+long String::toInt() const {
+    return atol(buffer.c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(buffer.c_str());
+}
+
+double String::toDouble() const {
+    return atof(buffer.c_str());
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * WString.h (native)
+ *
+ * Arduino's String class implemented on top of std::string.  Only the
+ * members that the controller (and ArduinoJson's String adapters) use are
+ * provided, but they follow the Arduino semantics -- most notably that
+ * concatenating a uint8_t appends its decimal value, not a character.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// F("...") is a no-op on Linux, but the type is kept distinct so that the
+// same overloads resolve as they do on the board
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper*>(pstr_pointer))
+
+class String {
+    public:
+        String() = default;
+        String(const char* cstr);
+        String(const char* cstr, size_t length);
+        String(const String& str) = default;
+        String(String&& str) = default;
+        String(const __FlashStringHelper* str);
+        explicit String(char c);
+        explicit String(unsigned char value, unsigned char base = 10);
+        explicit String(int value, unsigned char base = 10);
+        explicit String(unsigned int value, unsigned char base = 10);
+        explicit String(long value, unsigned char base = 10);
+        explicit String(unsigned long value, unsigned char base = 10);
+        explicit String(long long value, unsigned char base = 10);
+        explicit String(unsigned long long value, unsigned char base = 10);
+        explicit String(float value, unsigned char decimalPlaces = 2);
+        explicit String(double value, unsigned char decimalPlaces = 2);
+
+        String& operator=(const String& rhs) = default;
+        String& operator=(String&& rhs) = default;
+        String& operator=(const char* cstr);
+        String& operator=(const __FlashStringHelper* str);
+        String& operator=(char c);
+
+        unsigned char reserve(unsigned int size);
+        unsigned int length() const { return (unsigned int)buffer.length(); }
+        bool isEmpty() const { return buffer.empty(); }
+        const char* c_str() const { return buffer.c_str(); }
+        char* begin() { return &buffer[0]; }
+        char* end() { return &buffer[0] + buffer.length(); }
+
+        bool concat(const String& str);
+        bool concat(const char* cstr);
+        bool concat(const char* cstr, unsigned int length);
+        bool concat(const __FlashStringHelper* str);
+        bool concat(char c);
+        bool concat(unsigned char num);
+        bool concat(int num);
+        bool concat(unsigned int num);
+        bool concat(long num);
+        bool concat(unsigned long num);
+        bool concat(long long num);
+        bool concat(unsigned long long num);
+        bool concat(float num);
+        bool concat(double num);
+
+        template<typename T>
+        String& operator+=(const T& rhs) {
+            concat(rhs);
+            return *this;
+        }
+
+        int compareTo(const String& s) const;
+        bool equals(const String& s) const;
+        bool equals(const char* cstr) const;
+        bool equalsIgnoreCase(const String& s) const;
+        bool startsWith(const String& prefix) const;
+        bool startsWith(const String& prefix, unsigned int offset) const;
+        bool endsWith(const String& suffix) const;
+
+        bool operator==(const String& rhs) const { return equals(rhs); }
+        bool operator==(const char* cstr) const { return equals(cstr); }
+        bool operator!=(const String& rhs) const { return !equals(rhs); }
+        bool operator!=(const char* cstr) const { return !equals(cstr); }
+        bool operator<(const String& rhs) const { return compareTo(rhs) < 0; }
+
+        char charAt(unsigned int index) const;
+        void setCharAt(unsigned int index, char c);
+        char operator[](unsigned int index) const { return charAt(index); }
+        char& operator[](unsigned int index);
+
+        int indexOf(char ch, unsigned int fromIndex = 0) const;
+        int indexOf(const String& str, unsigned int fromIndex = 0) const;
+        int lastIndexOf(char ch) const;
+        int lastIndexOf(const String& str) const;
+        String substring(unsigned int beginIndex) const;
+        String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+        void replace(char find, char replace);
+        void replace(const String& find, const String& replace);
+        void remove(unsigned int index);
+        void remove(unsigned int index, unsigned int count);
+        void toLowerCase();
+        void toUpperCase();
+        void trim();
+
+        long toInt() const;
+        float toFloat() const;
+        double toDouble() const;
+
+    private:
+        std::string buffer;
+};
+
+/**
+ * StringSumHelper
+ *
+ * Exists only so that code (like ArduinoJson's String adapter) which names
+ * the type still compiles.  The operator+() overloads below return String.
+ */
+class StringSumHelper : public String {
+    public:
+        using String::String;
+        StringSumHelper(const String& s) : String(s) {}
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+String operator+(char lhs, const String& rhs);
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2025 David Main
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * native_main.cpp
+ *
+ * Entry point of the [env:native] build.  It wires up SprinklerAPI exactly
+ * like main.cpp does on the D1 mini -- minus WiFi, OTA and the heartbeat
+ * LED -- and then runs the same loop.
+ *
+ * Usage:  program [port [fs_root]]
+ *
+ *      port    - TCP port to serve the API on (default 8080)
+ *      fs_root - directory standing in for LittleFS (default ./littlefs)
+ */
+
+#include <Arduino.h>
+#include <SprinklerWebServer.hpp>
+#include <WiFiUdp.h>
+#include <ShiftRegister74HC595.h>
+#include <LittleFS.h>
+#include <NTPClient.h>
+#include <SprinklerAPI.hpp>
+#include <Ticker.h>
+#include <csignal>
+
+#define MTN_DAYLIGHT_OFFSET_SECONDS (long)(-6 * 60 * 60)
+
+// set by SIGINT/SIGTERM so the loop can flush the log before exiting
+static volatile sig_atomic_t stopRequested = 0;
+
+int main(int argc, char* argv[]) {
+    int port = (argc > 1) ? atoi(argv[1]) : 8080;
+    const char* fsRoot = (argc > 2) ? argv[2] : "littlefs";
+
+    // the controller treats NTP epoch time as local time (the ESP8266 has no
+    // time zone), so localtime() must not apply the host's time zone
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    // unbuffered so the serial log interleaves sensibly with other output
+    setvbuf(stdout, nullptr, _IONBF, 0);
+
+    ESP.setCommandLine(argc, argv);
+    LittleFS.setRoot(fsRoot);
+
+    SprinklerWebServer server(port);
+    WiFiUDP ntpUDP;
+    NTPClient timeClient(ntpUDP, MTN_DAYLIGHT_OFFSET_SECONDS);
+    ZoneShiftRegister_t shiftRegister(
+        /* serialDataPin */ D5,
+        /* clockPin      */ D8,
+        /* latchPin      */ D7
+    );
+    SprinklerAPI api(server, shiftRegister, timeClient, NUMBER_OF_ZONES, D0);
+
+    unsigned long setupStart = millis();
+
+#ifdef NORMAL_LOGIC
+    shiftRegister.setAllLow();
+#else
+    shiftRegister.setAllHigh();
+#endif
+
+    if (!LittleFS.begin()) {
+        api.setFsAvailable(false);
+    }
+
+    timeClient.begin();
+    timeClient.update();
+
+    api.setup();
+    api.logMsgf("setup duration=%lu", millis() - setupStart);
+
+    signal(SIGINT, [](int) { stopRequested = 1; });
+    signal(SIGTERM, [](int) { stopRequested = 1; });
+
+    while (!stopRequested) {
+        timeClient.update();
+        Ticker::service();
+        api.loop();
+
+        // the board spins through loop() as fast as it can; on Linux that
+        // would just burn a core, so give a millisecond back per iteration
+        delay(1);
+    }
+
+    api.flushLog();
+
+    return 0;
+}
@@ -18,12 +18,16 @@
 
 OTA::OTA(const char* hostname) : hostname(hostname) {}
 
-void OTA::setup() {
+void OTA::setup(THandlerFunction onUpdateStart) {
     setHostname(hostname);
 
-    onStart([this]() {
+    onStart([this, onUpdateStart]() {
         String type;
 
+        if (onUpdateStart) {
+            onUpdateStart();
+        }
+
         if (getCommand() == U_FLASH) {
             type = "sketch";
         } else {  // U_FS
@@ -22,6 +22,8 @@ class OTA : public ArduinoOTAClass {
     const char* hostname;
    public:
     OTA(const char* hostname);
-    void setup();
+    // onUpdateStart runs before an update starts (the controller restarts
+    // when it's done)
+    void setup(THandlerFunction onUpdateStart = nullptr);
     void loop();
 };
\ No newline at end of file
@@ -56,10 +56,11 @@ objects that exist in the system (even if they don't yet exist physically).
 """
 import json
 from random import randrange, choices
-from time import sleep
+from time import sleep, time
 from typing import Optional, Union
 
 import inspect
+import re
 import requests
 import unittest
 
@@ -346,6 +347,29 @@ class SprinklerAPITests(TestBase):
     def log_func_name(self, func_name):
         self.invoke_api(f"/debug/--- {func_name} ---", 1)
 
+    def test_05_ui_1_fingerprinted_script(self):
+        """
+        Test that the sprinklers.js index.html asks for is sent with the ETag
+        its URL names (?v=<ETag>) and may be cached for good, and that a URL
+        naming some other version of it gets no such promise.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        result = requests.get(f"{TEST_SERVER}/")
+        self.assertEqual(result.status_code, 200)
+        match = re.search(r'src="/sprinklers\.js\?v=([0-9a-f]+)"', result.text)
+        self.assertIsNotNone(match)
+        version = match.group(1)
+
+        result = requests.get(f"{TEST_SERVER}/sprinklers.js?v={version}")
+        self.assertEqual(result.status_code, 200)
+        self.assertEqual(result.headers.get('ETag'), f'"{version}"')
+        self.assertIn('immutable', result.headers.get('Cache-Control'))
+
+        result = requests.get(f"{TEST_SERVER}/sprinklers.js?v=00000000")
+        self.assertEqual(result.status_code, 200)
+        self.assertEqual(result.headers.get('Cache-Control'), 'no-cache')
+
     def test_10_status_api(self):
         """
         Test basic /status API output
@@ -374,6 +398,83 @@ class SprinklerAPITests(TestBase):
         self.log_func_name(self.get_my_func_name())
         self.invoke_status(delay=0)
 
+    def test_10_status_api_2_conditional_get(self):
+        """
+        Test that /status and /cycles send an ETag of the state, answer it with
+        a 304 (and no body) while nothing has changed, and send a new one once
+        something does.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        result = requests.get(f"{TEST_SERVER}/status")
+        self.assertEqual(result.status_code, 200)
+        etag = result.headers.get('ETag')
+        self.assertIsNotNone(etag)
+
+        for url in ["/status", "/cycles"]:
+            result = requests.get(f"{TEST_SERVER}{url}", headers={'If-None-Match': etag})
+            self.assertEqual(result.status_code, 304)
+            self.assertEqual(len(result.content), 0)
+
+        self.invoke_zone_on(1)
+        self.invoke_zone_off(1)
+
+        result = requests.get(f"{TEST_SERVER}/status", headers={'If-None-Match': etag})
+        self.assertEqual(result.status_code, 200)
+        self.assertNotEqual(result.headers.get('ETag'), etag)
+
+    def test_10_status_api_3_wait(self):
+        """
+        Test that /status/wait answers right away without since, with a 304
+        when nothing changes within the timeout, and with the new version and
+        status once something does.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        status = self.invoke_api("/status/wait", 0)
+        version = status["version"]
+        self.evaluate_status(status["state"])
+
+        result = requests.get(f"{TEST_SERVER}/status/wait?since={version}&timeout=1")
+        self.assertEqual(result.status_code, 304)
+
+        self.invoke_zone_on(1)
+
+        status = self.invoke_api(f"/status/wait?since={version}&timeout=5", 0)
+        self.assertNotEqual(status["version"], version)
+        self.assertIn(1, status["state"]["on"])
+
+        self.invoke_zone_off(1)
+
+    def test_10_status_api_4_version_after_change(self):
+        """
+        Test that the version and ETag given out right after a change still
+        hold once the change has been written to the filesystem (the journal
+        and the log), so that waiting on them parks and a conditional GET
+        gets a 304.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        adj = self.invoke_status(0)["adj"]
+        self.invoke_api("/adj/90", 0)
+
+        status = self.invoke_api("/status/wait", 0)
+        version = status["version"]
+        result = requests.get(f"{TEST_SERVER}/status")
+        etag = result.headers.get('ETag')
+        self.assertEqual(etag, f'W/"{version}"')
+
+        # the journal and the log are written in the background
+        sleep(2)
+
+        result = requests.get(f"{TEST_SERVER}/status", headers={'If-None-Match': etag})
+        self.assertEqual(result.status_code, 304)
+
+        result = requests.get(f"{TEST_SERVER}/status/wait?since={version}&timeout=1")
+        self.assertEqual(result.status_code, 304)
+
+        self.invoke_api(f"/adj/{adj}", 0)
+
     def test_20_zones_1_basic(self):
         """Test basic /zone/{}/{} usage"""
         self.log_func_name(self.get_my_func_name())
@@ -476,6 +577,63 @@ class SprinklerAPITests(TestBase):
         self.invoke_zone_off(7)
         self.invoke_zone_off([6, 7])
 
+    def test_20_zones_4_latched_registers(self):
+        """
+        Verify the exact register values latched when zones are switched.
+
+        Only possible against a controller built with the recording register
+        transport (like the native build), which provides /latches.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        # this also forgets any latches recorded before this test
+        latches = self.invoke_api("/latches", 0)
+
+        if latches["status"] != "ok":
+            self.skipTest("controller was not built with SHIFT_REGISTER_RECORDING")
+
+        self.invoke_zone_all_off()
+        all_off = self.invoke_status(delay=0)["registers"]
+        self.invoke_api("/latches", 0)
+
+        self.invoke_zone_on([1, 3])
+        self.invoke_zone_off([1, 3])
+
+        # the on and off should each have latched the whole register chain
+        # in one go (zones 1 and 3 are bits 0 and 2 of the registers)
+        latched = [value for _, value in self.invoke_api("/latches", 0)["latches"]]
+
+        self.assertEqual(latched, [all_off ^ 0b101, all_off])
+
+    def test_20_zones_5_coalesced_latches(self):
+        """
+        Verify that a toggle switches zones with a single latch and that a
+        command that changes nothing doesn't latch at all.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        latches = self.invoke_api("/latches", 0)
+
+        if latches["status"] != "ok":
+            self.skipTest("controller was not built with SHIFT_REGISTER_RECORDING")
+
+        self.invoke_zone_all_off()
+        all_off = self.invoke_status(delay=0)["registers"]
+        self.invoke_zone_on(1)
+        self.invoke_api("/latches", 0)
+
+        self.invoke_api("/zone/3/toggle")
+        self.invoke_api("/zone/3/on")
+        status = self.invoke_status(delay=1)
+
+        self.assertEqual(status["on"], [3])
+
+        latched = [value for _, value in self.invoke_api("/latches", 0)["latches"]]
+
+        self.assertEqual(latched, [all_off ^ 0b100])
+
+        self.invoke_zone_all_off()
+
     def test_30_schedules_1_basics(self):
         """
         Ensure the /schd API works
@@ -630,6 +788,45 @@ class SprinklerAPITests(TestBase):
         self.assertFalse(status["on"])
         self.assertFalse(status["schedule"])
 
+    def test_30_schedules_3_batch(self):
+        """
+        Test POST /batch, which applies a list of operations together:
+
+        - a valid batch is applied all at once (no waiting on the events
+            queue), so the status reflects all of it right away
+        - a batch with an invalid operation is rejected without any of its
+            operations being applied
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        ops = ["/schd/cancel", "/schd/1,2/10", "/schd/5/15", "/adj/80"]
+        result = requests.post(f"{TEST_SERVER}/batch", data=json.dumps(ops))
+        status = self.evaluate_api_response(result)
+
+        self.assertEqual(status["status"], "ok")
+        self.assertEqual(status["ops"], len(ops))
+
+        status = self.invoke_status(0)
+
+        self.assertEqual(status["schedulerState"], "running")
+        self.assertEqual(status["schedule"], [[[1, 2], 10], [[5], 15]])
+        self.assertEqual(status["adj"], 80)
+
+        ops = ["/adj/100", "/schd/cancel", "/zone/99/on"]
+        result = requests.post(f"{TEST_SERVER}/batch", data=json.dumps(ops))
+        status = self.evaluate_api_response(result)
+
+        self.assertEqual(status["status"], "error")
+        self.assertIn("operation 3", status["msg"])
+
+        status = self.invoke_status(0)
+
+        self.assertEqual(status["adj"], 80)
+        self.assertEqual(status["scheduleSize"], 2)
+
+        result = requests.post(f"{TEST_SERVER}/batch", data=json.dumps(["/schd/cancel", "/adj/100"]))
+        self.assertEqual(self.evaluate_api_response(result)["status"], "ok")
+
     def test_40_testing_apis_10_download(self):
         """ Make sure /download on /cycles.json works """
         self.log_func_name(self.get_my_func_name())
@@ -896,6 +1093,131 @@ class SprinklerAPITests(TestBase):
         self.invoke_api("/deser", 0)
         self.invoke_api("/calc", 0)
 
+    def test_40_testing_apis_50_next_run_day_offset(self):
+        """Check getNextRunDayOffset() through the /test API"""
+        self.log_func_name(self.get_my_func_name())
+
+        # (daysBitField, startDOW, offset) -> expected nextRunDayOffset
+        cases = {
+            (0b0001000, 3, 0): 0,   # today is a run day
+            (0b0001000, 3, 1): 7,   # today skipped, so a week from today
+            (0b0000001, 3, 0): 4,   # Wed -> Sun wraps around the week
+            (0b1000001, 6, 1): 1,   # Sat -> Sun
+            (0b1111111, 2, 5): 5,   # every day, starting 5 days out
+            (0, 3, 0): -1,          # no run days at all
+        }
+
+        for (days, dow, offset), expected in cases.items():
+            response = requests.get(f"{TEST_SERVER}/test/{days}/{dow}/{offset}")
+            self.assertEqual(response.status_code, 200)
+            self.assertIn(f"nextRunDayOffset={expected}\n", response.text)
+
+    def test_40_testing_apis_60_log_text(self):
+        """
+        The log is stored in binary, so make sure /log/show and
+        /download/log.dat render it back to text lines
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        self.invoke_zone_on([1, 3])
+        self.invoke_zone_all_off()
+
+        response = requests.get(f"{TEST_SERVER}/log/mark/log%20text%20test")
+        self.assertEqual(response.status_code, 200)
+
+        lines = response.text.splitlines()
+
+        # e.g. "0824 183500|on|1,3|5"
+        self.assertRegex(lines[-1], r"^\d{4} \d{6}\|mark\|log text test$")
+        self.assertTrue(any(re.match(r"^\d{4} \d{6}\|on\|1,3\|\d+$", line) for line in lines))
+
+        response = requests.get(f"{TEST_SERVER}/download/log.dat")
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(response.text.splitlines()[:len(lines)], lines)
+
+    def test_40_testing_apis_70_log_size(self):
+        """ The log is kept in segments within a fixed budget """
+        self.log_func_name(self.get_my_func_name())
+
+        size = self.invoke_api("/log/size", 0)
+
+        self.assertGreaterEqual(size["logSegments"], 1)
+        self.assertLessEqual(size["logSize"], size["logBudget"])
+
+    def test_40_testing_apis_80_log_query(self):
+        """ /log/query returns only the matching records, a page at a time """
+        self.log_func_name(self.get_my_func_name())
+
+        for label in ["query1", "query2", "query3"]:
+            requests.get(f"{TEST_SERVER}/log/mark/{label}")
+
+        result = self.invoke_api("/log/query?op=mark&since=-60&limit=2", 0)
+        self.assertEqual(len(result["records"]), 2)
+        self.assertIsNotNone(result["next"])
+
+        seqs = [seq for seq, _ in result["records"]]
+        self.assertEqual(seqs, sorted(seqs))
+
+        result = self.invoke_api(f"/log/query?op=mark&since=-60&from={result['next']}", 0)
+        self.assertTrue(result["records"][-1][1].endswith("|mark|query3"))
+        self.assertIsNone(result["next"])
+
+        self.invoke_zone_on(3)
+        self.invoke_zone_all_off()
+
+        result = self.invoke_api("/log/query?zone=3&since=-60", 0)
+        self.assertTrue(all("|on|" in line or "|off|" in line for _, line in result["records"]))
+        self.assertGreater(len(result["records"]), 0)
+
+    def test_40_testing_apis_90_log_query_segments(self):
+        """ /log/query skips the segments before since and from
+
+        The log is filled with long marks until it has at least three
+        segments.  Reading has to start at the later of the latest segment
+        that starts before since and the latest one that starts at or before
+        from, whichever of the two are given.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        label = "segments-" + "x" * 200
+        size = self.invoke_api("/log/size", 0)
+
+        while size["logSegments"] < 3:
+            for _ in range(10):
+                requests.get(f"{TEST_SERVER}/log/mark/{label}")
+            size = self.invoke_api("/log/size", 0)
+
+        first = size["firstSegment"]
+        starts = size["segmentStarts"]
+        last = max(i for i, (_, epoch) in enumerate(starts) if epoch != 0)
+
+        self.assertGreaterEqual(last, 1)
+
+        def expected(since: int = 0, from_seq: int = 0) -> int:
+            by_since = max([i for i, (_, epoch) in enumerate(starts) if 0 < epoch < since] + [0])
+            by_from = max([i for i, (seq, _) in enumerate(starts) if seq <= from_seq] + [0])
+            return first + max(by_since, by_from)
+
+        since = starts[last][1] + 1
+        from_seq = starts[last][0]
+
+        result = self.invoke_api(f"/log/query?since={since}&limit=1", 0)
+        self.assertEqual(first + last, result["segment"])
+        self.assertEqual(expected(since=since), result["segment"])
+
+        result = self.invoke_api(f"/log/query?from={from_seq}&limit=1", 0)
+        self.assertEqual(first + last, result["segment"])
+        self.assertEqual(from_seq, result["records"][0][0])
+
+        result = self.invoke_api(f"/log/query?since={since}&from={starts[1][0]}&limit=1", 0)
+        self.assertEqual(expected(since, starts[1][0]), result["segment"])
+
+        result = self.invoke_api(f"/log/query?since={starts[1][1]}&from={from_seq}&limit=1", 0)
+        self.assertEqual(first + last, result["segment"])
+
+        result = self.invoke_api("/log/query?limit=1", 0)
+        self.assertEqual(first, result["segment"])
+
     def test_50_cycles_10_api(self):
         """
         Test the important contents of the /cycles API
@@ -1071,6 +1393,63 @@ class SprinklerAPITests(TestBase):
 
         self.assertEqual(status["msg"], "not found: /cycle")
 
+    def test_50_cycles_90_clock_jump(self):
+        """
+        Make the clock jump over the starts of two cycles (as it does when
+        NTP only sets it after the starts were calculated) and ensure that
+        only the one that has only just passed starts.  The other one is
+        moved on to its next start rather than piling its schedule up.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        # the controller's clock is UTC plus its time zone offset, which
+        # /tz/{} sets (and which moves the clock)
+
+        response = requests.get(f"{TEST_SERVER}/now")
+        epoch = int(re.search(r"epoch=(\d+)", response.text).group(1))
+        tz = round((epoch - time()) / 60) * 60
+
+        # two cycles that start every day, on the minute, a few minutes apart
+
+        first = ((int(time()) + tz) // 60 + 3) * 60
+        second = first + 5 * 60
+        names = ["Jump 1", "Jump 2"]
+
+        for name, start in zip(names, (first, second)):
+            ci = {
+                "name": name,
+                "type": "specificDays",
+                "days": list(range(1, 8)),
+                "first": 1,
+                "hour": (start // 3600) % 24,
+                "min": (start // 60) % 60,
+                "count": 1,
+                "schedule": [[[1], 1]]
+            }
+            response = requests.post(f"{TEST_SERVER}/cycle", json=ci)
+            self.assertEqual(self.evaluate_api_response(response)["status"], "ok")
+
+        self.invoke_api("/calc", 0)
+
+        try:
+            # jump to just past the second start, 5 minutes past the first
+
+            self.invoke_api(f"/tz/{second + 5 - int(time())}", 0)
+            sleep(2)
+
+            status = self.invoke_status(0)
+            self.assertEqual(status["currCycle"], "Jump 2")
+            self.assertEqual(len(status["schedule"]), 1)
+            self.assertEqual(status["nextCycle"], "Jump 1")
+        finally:
+            self.invoke_api("/schd/cancel", 0)
+            self.invoke_api(f"/tz/{tz}", 0)
+
+            for name in names:
+                requests.delete(f"{TEST_SERVER}/cycle", json={"name": name})
+
+            self.invoke_api("/calc", 0)
+
     def test_60_seasonal_adjustment_10_basic(self):
         """Ensure basic operation of /adj API"""
         self.log_func_name(self.get_my_func_name())
@@ -1179,6 +1558,36 @@ class SprinklerAPITests(TestBase):
         self.assertEqual(result["status"], "error")
         self.assertEqual(result["msg"], "cycle not found")
 
+    def test_60_seasonal_adjustment_30_persisted(self):
+        """Ensure that Seasonal Adjustment is written with the cycles
+
+        /ser writes a new snapshot of the state, which now carries the
+        Seasonal Adjustment (and the toggle delay and schedule) along with
+        the cycles, and names the generation of the journal that follows it.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        orig_adj_result = self.invoke_api("/adj", 0)
+        new_adj = int(orig_adj_result["adj"]) + 9
+
+        self.invoke_api(f"/adj/{new_adj}", 0)
+        self.invoke_api("/ser", 0)
+
+        file_contents = requests.get(f"{TEST_SERVER}/download/cycles.json")
+        self.assertEqual(200, file_contents.status_code)
+
+        file_dict = json.loads(file_contents.text)
+
+        self.assertTrue("cycles" in file_dict)
+        self.assertEqual(new_adj, file_dict["adj"])
+        self.assertTrue("toggleDelay" in file_dict)
+        self.assertTrue("schedule" in file_dict)
+        self.assertTrue("journal" in file_dict)
+
+        # put adj back the way it was and write the snapshot again
+        self.invoke_api(f"/adj/{orig_adj_result['adj']}", 0)
+        self.invoke_api("/ser", 0)
+
     def test_70_system_hold_10_basic(self):
         """Test basic /hold API operation"""
         self.log_func_name(self.get_my_func_name())
@@ -1198,6 +1607,182 @@ class SprinklerAPITests(TestBase):
         """Advanced tests of /hold API to ensure cycles delay properly"""
         self.log_func_name(self.get_my_func_name())
 
+    @staticmethod
+    def journal_varint(value: int) -> bytes:
+        out = b""
+        while value >= 0x80:
+            out += bytes([(value & 0x7f) | 0x80])
+            value >>= 7
+        return out + bytes([value])
+
+    @classmethod
+    def journal_record(cls, op: int, payload: bytes) -> bytes:
+        """Encodes a record the way SprinklerJournal does it: the opcode, the
+        length as a varint, the payload and the check byte"""
+        check = op ^ (len(payload) & 0xff)
+
+        for b in payload:
+            check = (((check << 1) | (check >> 7)) & 0xff) ^ b
+
+        return bytes([op]) + cls.journal_varint(len(payload)) + payload + bytes([check])
+
+    def download(self, filename: str) -> bytes:
+        response = requests.get(f"{TEST_SERVER}/download/{filename}")
+        self.assertEqual(200, response.status_code)
+        return response.content
+
+    def upload(self, filename: str, content: bytes):
+        response = requests.post(f"{TEST_SERVER}/upload", files={"file": (filename, content)})
+        self.assertEqual(200, response.status_code)
+        sleep(1)
+
+    def test_80_journal_10_replay(self):
+        """Ensure that changes are journaled and replayed without /ser
+
+        Changes are appended to /journal.bin rather than written to
+        /cycles.json, so they have to survive a /deser (which restores the
+        state the same way as a restart does) through the journal alone.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        orig_adj_result = self.invoke_api("/adj", 0)
+        new_adj = int(orig_adj_result["adj"]) + 9
+
+        self.invoke_api("/ser", 0)
+        snapshot = self.download("cycles.json")
+        journal_size = len(self.download("journal.bin"))
+
+        ci = self.construct_a_random_fully_built_out_cycle()
+        ci["hour"], ci["min"] = 3, 7
+        response = requests.post(f"{TEST_SERVER}/cycle", json=ci)
+        self.evaluate_api_response(response)
+        self.invoke_api(f"/adj/{new_adj}", 0)
+
+        # the changes were appended, the snapshot left alone
+
+        sleep(1)
+        self.assertGreater(len(self.download("journal.bin")), journal_size)
+        self.assertEqual(snapshot, self.download("cycles.json"))
+
+        self.invoke_api("/deser", 0)
+
+        self.assertEqual(new_adj, int(self.invoke_api("/adj", 0)["adj"]))
+
+        response = requests.get(f"{TEST_SERVER}/cycle/{ci['name']}")
+        self.assertEqual(ci, json.loads(response.text))
+
+        response = requests.delete(f"{TEST_SERVER}/cycle", json={"name": ci["name"]})
+        self.evaluate_api_response(response)
+        self.invoke_api(f"/adj/{orig_adj_result['adj']}", 0)
+
+    def test_80_journal_20_damaged_tail(self):
+        """Ensure that a journal cut short is replayed up to the damage
+
+        The records that check are replayed, and since the journal can't be
+        appended to after the damage, the state is written as a new snapshot
+        (whose generation is one higher), which starts a new journal.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        orig_adj_result = self.invoke_api("/adj", 0)
+        new_adj = int(orig_adj_result["adj"]) + 9
+
+        self.invoke_api("/ser", 0)
+        generation = json.loads(self.download("cycles.json"))["journal"]
+
+        self.invoke_api(f"/adj/{new_adj}", 0)
+        sleep(1)
+
+        # a record of /adj/1 whose check byte never made it, then junk
+        torn = self.journal_record(6, bytes([1]))[:-1]
+        self.upload("journal.bin", self.download("journal.bin") + torn)
+
+        self.invoke_api("/deser", 0)
+
+        self.assertEqual(new_adj, int(self.invoke_api("/adj", 0)["adj"]))
+        self.assertEqual(generation + 1, json.loads(self.download("cycles.json"))["journal"])
+
+        # just the begin record of the new journal
+        journal = self.download("journal.bin")
+        self.assertEqual(1, journal[0])
+        self.assertEqual(len(self.journal_record(1, journal[2:2 + journal[1]])), len(journal))
+
+        self.invoke_api(f"/adj/{orig_adj_result['adj']}", 0)
+
+    def test_80_journal_30_foreign(self):
+        """Ensure that a journal is only replayed onto its own snapshot
+
+        The begin record names the generation and size of the snapshot that
+        the journal follows.  A journal that names another one is not
+        replayed, and the snapshot is taken as it is.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        orig_adj_result = self.invoke_api("/adj", 0)
+        new_adj = int(orig_adj_result["adj"]) + 9
+
+        self.invoke_api("/ser", 0)
+        snapshot = self.download("cycles.json")
+        generation = json.loads(snapshot)["journal"]
+
+        self.invoke_api(f"/adj/{new_adj}", 0)
+        sleep(1)
+
+        journal = self.download("journal.bin")
+        records = journal[len(self.journal_record(1, journal[2:2 + journal[1]])):]
+
+        for other_generation, other_size in ((generation + 5, len(snapshot)), (generation, len(snapshot) + 1)):
+            begin = self.journal_record(
+                1, self.journal_varint(other_generation) + self.journal_varint(other_size)
+            )
+            self.upload("journal.bin", begin + records)
+
+            self.invoke_api("/deser", 0)
+
+            self.assertEqual(orig_adj_result["adj"], self.invoke_api("/adj", 0)["adj"])
+            self.assertEqual(snapshot, self.download("cycles.json"))
+
+    def test_80_journal_40_compaction(self):
+        """Ensure that the journal is compacted once it grows too large
+
+        Replacing a cycle journals its deletion and the cycle, so doing it
+        often enough grows the journal past JOURNAL_COMPACT_SIZE (4096
+        bytes), at which point the state is written as a new snapshot and
+        the journal is started over.
+        """
+        self.log_func_name(self.get_my_func_name())
+
+        self.invoke_api("/ser", 0)
+        generation = json.loads(self.download("cycles.json"))["journal"]
+
+        ci = self.construct_a_random_fully_built_out_cycle()
+        ci["hour"], ci["min"] = 3, 7
+        compacted = False
+
+        for count in range(1, 201):
+            ci["count"] = count % 4 + 1
+            response = requests.post(f"{TEST_SERVER}/cycle", json=ci)
+            self.evaluate_api_response(response)
+
+            if count % 10 == 0 and json.loads(self.download("cycles.json"))["journal"] > generation:
+                compacted = True
+                break
+
+        self.assertTrue(compacted, "journal was never compacted")
+        self.assertLessEqual(len(self.download("journal.bin")), 4096)
+
+        # the last version of the cycle survives in the new snapshot and
+        # journal
+
+        sleep(1)
+        self.invoke_api("/deser", 0)
+
+        response = requests.get(f"{TEST_SERVER}/cycle/{ci['name']}")
+        self.assertEqual(ci, json.loads(response.text))
+
+        response = requests.delete(f"{TEST_SERVER}/cycle", json={"name": ci["name"]})
+        self.evaluate_api_response(response)
+
     def test_99_end(self):
         self.log_func_name(">>>>> SprinklerAPITests: end <<<<<")
 
@@ -0,0 +1,245 @@
+"""
+NAME - build_ui.py
+
+DESCRIPTION
+
+    Prepares the UI files in "data" for the board:  each one is minified
+    (comments, indentation and blank lines are removed) and gzipped (the
+    board sends gzipped files with "Content-Encoding: gzip"), and the
+    reference to sprinklers.js in index.html is fingerprinted with the ETag
+    the board gives its gzipped contents (/sprinklers.js?v=<ETag>).
+
+    Since that URL changes whenever sprinklers.js does, the board lets the
+    browser cache it for good (as long as the sprinklers.js it has is the
+    one the URL names).  index.html itself is checked with the board on
+    every load, which costs a "304 Not Modified" when it hasn't changed.
+
+    The files are written to out_dir for uploading, along with ui.ver, the
+    version of the UI:  the time of the last commit of the files in "data"
+    if they are as committed, otherwise the time of the build (their mtimes
+    won't do, since a checkout or a copy can set them to anything).  If a
+    header is named, the same files are also written into
+    it as one bundle for the firmware to serve from PROGMEM (see
+    embed_ui.py, which PlatformIO runs before every build).  The board
+    serves the files uploaded to LittleFS instead of its own only if their
+    ui.ver is newer.
+
+USAGE
+
+    python build_ui.py [out_dir [header]]
+
+OPTIONS
+
+    out_dir - (optional) where the gzipped files are written
+
+        - default value: build/ui
+
+    header - (optional) the C++ header to write the bundle into
+
+NOTES
+
+    - "make upload-ui" runs this and then uploads the results
+    - the gzipped files only depend on their contents (the gzip timestamp
+      is always 0), so the ETags the board derives from them only change
+      when the files do
+    - the minifying is line by line and only takes out what can't matter
+      (a line is never joined to the next one), so it doesn't need to
+      understand the JavaScript
+"""
+
+# Copyright 2025 David Main
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import gzip
+import hashlib
+import os
+import re
+import subprocess
+import sys
+import time
+
+DATA_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "data")
+SCRIPT_REF = 'src="/sprinklers.js"'
+
+
+def fingerprint(content: bytes) -> str:
+    return hashlib.sha256(content).hexdigest()[:12]
+
+
+def etag(content: bytes) -> str:
+    """
+    Returns the ETag (without its quotes) the board gives a file with the
+    contents:  FNV-1a, as in SprinklerWebServer::fileTag().
+    """
+    h = 2166136261
+
+    for b in content:
+        h = ((h ^ b) * 16777619) & 0xffffffff
+
+    return f"{h:08x}"
+
+
+def ui_version(names: list) -> int:
+    """
+    Returns the version of the UI made from the named files in "data" (see
+    above).
+    """
+    paths = [os.path.join(DATA_DIR, n) for n in names]
+
+    def git(*args) -> str:
+        return subprocess.run(
+            ["git", *args, "--", *paths],
+            cwd=DATA_DIR, capture_output=True, text=True, check=True
+        ).stdout.strip()
+
+    try:
+        if not git("status", "--porcelain"):
+            return int(git("log", "-1", "--format=%ct"))
+    except (OSError, subprocess.CalledProcessError, ValueError):
+        pass
+
+    return int(time.time())
+
+
+def minify_js(text: str) -> str:
+    lines = []
+    in_comment = False
+
+    # only comments that begin a line are taken out (whatever follows the
+    # end of a /* */ comment is kept)
+
+    for line in text.splitlines():
+        line = line.strip()
+
+        if in_comment:
+            if "*/" in line:
+                in_comment = False
+                lines.append(line[line.index("*/") + 2:].strip())
+            continue
+
+        if line.startswith("/*"):
+            end = line.find("*/", 2)
+
+            if end < 0:
+                in_comment = True
+            else:
+                lines.append(line[end + 2:].strip())
+            continue
+
+        if not line.startswith("//"):
+            lines.append(line)
+
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+def minify_html(text: str) -> str:
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.DOTALL)
+    return "\n".join(line.strip() for line in text.splitlines() if line.strip()) + "\n"
+
+
+def build(out_dir: str = None):
+    """
+    Returns [(url, content type, gzipped contents)] for the UI files and the
+    version of the UI, writing the files to out_dir if it is given.
+    """
+    names = ["index.html", "sprinklers.js"]
+    version = ui_version(names)
+
+    with open(os.path.join(DATA_DIR, "sprinklers.js"), "r", encoding="utf-8") as f:
+        js_gz = gzip.compress(minify_js(f.read()).encode("utf-8"), compresslevel=9, mtime=0)
+
+    with open(os.path.join(DATA_DIR, "index.html"), "r", encoding="utf-8") as f:
+        html = f.read()
+
+    if SCRIPT_REF not in html:
+        sys.exit(f"index.html no longer contains {SCRIPT_REF}")
+
+    html = minify_html(
+        html.replace(SCRIPT_REF, f'src="/sprinklers.js?v={etag(js_gz)}"')
+    ).encode("utf-8")
+
+    files = [
+        ("/index.html", "text/html", gzip.compress(html, compresslevel=9, mtime=0)),
+        ("/sprinklers.js", "application/javascript", js_gz),
+    ]
+
+    if out_dir:
+        os.makedirs(out_dir, exist_ok=True)
+
+        for url, _, content in files:
+            with open(os.path.join(out_dir, url[1:] + ".gz"), "wb") as f:
+                f.write(content)
+            print(f"{url}: {len(content)} bytes gzipped")
+
+        with open(os.path.join(out_dir, "ui.ver"), "w") as f:
+            f.write(f"{version}\n")
+
+    return files, version
+
+
+def write_header(path: str, files: list, version: int):
+    """
+    Writes the files into the header as one PROGMEM array (uiBundle) and a
+    table of where each file is in it (uiBundleFiles).  The header is only
+    rewritten when the bundle would change, so that it doesn't cause a
+    rebuild (a build time for the version alone doesn't count).
+    """
+    bundle = b"".join(content for _, _, content in files)
+    out = [
+        "// generated by src/python/build_ui.py from data/ -- do not edit",
+        "",
+        "#pragma once",
+        "",
+        f"#define UI_BUNDLE_VERSION {version}UL",
+        f"#define UI_BUNDLE_FINGERPRINT \"{fingerprint(bundle)}\"",
+        "",
+        f"static const uint8_t uiBundle[{len(bundle)}] PROGMEM = {{",
+    ]
+
+    for i in range(0, len(bundle), 16):
+        out.append("    " + ", ".join(f"0x{b:02x}" for b in bundle[i:i + 16]) + ",")
+
+    out += ["};", "", "static const UiBundleFile_t uiBundleFiles[] = {"]
+    offset = 0
+
+    for url, content_type, content in files:
+        out.append(
+            f"    {{\"{url}\", \"{content_type}\", {offset}, {len(content)}, "
+            f"\"\\\"{etag(content)}\\\"\"}},"
+        )
+        offset += len(content)
+
+    out += ["};", ""]
+    text = "\n".join(out)
+
+    def bundle_of(header: str) -> str:
+        return re.sub(r"#define UI_BUNDLE_VERSION .*", "", header)
+
+    if os.path.exists(path):
+        with open(path, "r") as f:
+            if bundle_of(f.read()) == bundle_of(text):
+                return
+
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+
+    with open(path, "w") as f:
+        f.write(text)
+
+
+if __name__ == '__main__':
+    out_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.join("build", "ui")
+    files, version = build(out_dir)
+
+    if len(sys.argv) > 2:
+        write_header(sys.argv[2], files, version)
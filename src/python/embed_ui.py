@@ -0,0 +1,40 @@
+"""
+NAME - embed_ui.py
+
+DESCRIPTION
+
+    PlatformIO "extra script" (see platformio.ini) that builds the UI files
+    in "data" into the header UiBundle.h in the build directory before the
+    firmware is compiled, so that the firmware can serve the UI without the
+    filesystem (see build_ui.py and SprinklerAPI::handleUiFile()).
+"""
+
+# Copyright 2025 David Main
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+import sys
+
+Import("env")
+
+# __file__ isn't defined for extra scripts
+sys.path.insert(0, os.path.join(env.subst("$PROJECT_DIR"), "src", "python"))
+
+import build_ui
+
+include_dir = os.path.join(env.subst("$BUILD_DIR"), "ui")
+files, version = build_ui.build()
+
+build_ui.write_header(os.path.join(include_dir, "UiBundle.h"), files, version)
+env.Append(CPPPATH=[include_dir])
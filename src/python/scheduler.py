@@ -41,6 +41,30 @@ class ApiInvoker:
 
         return result.text
 
+    def wait_for_status(self, since=None, timeout=30):
+        """
+        Waits (up to timeout seconds) for the state to change from the version
+        since and returns the new version and status, or None if nothing
+        changed.  Without since, it returns the current ones right away.
+        """
+        url = f"/status/wait?timeout={timeout}"
+
+        if since is not None:
+            url += f"&since={since}"
+
+        full_url = f"http://{self.host_ip or self.host}{url}"
+        result = requests.get(full_url, timeout=timeout + 10)
+
+        if result.status_code == 304:
+            return None
+
+        status = json.loads(result.text)
+
+        if status["status"] != "ok":
+            raise Exception(f"status: {result.text}")
+
+        return status["version"], status["state"]
+
     def turn_zone_on(self, zone):
         if self.host_ip is None:
             self.get_status()